@@ -39,12 +39,14 @@ set(APP_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/importpositiondialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/layeropacitydialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/mainwindow2.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/app/src/memoryusagedialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/onionskinwidget.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/pegbaralignmentdialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/pencil2d.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/predefinedsetmodel.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/preferencesdialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/presetdialog.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/app/src/renderstatsdock.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/repositionframesdialog.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/shortcutfilter.h
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/shortcutspage.h
@@ -98,12 +100,14 @@ set(APP_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/layeropacitydialog.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/main.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/mainwindow2.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/app/src/memoryusagedialog.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/onionskinwidget.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/pegbaralignmentdialog.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/pencil2d.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/predefinedsetmodel.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/preferencesdialog.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/presetdialog.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/app/src/renderstatsdock.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/repositionframesdialog.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/shortcutfilter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/app/src/shortcutspage.cpp
@@ -123,6 +123,8 @@ HEADERS += \
     src/doubleprogressdialog.h \
     src/colorslider.h \
     src/checkupdatesdialog.h \
+    src/memoryusagedialog.h \
+    src/renderstatsdock.h \
     src/presetdialog.h \
     src/repositionframesdialog.h \
     src/commandlineparser.h \
@@ -180,6 +182,8 @@ SOURCES += \
     src/doubleprogressdialog.cpp \
     src/colorslider.cpp \
     src/checkupdatesdialog.cpp \
+    src/memoryusagedialog.cpp \
+    src/renderstatsdock.cpp \
     src/presetdialog.cpp \
     src/repositionframesdialog.cpp \
     src/app_util.cpp \
@@ -37,6 +37,7 @@ GNU General Public License for more details.
 #include "selectionmanager.h"
 #include "util.h"
 #include "app_util.h"
+#include "tracer.h"
 
 #include "layercamera.h"
 #include "layersound.h"
@@ -54,6 +55,7 @@ GNU General Public License for more details.
 #include "exportmoviedialog.h"
 #include "exportimagedialog.h"
 #include "aboutdialog.h"
+#include "memoryusagedialog.h"
 #include "doubleprogressdialog.h"
 #include "checkupdatesdialog.h"
 #include "errordialog.h"
@@ -1043,6 +1045,33 @@ void ActionCommands::openTemporaryDirectory()
     }
 }
 
+void ActionCommands::memoryUsage()
+{
+    MemoryUsageDialog* dialog = new MemoryUsageDialog(mEditor, mParent);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void ActionCommands::saveTrace()
+{
+    if (!Tracer::instance().isEnabled())
+    {
+        // Nothing is recorded until asked for, so the first use starts the recording
+        Tracer::instance().setEnabled(true);
+        QMessageBox::information(mParent, tr("Save Performance Trace"),
+                                 tr("Recording a performance trace from now on. Repeat what was slow, then save the trace again."));
+        return;
+    }
+
+    QString filePath = QFileDialog::getSaveFileName(mParent, tr("Save Performance Trace"), "pencil2d-trace.json", tr("JSON files (*.json)"));
+    if (filePath.isEmpty()) { return; }
+
+    if (!Tracer::instance().save(filePath))
+    {
+        QMessageBox::warning(mParent, tr("Warning"), tr("Unable to write %1").arg(filePath));
+    }
+}
+
 void ActionCommands::about()
 {
     AboutDialog* aboutBox = new AboutDialog(mParent);
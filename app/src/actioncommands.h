@@ -99,6 +99,8 @@ public:
     void reportbug();
     void checkForUpdates();
     void openTemporaryDirectory();
+    void memoryUsage();
+    void saveTrace();
     void about();
 
 private:
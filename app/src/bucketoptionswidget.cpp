@@ -115,6 +115,10 @@ void BucketOptionsWidget::updateUI()
     if (mBucketTool->isPropertyEnabled(BucketToolProperties::COLORTOLERANCE_ENABLED)) {
         mBucketTool->setColorToleranceEnabled(properties.colorToleranceEnabled());
     }
+
+    if (mBucketTool->isPropertyEnabled(BucketToolProperties::FILLSELECTEDFRAMES_ENABLED)) {
+        mBucketTool->setFillSelectedFramesEnabled(properties.fillSelectedFramesEnabled());
+    }
 }
 
 void BucketOptionsWidget::makeConnectionsFromModelToUI()
@@ -143,6 +147,10 @@ void BucketOptionsWidget::makeConnectionsFromModelToUI()
        setFillMode(value);
     });
 
+    connect(mBucketTool, &BucketTool::fillSelectedFramesEnabledChanged, this, [=](bool enabled) {
+       setFillSelectedFramesEnabled(enabled);
+    });
+
     connect(mBucketTool, &BucketTool::strokeThicknessChanged, this, [=](qreal value) {
        setStrokeWidth(value);
     });
@@ -181,6 +189,10 @@ void BucketOptionsWidget::makeConnectionsFromUIToModel()
         mBucketTool->setFillMode(value);
     });
 
+    connect(ui->fillSelectedFramesCheckbox, &QCheckBox::toggled, [=](bool enabled) {
+        mBucketTool->setFillSelectedFramesEnabled(enabled);
+    });
+
     connect(ui->strokeThicknessSlider, &SpinSlider::valueChanged, [=](qreal value) {
         mBucketTool->setStrokeThickness(value);
     });
@@ -204,6 +216,7 @@ void BucketOptionsWidget::updatePropertyVisibility()
     ui->referenceLayerDescLabel->setVisible(mBucketTool->isPropertyEnabled(BucketToolProperties::FILLLAYERREFERENCEMODE_VALUE));
     ui->blendModeComboBox->setVisible(mBucketTool->isPropertyEnabled(BucketToolProperties::FILLMODE_VALUE));
     ui->blendModeLabel->setVisible(mBucketTool->isPropertyEnabled(BucketToolProperties::FILLMODE_VALUE));
+    ui->fillSelectedFramesCheckbox->setVisible(mBucketTool->isPropertyEnabled(BucketToolProperties::FILLSELECTEDFRAMES_ENABLED));
 }
 
 void BucketOptionsWidget::onLayerChanged(int)
@@ -247,6 +260,12 @@ void BucketOptionsWidget::setFillExpand(int value)
     ui->expandSpinBox->setValue(value);
 }
 
+void BucketOptionsWidget::setFillSelectedFramesEnabled(bool enabled)
+{
+    QSignalBlocker b(ui->fillSelectedFramesCheckbox);
+    ui->fillSelectedFramesCheckbox->setChecked(enabled);
+}
+
 void BucketOptionsWidget::setFillReferenceMode(int referenceMode)
 {
     QSignalBlocker b(ui->referenceLayerComboBox);
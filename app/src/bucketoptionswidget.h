@@ -49,6 +49,7 @@ public:
     void setColorTolerance(int tolerance);
     void setFillReferenceMode(int referenceMode);
     void setFillMode(int mode);
+    void setFillSelectedFramesEnabled(bool enabled);
     void onLayerChanged(int);
 
 private:
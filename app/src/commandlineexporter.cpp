@@ -15,17 +15,24 @@ GNU General Public License for more details.
 
 */
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QTextStream>
 
 #include "editor.h"
 #include "fileformat.h"
 #include "layercamera.h"
 #include "layermanager.h"
-#include "mainwindow2.h"
 #include "movieexporter.h"
 #include "object.h"
 #include "playbackmanager.h"
+#include "renderchunks.h"
 
 #include "commandlineexporter.h"
 
@@ -35,12 +42,35 @@ const auto qEndl = Qt::endl;
 const auto qEndl = endl;
 #endif
 
-CommandLineExporter::CommandLineExporter(Editor *editor) :
-    mEditor(editor),
+namespace
+{
+    QString fileChecksum(const QString& fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) { return QString(); }
+
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(&file);
+        return QString::fromLatin1(hash.result().toHex());
+    }
+
+    QJsonObject chunkToJson(int index, const RenderChunk& chunk)
+    {
+        QJsonObject json;
+        json["index"] = index;
+        json["start_frame"] = chunk.startFrame;
+        json["end_frame"] = chunk.endFrame;
+        return json;
+    }
+}
+
+CommandLineExporter::CommandLineExporter(QObject *parent) :
+    QObject(parent),
+    mEditor(new Editor(this)),
     mOut(stdout, QIODevice::WriteOnly),
     mErr(stderr, QIODevice::WriteOnly)
 {
-
+    mEditor->init();
 }
 
 bool CommandLineExporter::process(const QString &inputPath,
@@ -50,7 +80,8 @@ bool CommandLineExporter::process(const QString &inputPath,
                                   int height,
                                   int startFrame,
                                   int endFrame,
-                                  bool transparency)
+                                  bool transparency,
+                                  const ExportChunkOptions &chunk)
 {
     LayerManager *layerManager = mEditor->layers();
 
@@ -100,6 +131,50 @@ bool CommandLineExporter::process(const QString &inputPath,
         endFrame = layerManager->animationLength(endFrame < -1);
     }
 
+    QJsonObject manifest;
+    manifest["project"] = QFileInfo(inputPath).absoluteFilePath();
+    manifest["camera"] = cameraLayer->name();
+    manifest["width"] = exportSize.width();
+    manifest["height"] = exportSize.height();
+    manifest["fps"] = mEditor->playback()->fps();
+    manifest["start_frame"] = startFrame;
+    manifest["end_frame"] = endFrame;
+
+    const bool chunked = chunk.count > 1;
+    if (chunked)
+    {
+        const QList<RenderChunk> chunks = chunk.byCost
+            ? RenderChunks::splitByCost(startFrame,
+                                        RenderChunks::estimateCosts(mEditor->object(), cameraLayer, startFrame, endFrame),
+                                        chunk.count)
+            : RenderChunks::splitByCount(startFrame, endFrame, chunk.count);
+
+        QJsonArray chunksJson;
+        for (int i = 0; i < chunks.size(); i++)
+        {
+            chunksJson.append(chunkToJson(i + 1, chunks[i]));
+        }
+        manifest["chunk_mode"] = chunk.byCost ? "cost" : "count";
+        manifest["chunks"] = chunksJson;
+        manifest["chunk_index"] = chunk.index;
+
+        if (chunk.index > chunks.size())
+        {
+            // Short ranges have fewer chunks than asked for, the surplus ones have nothing to do
+            mErr << tr("Warning: chunk %1 is empty, the frame range only has %2 frames.").arg(chunk.index).arg(chunks.size()) << qEndl;
+            manifest["outputs"] = QJsonArray();
+            manifest["ok"] = true;
+            return chunk.manifestPath.isEmpty() || writeManifest(chunk.manifestPath, manifest);
+        }
+        startFrame = chunks[chunk.index - 1].startFrame;
+        endFrame = chunks[chunk.index - 1].endFrame;
+        mOut << tr("Rendering chunk %1 of %2, frames %3 to %4", "Command line task progress")
+                .arg(chunk.index).arg(chunks.size()).arg(startFrame).arg(endFrame) << qEndl;
+    }
+
+    bool ok = true;
+    QJsonArray outputsJson;
+
     Q_ASSERT(!outputPaths.empty());
     for (const QString& outputPath : outputPaths)
     {
@@ -113,14 +188,44 @@ bool CommandLineExporter::process(const QString &inputPath,
 
         if (isMovieFormat(format))
         {
+            if (chunked)
+            {
+                // A movie can't be put back together from chunks, render an image sequence and encode that instead
+                mErr << tr("Error: %1 is a movie, chunked exports only support image sequences.", "Command line error").arg(outputPath) << qEndl;
+                ok = false;
+                continue;
+            }
             exportMovie(outputPath, cameraLayer, exportSize, startFrame, endFrame, transparency);
             continue;
         }
 
-        exportImageSequence(outputPath, format, cameraLayer, exportSize, startFrame, endFrame, transparency);
+        QElapsedTimer timer;
+        timer.start();
+
+        QJsonArray framesJson;
+        const bool exported = exportImageSequence(outputPath, format, cameraLayer, exportSize, startFrame, endFrame, transparency,
+                                                  chunk.manifestPath.isEmpty() ? nullptr : &framesJson);
+        ok = ok && exported;
+
+        QJsonObject outputJson;
+        outputJson["path"] = QFileInfo(outputPath).absoluteFilePath();
+        outputJson["format"] = format;
+        outputJson["start_frame"] = startFrame;
+        outputJson["end_frame"] = endFrame;
+        outputJson["frames"] = framesJson;
+        outputJson["msec"] = timer.elapsed();
+        outputJson["ok"] = exported;
+        outputsJson.append(outputJson);
     }
 
-    return true;
+    if (!chunk.manifestPath.isEmpty())
+    {
+        manifest["outputs"] = outputsJson;
+        manifest["ok"] = ok;
+        ok = writeManifest(chunk.manifestPath, manifest) && ok;
+    }
+
+    return ok;
 }
 
 void CommandLineExporter::exportMovie(const QString &outputPath,
@@ -150,26 +255,68 @@ void CommandLineExporter::exportMovie(const QString &outputPath,
     mOut << tr("Done.", "Command line task done") << qEndl;
 }
 
-void CommandLineExporter::exportImageSequence(const QString &outputPath,
+bool CommandLineExporter::exportImageSequence(const QString &outputPath,
                                               const QString &format,
                                               const LayerCamera *cameraLayer,
                                               const QSize &exportSize,
                                               int startFrame,
                                               int endFrame,
-                                              bool transparency)
+                                              bool transparency,
+                                              QJsonArray *manifestFrames)
 {
     mOut << tr("Exporting image sequence...", "Command line task progress") << qEndl;
-    mEditor->object()->exportFrames(startFrame,
-                                    endFrame,
-                                    cameraLayer,
-                                    exportSize,
-                                    outputPath,
-                                    format,
-                                    transparency,
-                                    false,
-                                    "",
-                                    true,
-                                    nullptr,
-                                    0);
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    auto frameExported = [manifestFrames, &frameTimer](int frame, const QString &fileName)
+    {
+        if (manifestFrames == nullptr) { return; }
+
+        QJsonObject frameJson;
+        frameJson["frame"] = frame;
+        frameJson["file"] = QFileInfo(fileName).fileName();
+        frameJson["msec"] = frameTimer.elapsed();
+        frameJson["size"] = QFileInfo(fileName).size();
+        frameJson["sha256"] = fileChecksum(fileName);
+        manifestFrames->append(frameJson);
+
+        // Checksums are not part of the frame time
+        frameTimer.restart();
+    };
+
+    Status st = mEditor->object()->exportFrames(startFrame,
+                                                endFrame,
+                                                cameraLayer,
+                                                exportSize,
+                                                outputPath,
+                                                format,
+                                                transparency,
+                                                false,
+                                                "",
+                                                true,
+                                                nullptr,
+                                                0,
+                                                frameExported);
+    if (!st.ok())
+    {
+        mErr << st.details().str() << qEndl;
+        return false;
+    }
     mOut << tr("Done.", "Command line task done") << qEndl;
+    return true;
+}
+
+bool CommandLineExporter::writeManifest(const QString &manifestPath, const QJsonObject &manifest)
+{
+    QJsonObject json = manifest;
+    json["created"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+
+    QFile file(manifestPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QJsonDocument(json).toJson()) < 0)
+    {
+        mErr << tr("Error: could not write the manifest to %1", "Command line error").arg(manifestPath) << qEndl;
+        return false;
+    }
+    return true;
 }
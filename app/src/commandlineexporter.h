@@ -22,6 +22,20 @@ GNU General Public License for more details.
 
 class Editor;
 class LayerCamera;
+class QJsonArray;
+class QJsonObject;
+
+/**
+ * Restricts an export to one chunk of the frame range,
+ * so that separate processes can render the chunks of one project.
+ */
+struct ExportChunkOptions
+{
+    int count = 1; ///< Number of chunks the frame range is split into
+    int index = 1; ///< The chunk to render, from 1 to count
+    bool byCost = false; ///< Split by estimated render cost instead of frame count
+    QString manifestPath; ///< Where to write the JSON manifest, or empty for none
+};
 
 /**
  * Handles command line export jobs
@@ -32,11 +46,12 @@ class CommandLineExporter : QObject
 
 public:
     /**
-     * Creates a new exporter instance.
+     * Creates a new exporter instance along with its own Editor.
      *
-     * @param editor The Editor instance to be used by the exporter
+     * The editor is set up without a main window or canvas, so exporting
+     * does not depend on any widgets being created.
      */
-    explicit CommandLineExporter(Editor *editor);
+    explicit CommandLineExporter(QObject *parent = nullptr);
 
     /**
      * Exports a Pencil2D file according to the specified options.
@@ -50,6 +65,7 @@ public:
      * @param endFrame Last frame to include in the export(s) or -1 to use the last keyframe or -2 to use the last
      *                 keyframe including sound clips
      * @param transparency Whether to export with transparency
+     * @param chunk The part of the frame range to export and where to describe the result
      * @return `true` if the export was successful
      */
     bool process(const QString &inputPath,
@@ -59,7 +75,8 @@ public:
                  int height,
                  int startFrame,
                  int endFrame,
-                 bool transparency);
+                 bool transparency,
+                 const ExportChunkOptions &chunk = ExportChunkOptions());
 
 private:
     Editor *mEditor;
@@ -71,13 +88,15 @@ private:
                      int startFrame,
                      int endFrame,
                      bool transparency);
-    void exportImageSequence(const QString &outputPath,
+    bool exportImageSequence(const QString &outputPath,
                              const QString &format,
                              const LayerCamera *cameraLayer,
                              const QSize &exportSize,
                              int startFrame,
                              int endFrame,
-                             bool transparency);
+                             bool transparency,
+                             QJsonArray *manifestFrames);
+    bool writeManifest(const QString &manifestPath, const QJsonObject &manifest);
 };
 
 #endif // COMMANDLINEEXPORTER_H
@@ -77,9 +77,37 @@ CommandLineParser::CommandLineParser() : mParser(), mInputPath(), mOutputPaths()
     QCommandLineOption transparencyOption(QStringList() << "transparency",
                                           tr("Render transparency when possible"));
     mParser.addOption(transparencyOption);
+
+    QCommandLineOption chunksOption(QStringList() << "chunks",
+                                    tr("Split the frame range into <count> chunks and only render one of them, "
+                                       "so that several processes can share an export"),
+                                    tr("count"));
+    mParser.addOption(chunksOption);
+
+    QCommandLineOption chunkOption(QStringList() << "chunk",
+                                   tr("The chunk to render, from 1 to the chunk count"),
+                                   tr("index"));
+    mParser.addOption(chunkOption);
+
+    QCommandLineOption chunkByOption(QStringList() << "chunk-by",
+                                     tr("How to split the frame range: count for chunks with the same number of frames "
+                                        "or cost for chunks that take about as long to render"),
+                                     tr("mode"));
+    mParser.addOption(chunkByOption);
+
+    QCommandLineOption manifestOption(QStringList() << "manifest",
+                                      tr("Write a JSON manifest of the rendered frames and files to <manifest_path>"),
+                                      tr("manifest_path"));
+    mParser.addOption(manifestOption);
+
+    QCommandLineOption traceOption(QStringList() << "trace",
+                                   tr("Write a trace of the time spent loading and exporting to <trace_path>, "
+                                      "in the Chrome trace event format"),
+                                   tr("trace_path"));
+    mParser.addOption(traceOption);
 }
 
-void CommandLineParser::process(QStringList arguments)
+bool CommandLineParser::process(QStringList arguments)
 {
     QTextStream out(stdout);
     QTextStream err(stderr);
@@ -164,4 +192,64 @@ void CommandLineParser::process(QStringList arguments)
     mTransparency = mParser.isSet("transparency");
 
     mCamera = mParser.value("camera");
+
+    // Rendering the wrong chunk would silently duplicate or drop frames of a distributed export,
+    // so mistakes in the chunk options stop the export instead of falling back
+    if (!mParser.value("chunks").isEmpty())
+    {
+        bool ok = false;
+        mChunkCount = mParser.value("chunks").toInt(&ok);
+        if (!ok || mChunkCount < 1)
+        {
+            err << tr("Error: chunks value %1 is not a positive integer.").arg(mParser.value("chunks")) << qEndl;
+            return false;
+        }
+    }
+
+    if (!mParser.value("chunk").isEmpty())
+    {
+        bool ok = false;
+        mChunkIndex = mParser.value("chunk").toInt(&ok);
+        if (!ok || mChunkIndex < 1 || mChunkIndex > mChunkCount)
+        {
+            err << tr("Error: chunk value %1 is not between 1 and %2.").arg(mParser.value("chunk")).arg(mChunkCount) << qEndl;
+            return false;
+        }
+    }
+    else if (mChunkCount > 1)
+    {
+        err << tr("Error: chunks is %1 but no chunk to render was given.").arg(mChunkCount) << qEndl;
+        return false;
+    }
+
+    if (!mParser.value("chunk-by").isEmpty())
+    {
+        if (mParser.value("chunk-by") == "cost")
+        {
+            mChunkByCost = true;
+        }
+        else if (mParser.value("chunk-by") != "count")
+        {
+            err << tr("Warning: chunk-by value %1 is not count or cost, using count.").arg(mParser.value("chunk-by")) << qEndl;
+        }
+    }
+
+    mManifestPath = mParser.value("manifest");
+    mTracePath = mParser.value("trace");
+    return true;
+}
+
+bool CommandLineParser::hasExportOption(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        // Only the option names themselves, so a file such as -old.pclx isn't taken for an export,
+        // though long options may carry their value as --export=<path>
+        const QString name = QString::fromLocal8Bit(argv[i]).section('=', 0, 0);
+        if (name == "-o" || name == "--export" || name == "--export-sequence")
+        {
+            return true;
+        }
+    }
+    return false;
 }
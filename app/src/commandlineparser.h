@@ -27,7 +27,14 @@ class CommandLineParser : QObject
 public:
     explicit CommandLineParser();
 
-    void process(QStringList arguments);
+    /** Parses @p arguments, returning false when they can't be used. */
+    bool process(QStringList arguments);
+
+    /**
+     * Checks whether the raw arguments ask for an export, before any
+     * application object exists to parse them properly.
+     */
+    static bool hasExportOption(int argc, char* argv[]);
 
     QString inputPath() const { return mInputPath; }
     QStringList outputPaths() const { return mOutputPaths; }
@@ -37,6 +44,11 @@ public:
     int startFrame() const { return mStartFrame; }
     int endFrame() const { return mEndFrame; }
     bool transparency() const { return mTransparency; }
+    int chunkCount() const { return mChunkCount; }
+    int chunkIndex() const { return mChunkIndex; }
+    bool chunkByCost() const { return mChunkByCost; }
+    QString manifestPath() const { return mManifestPath; }
+    QString tracePath() const { return mTracePath; }
 
 private:
     QCommandLineParser mParser;
@@ -49,6 +61,11 @@ private:
     int mStartFrame = 1;
     int mEndFrame = -1;
     bool mTransparency = false;
+    int mChunkCount = 1;
+    int mChunkIndex = 1;
+    bool mChunkByCost = false;
+    QString mManifestPath;
+    QString mTracePath;
 };
 
 #endif // COMMANDLINEPARSER_H
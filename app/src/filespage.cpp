@@ -47,6 +47,8 @@ FilesPage::FilesPage()
     connect(ui->autosaveNumberBox, spinBoxValueChange, this, &FilesPage::autoSaveNumberChange);
     connect(ui->autosaveByTimeCheckBox, &QCheckBox::stateChanged, this, &FilesPage::autoSaveByTimeChange);
     connect(ui->autosaveByTimeNumberBox, spinBoxValueChange, this, &FilesPage::autoSaveByTimeTimerChange);
+    connect(ui->binaryVectorCheckBox, &QCheckBox::stateChanged, this, &FilesPage::binaryVectorKeyFramesChange);
+    connect(ui->fastBitmapCheckBox, &QCheckBox::stateChanged, this, &FilesPage::fastBitmapKeyFramesChange);
 }
 
 FilesPage::~FilesPage()
@@ -213,6 +215,8 @@ void FilesPage::updateValues()
     ui->autosaveNumberBox->setValue(mManager->getInt(SETTING::AUTO_SAVE_NUMBER));
     ui->autosaveByTimeCheckBox->setChecked(mManager->isOn(SETTING::AUTO_SAVE_BY_TIME));
     ui->autosaveByTimeNumberBox->setValue(mManager->getInt(SETTING::AUTO_SAVE_BY_TIME_TIMER));
+    ui->binaryVectorCheckBox->setChecked(mManager->isOn(SETTING::BINARY_VECTOR_KEYFRAMES));
+    ui->fastBitmapCheckBox->setChecked(mManager->isOn(SETTING::FAST_BITMAP_KEYFRAMES));
     ui->askPresetRbtn->setChecked(mManager->isOn(SETTING::ASK_FOR_PRESET));
     ui->loadDefaultPresetRbtn->setChecked(mManager->isOn(SETTING::LOAD_DEFAULT_PRESET));
     ui->loadLastActiveRbtn->setChecked(mManager->isOn(SETTING::LOAD_MOST_RECENT));
@@ -252,3 +256,13 @@ void FilesPage::autoSaveByTimeTimerChange(int number)
 {
     mManager->set(SETTING::AUTO_SAVE_BY_TIME_TIMER, number);
 }
+
+void FilesPage::binaryVectorKeyFramesChange(int b)
+{
+    mManager->set(SETTING::BINARY_VECTOR_KEYFRAMES, b != Qt::Unchecked);
+}
+
+void FilesPage::fastBitmapKeyFramesChange(int b)
+{
+    mManager->set(SETTING::FAST_BITMAP_KEYFRAMES, b != Qt::Unchecked);
+}
@@ -52,6 +52,8 @@ public slots:
     void autoSaveNumberChange(int number);
     void autoSaveByTimeChange(int b);
     void autoSaveByTimeTimerChange(int number);
+    void binaryVectorKeyFramesChange(int b);
+    void fastBitmapKeyFramesChange(int b);
 
 signals:
     void clearRecentList();
@@ -124,6 +124,7 @@ GeneralPage::GeneralPage() : ui(new Ui::GeneralPage)
     connect(ui->safeHelperTextCheckbox, &QCheckBox::stateChanged, this, &GeneralPage::SafeAreaHelperTextCheckBoxStateChanged);
     connect(ui->gridCheckBox, &QCheckBox::stateChanged, this, &GeneralPage::gridCheckBoxStateChanged);
     connect(ui->framePoolSizeSpin, spinValueChanged, this, &GeneralPage::frameCacheNumberChanged);
+    connect(ui->framePreloadSpin, spinValueChanged, this, &GeneralPage::framePreloadCountChanged);
     connect(ui->invertScrollDirectionBox, &QCheckBox::stateChanged, this, &GeneralPage::invertScrollDirectionBoxStateChanged);
     connect(ui->newUndoRedoCheckBox, &QCheckBox::stateChanged, this, &GeneralPage::newUndoRedoCheckBoxStateChanged);
     connect(ui->undoStepsBox, spinValueChanged, this, &GeneralPage::undoRedoMaxStepsChanged);
@@ -188,6 +189,9 @@ void GeneralPage::updateValues()
     QSignalBlocker b12(ui->framePoolSizeSpin);
     ui->framePoolSizeSpin->setValue(mManager->getInt(SETTING::FRAME_POOL_SIZE));
 
+    QSignalBlocker bFramePreloadSpin(ui->framePreloadSpin);
+    ui->framePreloadSpin->setValue(mManager->getInt(SETTING::FRAME_PRELOAD_COUNT));
+
     QSignalBlocker bNewUndoRedoCheckBox(ui->newUndoRedoCheckBox);
     ui->newUndoRedoCheckBox->setChecked(mManager->isOn(SETTING::NEW_UNDO_REDO_SYSTEM_ON));
 
@@ -327,6 +331,11 @@ void GeneralPage::frameCacheNumberChanged(int value)
     mManager->set(SETTING::FRAME_POOL_SIZE, value);
 }
 
+void GeneralPage::framePreloadCountChanged(int value)
+{
+    mManager->set(SETTING::FRAME_PRELOAD_COUNT, value);
+}
+
 void GeneralPage::invertScrollDirectionBoxStateChanged(int b)
 {
     mManager->set(SETTING::INVERT_SCROLL_ZOOM_DIRECTION, b != Qt::Unchecked);
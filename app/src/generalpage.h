@@ -57,6 +57,7 @@ private slots:
     void curveSmoothingChanged(int value);
     void backgroundChanged(QAbstractButton* button);
     void frameCacheNumberChanged(int value);
+    void framePreloadCountChanged(int value);
     void invertScrollDirectionBoxStateChanged(int b);
     void newUndoRedoCheckBoxStateChanged();
     void undoRedoMaxStepsChanged();
@@ -15,6 +15,7 @@ GNU General Public License for more details.
 
 */
 
+#include "commandlineparser.h"
 #include "log.h"
 #include "pencil2d.h"
 #include "pencilerror.h"
@@ -30,6 +31,12 @@ int main(int argc, char* argv[])
     PlatformHandler::initialise();
     initCategoryLogging();
 
+    // Exports never show a window, so they don't need a display server either
+    if (CommandLineParser::hasExportOption(argc, argv) && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     Pencil2D app(argc, argv);
 
     switch (app.handleCommandLineOptions().code())
@@ -69,6 +69,7 @@ GNU General Public License for more details.
 #include "timeline.h"
 #include "toolbox.h"
 #include "onionskinwidget.h"
+#include "renderstatsdock.h"
 #include "pegbaralignmentdialog.h"
 #include "addtransparencytopaperdialog.h"
 #include "repositionframesdialog.h"
@@ -190,6 +191,9 @@ void MainWindow2::createDockWidgets()
     mToolBox = new ToolBoxDockWidget(this);
     mToolBox->setObjectName("ToolBox");
 
+    mRenderStatsDock = new RenderStatsDock(this);
+    mRenderStatsDock->setObjectName("RenderStats");
+
     mDockWidgets
         << mTimeLine
         << mColorBox
@@ -197,7 +201,8 @@ void MainWindow2::createDockWidgets()
         << mColorPalette
         << mOnionSkinWidget
         << mToolOptions
-        << mToolBox;
+        << mToolBox
+        << mRenderStatsDock;
 
     mStartIcon = QIcon(":icons/controls/play.png");
     mStopIcon = QIcon(":icons/controls/stop.png");
@@ -222,6 +227,8 @@ void MainWindow2::createDockWidgets()
     addDockWidget(Qt::LeftDockWidgetArea, mToolOptions);
     addDockWidget(Qt::LeftDockWidgetArea, mOnionSkinWidget);
     addDockWidget(Qt::BottomDockWidgetArea, mTimeLine);
+    addDockWidget(Qt::RightDockWidgetArea, mRenderStatsDock);
+    mRenderStatsDock->hide();
     setDockNestingEnabled(true);
 
     /*
@@ -492,6 +499,15 @@ void MainWindow2::createMenus()
     connect(ui->actionCheck_for_Updates, &QAction::triggered, mCommands, &ActionCommands::checkForUpdates);
     connect(ui->actionReport_Bug, &QAction::triggered, mCommands, &ActionCommands::reportbug);
     connect(ui->actionOpen_Temporary_Directory, &QAction::triggered, mCommands, &ActionCommands::openTemporaryDirectory);
+    connect(ui->actionMemory_Usage, &QAction::triggered, mCommands, &ActionCommands::memoryUsage);
+    connect(ui->actionSave_Trace, &QAction::triggered, mCommands, &ActionCommands::saveTrace);
+#ifdef PENCIL2D_NO_TRACE
+    ui->actionSave_Trace->setVisible(false);
+#endif
+    QAction* renderStatsAction = mRenderStatsDock->toggleViewAction();
+    renderStatsAction->setMenuRole(QAction::NoRole);
+    const QList<QAction*> helpActions = ui->menuHelp->actions();
+    ui->menuHelp->insertAction(helpActions.value(helpActions.indexOf(ui->actionMemory_Usage) + 1), renderStatsAction);
     connect(ui->actionAbout, &QAction::triggered, mCommands, &ActionCommands::about);
 
     //--- Menus ---
@@ -1102,6 +1118,10 @@ void MainWindow2::resetAndDockAllSubWidgets()
     addDockWidget(Qt::LeftDockWidgetArea, mToolOptions);
     addDockWidget(Qt::LeftDockWidgetArea, mOnionSkinWidget);
     addDockWidget(Qt::BottomDockWidgetArea, mTimeLine);
+
+    // The render statistics are for troubleshooting, not part of the default layout
+    addDockWidget(Qt::RightDockWidgetArea, mRenderStatsDock);
+    mRenderStatsDock->hide();
 }
 
 void MainWindow2::newObject()
@@ -36,6 +36,7 @@ class PreferencesDialog;
 class PreviewWidget;
 class ColorBox;
 class ColorInspector;
+class RenderStatsDock;
 class RecentFileMenu;
 class ActionCommands;
 class ImportImageSeqDialog;
@@ -169,6 +170,7 @@ private:
     TimeLine*             mTimeLine = nullptr;
     ColorInspector*       mColorInspector = nullptr;
     OnionSkinWidget*      mOnionSkinWidget = nullptr;
+    RenderStatsDock*      mRenderStatsDock = nullptr;
     QToolBar*             mMainToolbar = nullptr;
     QToolBar*             mViewToolbar = nullptr;
     QToolBar*             mOverlayToolbar = nullptr;
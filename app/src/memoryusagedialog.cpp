@@ -0,0 +1,138 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "memoryusagedialog.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "editor.h"
+#include "memoryreport.h"
+
+
+MemoryUsageDialog::MemoryUsageDialog(Editor* editor, QWidget* parent) :
+    QDialog(parent),
+    mEditor(editor)
+{
+    setWindowTitle(tr("Memory Usage"));
+    setWindowFlags(Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    setMinimumSize(QSize(360, 300));
+
+    mTable = new QTableWidget(MemoryReport::CATEGORY_COUNT + 1, 2);
+    mTable->setHorizontalHeaderLabels({ tr("Size"), tr("Items") });
+    mTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    mTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mTable->setSelectionMode(QAbstractItemView::NoSelection);
+
+    QStringList rowNames;
+    for (int i = 0; i < MemoryReport::CATEGORY_COUNT; i++)
+    {
+        rowNames << MemoryReport::categoryName(static_cast<MemoryReport::Category>(i));
+    }
+    rowNames << tr("Total");
+    mTable->setVerticalHeaderLabels(rowNames);
+
+    mFramePoolLabel = new QLabel;
+
+    QPushButton* copyButton = new QPushButton(tr("Copy to clipboard"));
+    QPushButton* saveButton = new QPushButton(tr("Save..."));
+    QPushButton* closeButton = new QPushButton(tr("Close"));
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(copyButton);
+    buttonLayout->addWidget(saveButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addWidget(mTable);
+    layout->addWidget(mFramePoolLabel);
+    layout->addLayout(buttonLayout);
+    setLayout(layout);
+
+    connect(copyButton, &QPushButton::clicked, this, &MemoryUsageDialog::copyReport);
+    connect(saveButton, &QPushButton::clicked, this, &MemoryUsageDialog::saveReport);
+    connect(closeButton, &QPushButton::clicked, this, &MemoryUsageDialog::close);
+
+    mRefreshTimer = new QTimer(this);
+    mRefreshTimer->setInterval(1000);
+    connect(mRefreshTimer, &QTimer::timeout, this, &MemoryUsageDialog::refresh);
+    mRefreshTimer->start();
+
+    refresh();
+}
+
+void MemoryUsageDialog::refresh()
+{
+    const MemoryReport report = mEditor->memoryReport();
+    const QLocale locale;
+
+    auto setRow = [this](int row, const QString& size, const QString& items)
+    {
+        QTableWidgetItem* sizeItem = new QTableWidgetItem(size);
+        sizeItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        mTable->setItem(row, 0, sizeItem);
+
+        QTableWidgetItem* itemsItem = new QTableWidgetItem(items);
+        itemsItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        mTable->setItem(row, 1, itemsItem);
+    };
+
+    for (int i = 0; i < MemoryReport::CATEGORY_COUNT; i++)
+    {
+        const auto category = static_cast<MemoryReport::Category>(i);
+        const int items = report.items(category);
+        setRow(i, locale.formattedDataSize(static_cast<qint64>(report.bytes(category))),
+               items > 0 ? QString::number(items) : QString());
+    }
+    setRow(MemoryReport::CATEGORY_COUNT, locale.formattedDataSize(static_cast<qint64>(report.totalBytes())), QString());
+
+    mFramePoolLabel->setText(tr("Frame pool: %1 of %2")
+                             .arg(locale.formattedDataSize(static_cast<qint64>(report.framePoolUsedBytes())),
+                                  locale.formattedDataSize(static_cast<qint64>(report.framePoolBudgetBytes()))));
+}
+
+void MemoryUsageDialog::copyReport()
+{
+    QJsonDocument document(mEditor->memoryReport().toJson());
+    QApplication::clipboard()->setText(QString::fromUtf8(document.toJson()));
+}
+
+void MemoryUsageDialog::saveReport()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Save Memory Report"), "memory-report.json", tr("JSON files (*.json)"));
+    if (filePath.isEmpty()) { return; }
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+    {
+        QMessageBox::warning(this, tr("Warning"), tr("Unable to write %1").arg(filePath));
+        return;
+    }
+    file.write(QJsonDocument(mEditor->memoryReport().toJson()).toJson());
+}
@@ -0,0 +1,47 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef MEMORYUSAGEDIALOG_H
+#define MEMORYUSAGEDIALOG_H
+
+#include <QDialog>
+
+class QLabel;
+class QTableWidget;
+class QTimer;
+class Editor;
+
+/** Shows how much memory the editor holds by kind of data, refreshed while the dialog is open */
+class MemoryUsageDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    MemoryUsageDialog(Editor* editor, QWidget* parent);
+
+    void refresh();
+
+private:
+    void copyReport();
+    void saveReport();
+
+    Editor* mEditor = nullptr;
+    QTableWidget* mTable = nullptr;
+    QLabel* mFramePoolLabel = nullptr;
+    QTimer* mRefreshTimer = nullptr;
+};
+
+#endif // MEMORYUSAGEDIALOG_H
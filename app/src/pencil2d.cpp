@@ -29,12 +29,14 @@ GNU General Public License for more details.
 #include <QStandardPaths>
 #include <QDir>
 #include <QMessageBox>
+#include <QTextStream>
 
 #include "commandlineexporter.h"
 #include "commandlineparser.h"
 #include "mainwindow2.h"
 #include "pencildef.h"
 #include "platformhandler.h"
+#include "tracer.h"
 
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
@@ -72,38 +74,54 @@ Pencil2D::~Pencil2D()
 Status Pencil2D::handleCommandLineOptions()
 {
     CommandLineParser parser;
-    parser.process(arguments());
-
-#ifndef QT_DEBUG
-    if (isInstanceOpen()) {
-        return Status::SAFE;
+    if (!parser.process(arguments()))
+    {
+        return Status::FAIL;
     }
-#endif
 
     QString inputPath = parser.inputPath();
     QStringList outputPaths = parser.outputPaths();
 
     if (outputPaths.isEmpty())
     {
+#ifndef QT_DEBUG
+        if (isInstanceOpen()) {
+            return Status::SAFE;
+        }
+#endif
         prepareGuiStartup(inputPath);
         return Status::OK;
     }
 
-    // Can't construct the editor directly, need to make a main window instead because... reasons
-    mainWindow.reset(new MainWindow2);
-    CommandLineExporter exporter(mainWindow->mEditor);
-    if (exporter.process(inputPath,
-                         outputPaths,
-                         parser.camera(),
-                         parser.width(),
-                         parser.height(),
-                         parser.startFrame(),
-                         parser.endFrame(),
-                         parser.transparency()))
+    ExportChunkOptions chunk;
+    chunk.count = parser.chunkCount();
+    chunk.index = parser.chunkIndex();
+    chunk.byCost = parser.chunkByCost();
+    chunk.manifestPath = parser.manifestPath();
+
+    if (!parser.tracePath().isEmpty())
+    {
+        Tracer::instance().setEnabled(true);
+    }
+
+    // Exports only need the editor and its managers, no main window is created
+    CommandLineExporter exporter;
+    const bool ok = exporter.process(inputPath,
+                                     outputPaths,
+                                     parser.camera(),
+                                     parser.width(),
+                                     parser.height(),
+                                     parser.startFrame(),
+                                     parser.endFrame(),
+                                     parser.transparency(),
+                                     chunk);
+
+    if (!parser.tracePath().isEmpty() && !Tracer::instance().save(parser.tracePath()))
     {
-        return Status::SAFE;
+        QTextStream(stderr) << tr("Warning: Unable to write the trace to %1").arg(parser.tracePath()) << "\n";
     }
-    return Status::FAIL;
+
+    return ok ? Status::SAFE : Status::FAIL;
 }
 
 bool Pencil2D::isInstanceOpen()
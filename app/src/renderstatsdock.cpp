@@ -0,0 +1,195 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "renderstatsdock.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "editor.h"
+#include "renderstats.h"
+#include "scribblearea.h"
+
+
+RenderStatsDock::RenderStatsDock(QWidget* parent) : BaseDockWidget(parent)
+{
+    setWindowTitle(tr("Render Statistics", "Window title of render statistics panel"));
+}
+
+RenderStatsDock::~RenderStatsDock()
+{
+}
+
+void RenderStatsDock::initUI()
+{
+    auto createTable = [](int rows, const QStringList& columns)
+    {
+        QTableWidget* table = new QTableWidget(rows, columns.size());
+        table->setHorizontalHeaderLabels(columns);
+        table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        table->setSelectionMode(QAbstractItemView::NoSelection);
+        return table;
+    };
+
+    mStageTable = createTable(RenderStats::STAGE_COUNT + 1, { tr("Median"), tr("95%"), tr("Max") });
+    QStringList stageNames;
+    for (int i = 0; i < RenderStats::STAGE_COUNT; i++)
+    {
+        stageNames << RenderStats::stageName(static_cast<RenderStats::Stage>(i));
+    }
+    stageNames << tr("Total");
+    mStageTable->setVerticalHeaderLabels(stageNames);
+
+    mCacheTable = createTable(RenderStats::CACHE_COUNT, { tr("Hits"), tr("Misses"), tr("Hit rate") });
+    QStringList cacheNames;
+    for (int i = 0; i < RenderStats::CACHE_COUNT; i++)
+    {
+        cacheNames << RenderStats::cacheName(static_cast<RenderStats::Cache>(i));
+    }
+    mCacheTable->setVerticalHeaderLabels(cacheNames);
+
+    mSampleLabel = new QLabel;
+
+    QPushButton* copyButton = new QPushButton(tr("Copy JSON"));
+    QPushButton* saveButton = new QPushButton(tr("Save CSV..."));
+    QPushButton* resetButton = new QPushButton(tr("Reset"));
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(copyButton);
+    buttonLayout->addWidget(saveButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(resetButton);
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->setContentsMargins(3, 3, 3, 3);
+    layout->addWidget(mStageTable);
+    layout->addWidget(mCacheTable);
+    layout->addWidget(mSampleLabel);
+    layout->addLayout(buttonLayout);
+    QWidget* mainWidget = new QWidget;
+    mainWidget->setLayout(layout);
+    setWidget(mainWidget);
+
+    connect(copyButton, &QPushButton::clicked, this, &RenderStatsDock::copyJson);
+    connect(saveButton, &QPushButton::clicked, this, &RenderStatsDock::saveCsv);
+    connect(resetButton, &QPushButton::clicked, this, &RenderStatsDock::resetStats);
+
+    // Only refresh while the panel can be seen, the numbers are gathered regardless
+    mRefreshTimer = new QTimer(this);
+    mRefreshTimer->setInterval(500);
+    connect(mRefreshTimer, &QTimer::timeout, this, &RenderStatsDock::updateUI);
+    connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible)
+    {
+        if (visible) {
+            updateUI();
+            mRefreshTimer->start();
+        } else {
+            mRefreshTimer->stop();
+        }
+    });
+}
+
+void RenderStatsDock::updateUI()
+{
+    RenderStats* stats = renderStats();
+    if (stats == nullptr || mStageTable == nullptr) { return; }
+
+    auto setCell = [](QTableWidget* table, int row, int column, const QString& text)
+    {
+        QTableWidgetItem* item = new QTableWidgetItem(text);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table->setItem(row, column, item);
+    };
+    auto msec = [](double value) { return tr("%1 ms").arg(value, 0, 'f', 2); };
+
+    for (int i = 0; i < RenderStats::STAGE_COUNT; i++)
+    {
+        const auto stage = static_cast<RenderStats::Stage>(i);
+        setCell(mStageTable, i, 0, msec(stats->percentile(stage, 50)));
+        setCell(mStageTable, i, 1, msec(stats->percentile(stage, 95)));
+        setCell(mStageTable, i, 2, msec(stats->maximum(stage)));
+    }
+    setCell(mStageTable, RenderStats::STAGE_COUNT, 0, msec(stats->totalPercentile(50)));
+    setCell(mStageTable, RenderStats::STAGE_COUNT, 1, msec(stats->totalPercentile(95)));
+    setCell(mStageTable, RenderStats::STAGE_COUNT, 2, msec(stats->totalMaximum()));
+
+    for (int i = 0; i < RenderStats::CACHE_COUNT; i++)
+    {
+        const auto cache = static_cast<RenderStats::Cache>(i);
+        const int hits = stats->hits(cache);
+        const int lookups = hits + stats->misses(cache);
+        setCell(mCacheTable, i, 0, QString::number(hits));
+        setCell(mCacheTable, i, 1, QString::number(stats->misses(cache)));
+        setCell(mCacheTable, i, 2, lookups > 0 ? QString("%1%").arg(100.0 * hits / lookups, 0, 'f', 1) : QString());
+    }
+
+    mSampleLabel->setText(tr("Last %n paint(s)", "", stats->sampleCount()));
+}
+
+RenderStats* RenderStatsDock::renderStats() const
+{
+    if (editor() == nullptr || editor()->getScribbleArea() == nullptr) { return nullptr; }
+    return &editor()->getScribbleArea()->renderStats();
+}
+
+void RenderStatsDock::copyJson()
+{
+    RenderStats* stats = renderStats();
+    if (stats == nullptr) { return; }
+
+    QApplication::clipboard()->setText(QString::fromUtf8(QJsonDocument(stats->toJson()).toJson()));
+}
+
+void RenderStatsDock::saveCsv()
+{
+    RenderStats* stats = renderStats();
+    if (stats == nullptr) { return; }
+
+    // Taken before the dialog opens, as the dialog makes the canvas repaint
+    const QString csv = stats->toCsv();
+
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Save Render Statistics"), "render-stats.csv", tr("CSV files (*.csv)"));
+    if (filePath.isEmpty()) { return; }
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly | QFile::Text))
+    {
+        QMessageBox::warning(this, tr("Warning"), tr("Unable to write %1").arg(filePath));
+        return;
+    }
+    file.write(csv.toUtf8());
+}
+
+void RenderStatsDock::resetStats()
+{
+    RenderStats* stats = renderStats();
+    if (stats == nullptr) { return; }
+
+    stats->reset();
+    updateUI();
+}
@@ -0,0 +1,52 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef RENDERSTATSDOCK_H
+#define RENDERSTATSDOCK_H
+
+#include "basedockwidget.h"
+
+class QLabel;
+class QTableWidget;
+class QTimer;
+class RenderStats;
+
+/** Shows how long the recent canvas paints took by stage and the render cache hit counts, refreshed while visible */
+class RenderStatsDock : public BaseDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit RenderStatsDock(QWidget* parent);
+    ~RenderStatsDock() override;
+
+    void initUI() override;
+    void updateUI() override;
+
+private:
+    RenderStats* renderStats() const;
+
+    void copyJson();
+    void saveCsv();
+    void resetStats();
+
+    QTableWidget* mStageTable = nullptr;
+    QTableWidget* mCacheTable = nullptr;
+    QLabel* mSampleLabel = nullptr;
+    QTimer* mRefreshTimer = nullptr;
+};
+
+#endif // RENDERSTATSDOCK_H
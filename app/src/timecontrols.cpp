@@ -264,7 +264,6 @@ void TimeControls::jumpToStartButtonClicked()
     if (mPlaybackRangeCheckBox->isChecked())
     {
         mEditor->scrubTo(mLoopStartSpinBox->value());
-        mEditor->playback()->setCheckForSoundsHalfway(true);
     }
     else
     {
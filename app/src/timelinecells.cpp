@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include <QInputDialog>
 #include <QPainter>
 #include <QRegularExpression>
+#include <QSet>
 #include <QSettings>
 #include <QDebug>
 
@@ -33,6 +34,9 @@ GNU General Public License for more details.
 #include "object.h"
 #include "playbackmanager.h"
 #include "preferencemanager.h"
+#include "soundmanager.h"
+#include "soundmixdown.h"
+#include "soundwaveform.h"
 #include "undoredomanager.h"
 #include "timeline.h"
 
@@ -57,6 +61,7 @@ TimeLineCells::TimeLineCells(TimeLine* parent, Editor* editor, TIMELINE_CELL_TYP
     setMouseTracking(true);
 
     connect(mPrefs, &PreferenceManager::optionChanged, this, &TimeLineCells::loadSetting);
+    connect(editor->sound(), &SoundManager::waveformReady, this, &TimeLineCells::updateContent);
 }
 
 TimeLineCells::~TimeLineCells()
@@ -160,6 +165,12 @@ int TimeLineCells::getLayerY(int layerNumber) const
     return mOffsetY + (mEditor->object()->getLayerCount() - 1 - layerNumber - mLayerOffset)*mLayerHeight;
 }
 
+bool TimeLineCells::isLayerRowVisible(int layerY) const
+{
+    // The frame header is painted over the rows scrolled above it
+    return layerY + mLayerHeight > mOffsetY && layerY - 1 < height();
+}
+
 void TimeLineCells::updateFrame(int frameNumber)
 {
     int x = getFrameX(frameNumber);
@@ -243,10 +254,10 @@ void TimeLineCells::drawContent()
             continue;
         }
         const Layer* layeri = object->getLayer(i);
+        const int layerY = getLayerY(i);
 
-        if (layeri != nullptr)
+        if (layeri != nullptr && isLayerRowVisible(layerY))
         {
-            const int layerY = getLayerY(i);
             switch (mType)
             {
             case TIMELINE_CELL_TYPE::Tracks:
@@ -347,7 +358,9 @@ void TimeLineCells::drawContent()
         paintTicks(painter, palette);
 
         for (int i = 0; i < object->getLayerCount(); i++) {
-            paintSelectedFrames(painter, object->getLayer(i), i);
+            if (isLayerRowVisible(getLayerY(i))) {
+                paintSelectedFrames(painter, object->getLayer(i), i);
+            }
         }
     }
     mRedrawContent = false;
@@ -446,8 +459,14 @@ void TimeLineCells::paintFrames(QPainter& painter, QColor trackCol, const Layer*
 
     int recHeight = height - 4;
 
-    const QList<int> selectedFrames = layer->getSelectedFramesByPos();
-    layer->foreachKeyFrame([&](KeyFrame* key)
+    QSet<int> selectedFrames;
+    for (int framePos : layer->getSelectedFramesByPos())
+    {
+        selectedFrames.insert(framePos);
+    }
+
+    // Only visit the keys that can be seen in the scrolled viewport
+    layer->foreachKeyFrameInRange(getFrameNumber(mOffsetX), getFrameNumber(width()), [&](KeyFrame* key)
     {
         int framePos = key->pos();
         int recWidth = standardWidth;
@@ -475,6 +494,11 @@ void TimeLineCells::paintFrames(QPainter& painter, QColor trackCol, const Layer*
         }
 
         painter.drawRect(recLeft, recTop, recWidth, recHeight);
+
+        if (layer->type() == Layer::SOUND)
+        {
+            paintWaveform(painter, key, recLeft, recTop, recWidth, recHeight);
+        }
     });
 }
 
@@ -517,6 +541,41 @@ void TimeLineCells::paintHighlightedFrame(QPainter& painter, int framePos, int r
     painter.restore();
 }
 
+void TimeLineCells::paintWaveform(QPainter& painter, const KeyFrame* key, int recLeft, int recTop, int recWidth, int recHeight) const
+{
+    const SoundWaveform* waveform = mEditor->sound()->waveform(key->fileName());
+    if (waveform == nullptr || waveform->isEmpty())
+    {
+        return; // still being analysed, repainted once it's ready
+    }
+
+    const double samplesPerPixel = static_cast<double>(SoundMixdown::SAMPLE_RATE) / (mEditor->fps() * mFrameSize);
+    const double scale = (recHeight / 2 - 1) / 127.0;
+    const int centerY = recTop + recHeight / 2;
+
+    // One line per visible pixel column, from the lowest to the highest sample it covers
+    const int firstX = qMax(recLeft + 1, 0);
+    const int lastX = qMin(recLeft + recWidth, width());
+    QVector<QLine> lines;
+    lines.reserve(qMax(0, lastX - firstX));
+    for (int x = firstX; x < lastX; x++)
+    {
+        const qint64 firstSample = qRound64((x - recLeft) * samplesPerPixel);
+        if (firstSample >= waveform->sampleCount())
+        {
+            break;
+        }
+        const qint64 lastSample = qMax(firstSample + 1, qRound64((x - recLeft + 1) * samplesPerPixel));
+        const SoundWaveform::Peak peak = waveform->peak(firstSample, lastSample);
+        lines.append(QLine(x, centerY - qRound(peak.max * scale), x, centerY - qRound(peak.min * scale)));
+    }
+
+    painter.save();
+    painter.setPen(QColor(40, 40, 40, 180));
+    painter.drawLines(lines);
+    painter.restore();
+}
+
 void TimeLineCells::paintSelectedFrames(QPainter& painter, const Layer* layer, const int layerIndex) const
 {
     int mouseX = mMouseMoveX;
@@ -525,11 +584,22 @@ void TimeLineCells::paintSelectedFrames(QPainter& painter, const Layer* layer, c
     int recWidth = standardWidth;
     int recHeight = mLayerHeight - 4;
     int recTop = getLayerY(layerIndex) + 1;
+    const int firstVisibleFrame = getFrameNumber(mOffsetX);
+    const int lastVisibleFrame = getFrameNumber(width());
 
     painter.save();
     for (int framePos : layer->getSelectedFramesByPos()) {
 
+        // Frames being moved are painted relative to the cursor, so they can't be culled by position
+        if (!mMovingFrames && framePos > lastVisibleFrame) {
+            continue;
+        }
+
         KeyFrame* key = layer->getKeyFrameAt(framePos);
+        if (!mMovingFrames && framePos + key->length() - 1 < firstVisibleFrame) {
+            continue;
+        }
+
         if (key->length() > 1)
         {
             // This is a special case for sound clip.
@@ -550,6 +620,11 @@ void TimeLineCells::paintSelectedFrames(QPainter& painter, const Layer* layer, c
         } else {
             int currentFrameX = frameX - standardWidth;
             painter.drawRect(currentFrameX, recTop, recWidth, recHeight);
+
+            if (layer->type() == Layer::SOUND)
+            {
+                paintWaveform(painter, key, currentFrameX, recTop, recWidth, recHeight);
+            }
         }
     }
     painter.restore();
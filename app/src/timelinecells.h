@@ -23,6 +23,7 @@ GNU General Public License for more details.
 #include "layercamera.h"
 
 class Layer;
+class KeyFrame;
 enum class LayerVisibility;
 class TimeLine;
 class QPaintEvent;
@@ -94,6 +95,7 @@ private:
     int getLayerNumber(int y) const;
     int getInbetweenLayerNumber(int y) const;
     int getLayerY(int layerNumber) const;
+    bool isLayerRowVisible(int layerY) const;
     int getFrameX(int frameNumber) const;
     int getFrameNumber(int x) const;
 
@@ -112,6 +114,7 @@ private:
     void paintLabel(QPainter& painter, const Layer* layer, int x, int y, int height, int width, bool selected, LayerVisibility layerVisibility) const;
     void paintSelection(QPainter& painter, int x, int y, int width, int height) const;
     void paintHighlightedFrame(QPainter& painter, int framePos, int recTop, int recWidth, int recHeight) const;
+    void paintWaveform(QPainter& painter, const KeyFrame* key, int recLeft, int recTop, int recWidth, int recHeight) const;
 
     void editLayerProperties(Layer* layer) const;
     void editLayerProperties(LayerCamera *layer) const;
@@ -11,12 +11,14 @@ set(CORE_LIB_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/corelib-pch.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/external/platformhandler.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapbucket.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapcodec.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapimage.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/tile.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/tiledbuffer.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/bezierarea.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/beziercurve.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/colorref.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/vectorbinary.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/vectorimage.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/vectorselection.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/vector/vertexref.h
@@ -40,14 +42,21 @@ set(CORE_LIB_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/toolmanager.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/undoredomanager.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/viewmanager.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/gifencoder.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/memoryreport.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/miniz.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/movieexporter.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/movieimporter.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/onionskinsubpainter.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/overlaypainter.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/qminiz.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/renderchunks.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/renderstats.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/selectionpainter.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundmixdown.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundmixer.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundplayer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundwaveform.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/camera.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/filemanager.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/keyframe.h
@@ -97,6 +106,7 @@ set(CORE_LIB_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/pencilsettings.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/pointerevent.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/preferencesdef.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/tracer.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/transform.h
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/util.h
 )
@@ -107,6 +117,7 @@ set(CORE_LIB_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/canvascursorpainter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/canvaspainter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapbucket.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapcodec.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/bitmapimage.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/tile.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/graphics/bitmap/tiledbuffer.cpp
@@ -136,14 +147,21 @@ set(CORE_LIB_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/toolmanager.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/undoredomanager.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/managers/viewmanager.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/gifencoder.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/memoryreport.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/miniz.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/movieexporter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/movieimporter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/onionskinsubpainter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/overlaypainter.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/qminiz.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/renderchunks.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/renderstats.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/selectionpainter.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundmixdown.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundmixer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundplayer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/soundwaveform.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/camera.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/filemanager.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/structure/keyframe.cpp
@@ -181,6 +199,7 @@ set(CORE_LIB_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/pencilerror.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/pencilsettings.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/pointerevent.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/tracer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/transform.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/core_lib/src/util/util.cpp
 )
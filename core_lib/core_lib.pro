@@ -29,12 +29,14 @@ HEADERS +=  \
     src/canvascursorpainter.h \
     src/corelib-pch.h \
     src/graphics/bitmap/bitmapbucket.h \
+    src/graphics/bitmap/bitmapcodec.h \
     src/graphics/bitmap/bitmapimage.h \
     src/graphics/bitmap/tile.h \
     src/graphics/bitmap/tiledbuffer.h \
     src/graphics/vector/bezierarea.h \
     src/graphics/vector/beziercurve.h \
     src/graphics/vector/colorref.h \
+    src/graphics/vector/vectorbinary.h \
     src/graphics/vector/vectorimage.h \
     src/graphics/vector/vectorselection.h \
     src/graphics/vector/vertexref.h \
@@ -108,6 +110,7 @@ HEADERS +=  \
     src/util/pencilerror.h \
     src/util/pencilsettings.h \
     src/util/preferencesdef.h \
+    src/util/tracer.h \
     src/util/transform.h \
     src/util/util.h \
     src/util/log.h \
@@ -115,9 +118,16 @@ HEADERS +=  \
     src/util/pointerevent.h \
     src/canvaspainter.h \
     src/soundplayer.h \
+    src/soundmixdown.h \
+    src/memoryreport.h \
+    src/soundmixer.h \
+    src/soundwaveform.h \
     src/movieexporter.h \
+    src/gifencoder.h \
     src/miniz.h \
     src/qminiz.h \
+    src/renderchunks.h \
+    src/renderstats.h \
     src/activeframepool.h \
     src/external/platformhandler.h \
     src/selectionpainter.h
@@ -126,6 +136,7 @@ HEADERS +=  \
 SOURCES +=  src/graphics/bitmap/bitmapimage.cpp \
     src/canvascursorpainter.cpp \
     src/graphics/bitmap/bitmapbucket.cpp \
+    src/graphics/bitmap/bitmapcodec.cpp \
     src/graphics/bitmap/tile.cpp \
     src/graphics/bitmap/tiledbuffer.cpp \
     src/graphics/vector/bezierarea.cpp \
@@ -191,6 +202,7 @@ SOURCES +=  src/graphics/bitmap/bitmapimage.cpp \
     src/util/pencilerror.cpp \
     src/util/pencilsettings.cpp \
     src/util/log.cpp \
+    src/util/tracer.cpp \
     src/util/transform.cpp \
     src/util/util.cpp \
     src/util/pointerevent.cpp \
@@ -199,9 +211,16 @@ SOURCES +=  src/graphics/bitmap/bitmapimage.cpp \
     src/onionskinsubpainter.cpp \
     src/camerapainter.cpp \
     src/soundplayer.cpp \
+    src/soundmixdown.cpp \
+    src/memoryreport.cpp \
+    src/soundmixer.cpp \
+    src/soundwaveform.cpp \
     src/movieexporter.cpp \
+    src/gifencoder.cpp \
     src/miniz.cpp \
     src/qminiz.cpp \
+    src/renderchunks.cpp \
+    src/renderstats.cpp \
     src/activeframepool.cpp \
     src/selectionpainter.cpp
 
@@ -17,6 +17,7 @@ GNU General Public License for more details.
 
 #include "activeframepool.h"
 #include "keyframe.h"
+#include "tracer.h"
 
 
 ActiveFramePool::ActiveFramePool()
@@ -103,6 +104,7 @@ void ActiveFramePool::onKeyFrameDestroy(KeyFrame* key)
 
 void ActiveFramePool::discardLeastUsedFrames()
 {
+    TRACE_SCOPE("frames", "ActiveFramePool::discardLeastUsedFrames");
     while ((mTotalUsedMemory > mMemoryBudgetInBytes) && (mCacheFramesList.size() > mMinFrameCount))
     {
         list_iterator_t last = mCacheFramesList.end();
@@ -42,6 +42,9 @@ public:
     bool isFrameInPool(KeyFrame*);
     void setMinFrameCount(size_t frameCount);
 
+    quint64 usedMemory() const { return mTotalUsedMemory; }
+    quint64 memoryBudget() const { return mMemoryBudgetInBytes; }
+
     void onKeyFrameDestroy(KeyFrame*) override;
 
 private:
@@ -23,6 +23,7 @@ GNU General Public License for more details.
 #include "layercamera.h"
 #include "camera.h"
 #include "keyframe.h"
+#include "memoryreport.h"
 
 #include "transform.h"
 
@@ -45,6 +46,11 @@ void CameraPainter::resetCache()
     mCameraCacheValid = false;
 }
 
+quint64 CameraPainter::memoryUsage() const
+{
+    return MemoryReport::pixmapBytes(mCameraPixmap);
+}
+
 void CameraPainter::preparePainter(const Object* object,
                                    int layerIndex,
                                    int frameIndex,
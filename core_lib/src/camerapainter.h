@@ -48,6 +48,9 @@ public:
 
     void resetCache();
 
+    /** Bytes held by the cached camera overlay */
+    quint64 memoryUsage() const;
+
 private:
     void initializePainter(QPainter& painter, QPixmap& pixmap, const QRect& blitRect, bool blitEnabled);
     void paintVisuals(QPainter& painter, const QRect& blitRect);
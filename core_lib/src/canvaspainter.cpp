@@ -16,6 +16,7 @@ GNU General Public License for more details.
 
 #include "canvaspainter.h"
 
+#include <cmath>
 #include <QtMath>
 
 #include "object.h"
@@ -27,6 +28,10 @@ GNU General Public License for more details.
 #include "vectorimage.h"
 
 #include "painterutils.h"
+#include "memoryreport.h"
+#include "renderstats.h"
+#include "tracer.h"
+#include "util.h"
 
 CanvasPainter::CanvasPainter(QPixmap& canvas) : mCanvas(canvas)
 {
@@ -42,16 +47,14 @@ void CanvasPainter::reset()
     mPostLayersPixmap = QPixmap(mCanvas.size());
     mPreLayersPixmap = QPixmap(mCanvas.size());
     mCurrentLayerPixmap = QPixmap(mCanvas.size());
-    mOnionSkinPixmap = QPixmap(mCanvas.size());
     mPreLayersPixmap.fill(Qt::transparent);
     mCanvas.fill(Qt::transparent);
     mCurrentLayerPixmap.fill(Qt::transparent);
     mPostLayersPixmap.fill(Qt::transparent);
-    mOnionSkinPixmap.fill(Qt::transparent);
     mCurrentLayerPixmap.setDevicePixelRatio(mCanvas.devicePixelRatioF());
     mPreLayersPixmap.setDevicePixelRatio(mCanvas.devicePixelRatioF());
     mPostLayersPixmap.setDevicePixelRatio(mCanvas.devicePixelRatioF());
-    mOnionSkinPixmap.setDevicePixelRatio(mCanvas.devicePixelRatioF());
+    clearOnionSkinCache();
 }
 
 void CanvasPainter::setViewTransform(const QTransform view, const QTransform viewInverse)
@@ -83,10 +86,23 @@ void CanvasPainter::ignoreTransformedSelection()
     mRenderTransform = false;
     mSelectionTransform.reset();
     mSelection = QRect();
+
+    mSelectionCache = QPixmap();
+    mSelectionProxy = QPixmap();
+    mSelectionCacheRect = QRect();
+    mSelectionCacheKey = 0;
+    mLastPaintedSelectionTransform.reset();
 }
 
 void CanvasPainter::paintCached(const QRect& blitRect)
 {
+    TRACE_SCOPE("paint", "CanvasPainter::paintCached");
+    if (mRenderStats)
+    {
+        mRenderStats->countCache(RenderStats::PRE_LAYERS_CACHE, mPreLayersPixmapCacheValid);
+        mRenderStats->countCache(RenderStats::POST_LAYERS_CACHE, mPostLayersPixmapCacheValid);
+    }
+
     if (!mPreLayersPixmapCacheValid)
     {
         QPainter preLayerPainter;
@@ -124,6 +140,28 @@ void CanvasPainter::resetLayerCache()
     mPostLayersPixmapCacheValid = false;
 }
 
+void CanvasPainter::clearOnionSkinCache()
+{
+    mOnionSkinCache.clear();
+    mOnionSkinTintPixmap = QPixmap();
+}
+
+quint64 CanvasPainter::memoryUsage() const
+{
+    quint64 bytes = MemoryReport::pixmapBytes(mPostLayersPixmap) +
+                    MemoryReport::pixmapBytes(mPreLayersPixmap) +
+                    MemoryReport::pixmapBytes(mCurrentLayerPixmap) +
+                    MemoryReport::pixmapBytes(mSelectionCache) +
+                    MemoryReport::pixmapBytes(mSelectionProxy) +
+                    imageSize(mScaledBitmap);
+    bytes += MemoryReport::pixmapBytes(mOnionSkinTintPixmap);
+    for (const OnionSkinCacheEntry& entry : mOnionSkinCache)
+    {
+        bytes += MemoryReport::pixmapBytes(entry.pixmap);
+    }
+    return bytes;
+}
+
 void CanvasPainter::initializePainter(QPainter& painter, QPaintDevice& device, const QRect& blitRect)
 {
     painter.begin(&device);
@@ -149,7 +187,7 @@ void CanvasPainter::renderPreLayers(QPainter& painter, const QRect& blitRect)
         paintCurrentFrame(painter, blitRect, 0, mCurrentLayerIndex - 1);
     }
 
-    paintOnionSkin(painter, blitRect);
+    paintOnionSkin(painter);
     painter.setOpacity(1.0);
 }
 
@@ -174,6 +212,7 @@ void CanvasPainter::setPaintSettings(const Object* object, int currentLayer, int
 
 void CanvasPainter::paint(const QRect& blitRect)
 {
+    TRACE_SCOPE("paint", "CanvasPainter::paint");
     QPainter preLayerPainter;
     QPainter mainPainter;
     QPainter postLayerPainter;
@@ -202,44 +241,71 @@ void CanvasPainter::paint(const QRect& blitRect)
     mPostLayersPixmapCacheValid = true;
 }
 
-void CanvasPainter::paintOnionSkinOnLayer(QPainter& painter, const QRect& blitRect, Layer* layer)
+void CanvasPainter::paintOnionSkinOnLayer(QPainter& painter, Layer* layer)
 {
     mOnionSkinSubPainter.paint(painter, layer, mOnionSkinPainterOptions, mFrameNumber, [&] (OnionSkinPaintState state, int onionFrameNumber) {
         if (state == OnionSkinPaintState::PREV) {
             switch (layer->type())
             {
-            case Layer::BITMAP: { paintBitmapOnionSkinFrame(painter, blitRect, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizePrevFrames); break; }
-            case Layer::VECTOR: { paintVectorOnionSkinFrame(painter, blitRect, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizePrevFrames); break; }
+            case Layer::BITMAP: { paintBitmapOnionSkinFrame(painter, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizePrevFrames); break; }
+            case Layer::VECTOR: { paintVectorOnionSkinFrame(painter, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizePrevFrames); break; }
             default: break;
             }
         }
         if (state == OnionSkinPaintState::NEXT) {
             switch (layer->type())
             {
-            case Layer::BITMAP: { paintBitmapOnionSkinFrame(painter, blitRect, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizeNextFrames); break; }
-            case Layer::VECTOR: { paintVectorOnionSkinFrame(painter, blitRect, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizeNextFrames); break; }
+            case Layer::BITMAP: { paintBitmapOnionSkinFrame(painter, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizeNextFrames); break; }
+            case Layer::VECTOR: { paintVectorOnionSkinFrame(painter, layer, onionFrameNumber, mOnionSkinPainterOptions.colorizeNextFrames); break; }
             default: break;
             }
         }
     });
 }
 
-void CanvasPainter::paintOnionSkin(QPainter& painter, const QRect& blitRect)
+void CanvasPainter::paintOnionSkin(QPainter& painter)
 {
+    TRACE_SCOPE("paint", "CanvasPainter::paintOnionSkin");
+    RenderStats::StageTimer timer(mRenderStats, RenderStats::ONION_SKIN);
+
+    // Cached frames are only valid for the view and the vector options they were rendered with
+    const int flags = (mOptions.bOutlines ? 1 : 0) | (mOptions.bThinLines ? 2 : 0) | (mOptions.bAntiAlias ? 4 : 0);
+    if (mOnionSkinCacheView != mViewTransform || mOnionSkinCacheSize != mCanvas.size() || mOnionSkinCacheFlags != flags)
+    {
+        clearOnionSkinCache();
+        mOnionSkinCacheView = mViewTransform;
+        mOnionSkinCacheSize = mCanvas.size();
+        mOnionSkinCacheFlags = flags;
+    }
+    for (OnionSkinCacheEntry& entry : mOnionSkinCache)
+    {
+        entry.used = false;
+    }
+
     if (!mOptions.bOnionSkinMultiLayer || mOptions.eLayerVisibility == LayerVisibility::CURRENTONLY) {
         Layer* layer = mObject->getLayer(mCurrentLayerIndex);
-        paintOnionSkinOnLayer(painter, blitRect, layer);
+        paintOnionSkinOnLayer(painter, layer);
     } else {
         for (int i = 0; i < mObject->getLayerCount(); i++) {
             Layer* layer = mObject->getLayer(i);
             if (layer == nullptr) { continue; }
 
-            paintOnionSkinOnLayer(painter, blitRect, layer);
+            paintOnionSkinOnLayer(painter, layer);
+        }
+    }
+
+    // Frames that went out of range are not kept around
+    for (auto it = mOnionSkinCache.begin(); it != mOnionSkinCache.end();)
+    {
+        if (it->used) {
+            ++it;
+        } else {
+            it = mOnionSkinCache.erase(it);
         }
     }
 }
 
-void CanvasPainter::paintBitmapOnionSkinFrame(QPainter& painter, const QRect& blitRect, Layer* layer, int nFrame, bool colorize)
+void CanvasPainter::paintBitmapOnionSkinFrame(QPainter& painter, Layer* layer, int nFrame, bool colorize)
 {
     LayerBitmap* bitmapLayer = static_cast<LayerBitmap*>(layer);
 
@@ -248,14 +314,17 @@ void CanvasPainter::paintBitmapOnionSkinFrame(QPainter& painter, const QRect& bl
     if (bitmapImage == nullptr) { return; }
     bitmapImage->loadFile(); // Critical! force the BitmapImage to load the image
 
-    QPainter onionSkinPainter;
-    initializePainter(onionSkinPainter, mOnionSkinPixmap, blitRect);
+    OnionSkinSource source;
+    source.bounds = bitmapImage->bounds(); // crops the image, so before taking its key
+    source.revision = bitmapImage->revision();
+    source.imageKey = bitmapImage->image()->cacheKey();
 
-    onionSkinPainter.drawImage(bitmapImage->topLeft(), *bitmapImage->image());
-    paintOnionSkinFrame(painter, onionSkinPainter, nFrame, colorize, bitmapImage->getOpacity());
+    paintOnionSkinFrame(painter, bitmapImage, source, source.bounds, nFrame, colorize, bitmapImage->getOpacity(), [this, bitmapImage](QPainter& onionSkinPainter) {
+        paintBitmapImage(onionSkinPainter, bitmapImage);
+    });
 }
 
-void CanvasPainter::paintVectorOnionSkinFrame(QPainter& painter, const QRect& blitRect, Layer* layer, int nFrame, bool colorize)
+void CanvasPainter::paintVectorOnionSkinFrame(QPainter& painter, Layer* layer, int nFrame, bool colorize)
 {
     LayerVector* vectorLayer = static_cast<LayerVector*>(layer);
 
@@ -263,38 +332,104 @@ void CanvasPainter::paintVectorOnionSkinFrame(QPainter& painter, const QRect& bl
     VectorImage* vectorImage = vectorLayer->getVectorImageAtFrame(nFrame);
     if (vectorImage == nullptr) { return; }
 
-    QPainter onionSkinPainter;
-    initializePainter(onionSkinPainter, mOnionSkinPixmap, blitRect);
+    OnionSkinSource source;
+    source.revision = vectorImage->revision();
 
-    vectorImage->paintImage(onionSkinPainter, *mObject, mOptions.bOutlines, mOptions.bThinLines, mOptions.bAntiAlias);
-    paintOnionSkinFrame(painter, onionSkinPainter, nFrame, colorize, vectorImage->getOpacity());
+    // Strokes reach past the curve bounds, so vector frames cover the whole view
+    paintOnionSkinFrame(painter, vectorImage, source, QRectF(), nFrame, colorize, vectorImage->getOpacity(), [this, vectorImage](QPainter& onionSkinPainter) {
+        vectorImage->paintImage(onionSkinPainter, *mObject, mOptions.bOutlines, mOptions.bThinLines, mOptions.bAntiAlias);
+    });
 }
 
-void CanvasPainter::paintOnionSkinFrame(QPainter& painter, QPainter& onionSkinPainter, int nFrame, bool colorize, qreal frameOpacity)
+void CanvasPainter::paintOnionSkinFrame(QPainter& painter, const KeyFrame* key, const OnionSkinSource& source, const QRectF& bounds,
+                                        int nFrame, bool colorize, qreal frameOpacity, const std::function<void(QPainter&)>& paintFrame)
 {
-    // Don't transform the image here as we used the viewTransform in the image output
-    painter.setWorldMatrixEnabled(false);
-    // Remember to adjust overall opacity based on opacity value from image
-    onionSkinPainter.setOpacity(frameOpacity - (1.0-painter.opacity()));
-    if (colorize)
-    {
-        QColor colorBrush = Qt::transparent; //no color for the current frame
+    OnionSkinCacheEntry& entry = mOnionSkinCache[key];
+    entry.used = true;
+
+    const bool isCached = !entry.pixmap.isNull() && entry.source == source;
+    if (mRenderStats) { mRenderStats->countCache(RenderStats::ONION_SKIN_CACHE, isCached); }
 
-        if (nFrame < mFrameNumber)
+    if (!isCached)
+    {
+        const qreal dpr = mCanvas.devicePixelRatioF();
+        const QRect viewRect(QPoint(0, 0), mCanvas.size() / dpr);
+        entry.source = source;
+        entry.rect = bounds.isNull() ? viewRect : mViewTransform.mapRect(bounds).toAlignedRect().intersected(viewRect);
+        if (entry.rect.isEmpty())
         {
-            colorBrush = Qt::red;
+            entry.pixmap = QPixmap();
+            return;
         }
-        else if (nFrame > mFrameNumber)
+
+        entry.pixmap = QPixmap(entry.rect.size() * dpr);
+        entry.pixmap.setDevicePixelRatio(dpr);
+        entry.pixmap.fill(Qt::transparent);
+
+        QPainter onionSkinPainter(&entry.pixmap);
+        onionSkinPainter.setWorldTransform(mViewTransform * QTransform::fromTranslate(-entry.rect.x(), -entry.rect.y()));
+        paintFrame(onionSkinPainter);
+    }
+    if (entry.pixmap.isNull()) { return; }
+
+    const QPixmap* pixmap = &entry.pixmap;
+    if (colorize)
+    {
+        // Tint a copy, the cached frame stays untinted since the tint changes whenever the current frame does
+        const QSize pixelSize = entry.pixmap.size();
+        if (mOnionSkinTintPixmap.width() < pixelSize.width() || mOnionSkinTintPixmap.height() < pixelSize.height())
         {
-            colorBrush = Qt::blue;
+            mOnionSkinTintPixmap = QPixmap(pixelSize.expandedTo(mOnionSkinTintPixmap.size()));
         }
-        onionSkinPainter.setWorldMatrixEnabled(false);
+        mOnionSkinTintPixmap.setDevicePixelRatio(entry.pixmap.devicePixelRatio());
+
+        // Remember to adjust the tint based on the opacity value from the image
+        QPainter tintPainter(&mOnionSkinTintPixmap);
+        tintPainter.setCompositionMode(QPainter::CompositionMode_Source);
+        tintPainter.drawPixmap(0, 0, entry.pixmap);
+        tintPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        tintPainter.setOpacity(qBound(0.0, frameOpacity - (1.0 - painter.opacity()), 1.0));
+        tintPainter.fillRect(QRect(QPoint(0, 0), entry.rect.size()), onionSkinTint(nFrame));
+        tintPainter.end();
+        pixmap = &mOnionSkinTintPixmap;
+    }
+
+    // Don't transform the image here as we used the viewTransform in the image output
+    painter.save();
+    painter.setWorldMatrixEnabled(false);
+    painter.drawPixmap(QPointF(entry.rect.topLeft()), *pixmap, QRectF(QPointF(0, 0), entry.pixmap.size()));
+    painter.restore();
+}
 
-        onionSkinPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-        onionSkinPainter.setBrush(colorBrush);
-        onionSkinPainter.drawRect(painter.viewport());
+void CanvasPainter::paintBitmapImage(QPainter& painter, BitmapImage* bitmapImage)
+{
+    const QRect bounds = bitmapImage->bounds(); // crops the image, so before picking a level
+
+    // Zoomed out, a downsampled level is drawn instead of scaling the full image down on every paint
+    const QImage& image = bitmapImage->mipmap(mOptions.scaling * mCanvas.devicePixelRatioF());
+    if (&image == bitmapImage->image())
+    {
+        painter.drawImage(bounds.topLeft(), image);
+        return;
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(QRectF(bounds), image);
+    painter.restore();
+}
+
+QColor CanvasPainter::onionSkinTint(int nFrame) const
+{
+    if (nFrame < mFrameNumber)
+    {
+        return Qt::red;
+    }
+    else if (nFrame > mFrameNumber)
+    {
+        return Qt::blue;
     }
-    painter.drawPixmap(mPointZero, mOnionSkinPixmap);
+    return Qt::transparent; //no color for the current frame
 }
 
 void CanvasPainter::paintCurrentBitmapFrame(QPainter& painter, const QRect& blitRect, Layer* layer, bool isCurrentLayer)
@@ -313,7 +448,7 @@ void CanvasPainter::paintCurrentBitmapFrame(QPainter& painter, const QRect& blit
     painter.setWorldMatrixEnabled(false);
 
     currentBitmapPainter.setOpacity(paintedImage->getOpacity() - (1.0-painter.opacity()));
-    currentBitmapPainter.drawImage(paintedImage->topLeft(), *paintedImage->image());
+    paintBitmapImage(currentBitmapPainter, paintedImage);
 
     if (isCurrentLayer && isDrawing)
     {
@@ -372,20 +507,59 @@ void CanvasPainter::paintCurrentVectorFrame(QPainter& painter, const QRect& blit
     painter.drawPixmap(mPointZero, mCurrentLayerPixmap);
 }
 
-void CanvasPainter::paintTransformedSelection(QPainter& painter, BitmapImage* bitmapImage, const QRect& selection) const
+void CanvasPainter::updateSelectionCache(BitmapImage* bitmapImage, const QRect& selection)
 {
-    // Make sure there is something selected
-    if (selection.width() == 0 && selection.height() == 0)
+    const QImage* image = bitmapImage->image();
+    const QPoint origin = bitmapImage->topLeft();
+    if (!mSelectionCache.isNull() && mSelectionCacheRect == selection &&
+        mSelectionCacheKey == image->cacheKey() && mSelectionCacheOrigin == origin)
+    {
         return;
+    }
 
-    QPixmap transformedPixmap = QPixmap(mSelection.size());
-    transformedPixmap.fill(Qt::transparent);
+    mSelectionCache = QPixmap(selection.size());
+    mSelectionCache.fill(Qt::transparent);
 
-    QPainter imagePainter(&transformedPixmap);
+    QPainter imagePainter(&mSelectionCache);
     imagePainter.translate(-selection.topLeft());
-    imagePainter.drawImage(bitmapImage->topLeft(), *bitmapImage->image());
+    imagePainter.drawImage(origin, *image);
     imagePainter.end();
 
+    mSelectionCacheRect = selection;
+    mSelectionCacheKey = image->cacheKey();
+    mSelectionCacheOrigin = origin;
+    mSelectionProxy = QPixmap();
+}
+
+void CanvasPainter::paintTransformedSelection(QPainter& painter, BitmapImage* bitmapImage, const QRect& selection)
+{
+    // Make sure there is something selected
+    if (selection.width() == 0 && selection.height() == 0)
+        return;
+
+    updateSelectionCache(bitmapImage, selection);
+
+    // The transform only changes between repaints while a handle is being dragged,
+    // the repaint after releasing it draws the full resolution content again.
+    const bool isDragging = mSelectionTransform != mLastPaintedSelectionTransform;
+    mLastPaintedSelectionTransform = mSelectionTransform;
+
+    const QTransform selectionToScreen = mSelectionTransform * mViewTransform;
+    const qreal screenScale = qSqrt(qAbs(selectionToScreen.determinant())) * mCanvas.devicePixelRatioF();
+
+    const QPixmap* selectionPixmap = &mSelectionCache;
+    if (isDragging && screenScale < 0.5)
+    {
+        // Smallest power of two downscale that still covers the pixels on screen
+        const qreal proxyScale = qPow(2.0, qCeil(std::log2(qMax(screenScale, 1.0 / 16))));
+        if (mSelectionProxy.isNull() || !qFuzzyCompare(mSelectionProxyScale, proxyScale))
+        {
+            mSelectionProxy = mSelectionCache.scaled(mSelectionCache.size() * proxyScale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            mSelectionProxyScale = proxyScale;
+        }
+        selectionPixmap = &mSelectionProxy;
+    }
+
     painter.save();
 
     painter.setTransform(mViewTransform);
@@ -401,7 +575,8 @@ void CanvasPainter::paintTransformedSelection(QPainter& painter, BitmapImage* bi
     painter.setTransform(mSelectionTransform*mViewTransform);
 
     // Draw the selection image separately and on top
-    painter.drawPixmap(selection, transformedPixmap);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, !isDragging);
+    painter.drawPixmap(QRectF(selection), *selectionPixmap, QRectF(selectionPixmap->rect()));
     painter.restore();
 }
 
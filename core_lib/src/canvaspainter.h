@@ -18,7 +18,9 @@ GNU General Public License for more details.
 #define CANVASPAINTER_H
 
 #include <memory>
+#include <functional>
 #include <QCoreApplication>
+#include <QHash>
 #include <QObject>
 #include <QTransform>
 #include <QPainter>
@@ -34,7 +36,9 @@ GNU General Public License for more details.
 class TiledBuffer;
 class Object;
 class BitmapImage;
+class KeyFrame;
 class ViewManager;
+class RenderStats;
 
 struct CanvasPainterOptions
 {
@@ -69,6 +73,13 @@ public:
     void paint(const QRect& blitRect);
     void paintCached(const QRect& blitRect);
     void resetLayerCache();
+    void clearOnionSkinCache();
+
+    /** Times the onion skin and counts cache hits into @p stats, null to stop recording */
+    void setRenderStats(RenderStats* stats) { mRenderStats = stats; }
+
+    /** Bytes held by the cached layer and selection pixmaps */
+    quint64 memoryUsage() const;
 
 private:
 
@@ -81,19 +92,55 @@ private:
      */
     void initializePainter(QPainter& painter, QPaintDevice& device, const QRect& blitRect);
 
-    void paintOnionSkinOnLayer(QPainter& painter, const QRect& blitRect, Layer* layer);
-    void paintOnionSkin(QPainter& painter, const QRect& blitRect);
+    void paintOnionSkinOnLayer(QPainter& painter, Layer* layer);
+    void paintOnionSkin(QPainter& painter);
 
     void renderPostLayers(QPainter& painter, const QRect& blitRect);
     void renderPreLayers(QPainter& painter, const QRect& blitRect);
 
     void paintCurrentFrame(QPainter& painter, const QRect& blitRect, int startLayer, int endLayer);
 
-    void paintTransformedSelection(QPainter& painter, BitmapImage* bitmapImage, const QRect& selection) const;
+    void paintTransformedSelection(QPainter& painter, BitmapImage* bitmapImage, const QRect& selection);
+    void updateSelectionCache(BitmapImage* bitmapImage, const QRect& selection);
+
+    void paintBitmapOnionSkinFrame(QPainter& painter, Layer* layer, int nFrame, bool colorize);
+    void paintVectorOnionSkinFrame(QPainter& painter, Layer* layer, int nFrame, bool colorize);
+
+    /**
+     * What an onion skin frame was rendered from, the cached render is reused while it stays the same.
+     * The tint depends on the distance to the current frame, so it is left out and applied on every draw.
+     */
+    struct OnionSkinSource
+    {
+        quint64 revision = 0;
+        qint64 imageKey = 0;
+        QRect bounds;
+
+        bool operator==(const OnionSkinSource& other) const
+        {
+            return revision == other.revision && imageKey == other.imageKey && bounds == other.bounds;
+        }
+    };
+    struct OnionSkinCacheEntry
+    {
+        OnionSkinSource source;
+        QPixmap pixmap;
+        QRect rect; // where the pixmap goes on the canvas
+        bool used = false;
+    };
+
+    /**
+     * Draws an onion skin frame from the cache, rendering it first if it is not cached yet or has changed.
+     * @param bounds The area covered by the frame in canvas coordinates, or a null rect for the whole view
+     * @param colorize Whether to tint the frame with the onion skin color of @p nFrame
+     * @param frameOpacity Sets how strongly the frame is tinted, the frame itself is drawn at the painter's opacity
+     * @param paintFrame Paints the frame with the view transform already set
+     */
+    void paintOnionSkinFrame(QPainter& painter, const KeyFrame* key, const OnionSkinSource& source, const QRectF& bounds,
+                             int nFrame, bool colorize, qreal frameOpacity, const std::function<void(QPainter&)>& paintFrame);
+    QColor onionSkinTint(int nFrame) const;
 
-    void paintBitmapOnionSkinFrame(QPainter& painter, const QRect& blitRect, Layer* layer, int nFrame, bool colorize);
-    void paintVectorOnionSkinFrame(QPainter& painter, const QRect& blitRect, Layer* layer, int nFrame, bool colorize);
-    void paintOnionSkinFrame(QPainter& painter, QPainter& onionSkinPainter, int nFrame, bool colorize, qreal frameOpacity);
+    void paintBitmapImage(QPainter& painter, BitmapImage* bitmapImage);
 
     void paintCurrentBitmapFrame(QPainter& painter, const QRect& blitRect, Layer* layer, bool isCurrentLayer);
     void paintCurrentVectorFrame(QPainter& painter, const QRect& blitRect, Layer* layer, bool isCurrentLayer);
@@ -116,11 +163,20 @@ private:
     QRect mSelection;
     QTransform mSelectionTransform;
 
+    // The selected pixels are extracted once per transformation and reused on every repaint,
+    // mSelectionProxy is a downscaled copy drawn while the transform is being dragged when zoomed out.
+    QPixmap mSelectionCache;
+    QPixmap mSelectionProxy;
+    QRect mSelectionCacheRect;
+    QPoint mSelectionCacheOrigin;
+    qint64 mSelectionCacheKey = 0;
+    qreal mSelectionProxyScale = 1.0;
+    QTransform mLastPaintedSelectionTransform;
+
     // Caches specifically for when drawing on the canvas
     QPixmap mPostLayersPixmap;
     QPixmap mPreLayersPixmap;
     QPixmap mCurrentLayerPixmap;
-    QPixmap mOnionSkinPixmap;
     bool mPreLayersPixmapCacheValid = false;
     bool mPostLayersPixmapCacheValid = false;
 
@@ -132,6 +188,16 @@ private:
     OnionSkinSubPainter mOnionSkinSubPainter;
     OnionSkinPainterOptions mOnionSkinPainterOptions;
 
+    // Onion skin frames are rendered and tinted once at the current view, then reused when the playhead moves.
+    // Entries that are not drawn in a pass are dropped at the end of it.
+    QHash<const KeyFrame*, OnionSkinCacheEntry> mOnionSkinCache;
+    QPixmap mOnionSkinTintPixmap; //< scratch space to tint a cached onion skin frame before drawing it
+    QTransform mOnionSkinCacheView;
+    QSize mOnionSkinCacheSize;
+    int mOnionSkinCacheFlags = 0;
+
+    RenderStats* mRenderStats = nullptr;
+
     const static int OVERLAY_SAFE_CENTER_CROSS_SIZE = 25;
 };
 
@@ -0,0 +1,517 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "gifencoder.h"
+
+#include <algorithm>
+#include <climits>
+#include <QDebug>
+
+namespace
+{
+    const uchar TRANSPARENT_INDEX = 255;
+    const int MIN_CODE_SIZE = 8;
+    const int MAX_CODE = 4095;
+
+    void appendUInt16(QByteArray& out, int value)
+    {
+        out.append(static_cast<char>(value & 0xFF));
+        out.append(static_cast<char>((value >> 8) & 0xFF));
+    }
+
+    inline int rgb15(QRgb c)
+    {
+        return ((qRed(c) >> 3) << 10) | ((qGreen(c) >> 3) << 5) | (qBlue(c) >> 3);
+    }
+
+    inline int expand5(int v)
+    {
+        return (v << 3) | (v >> 2);
+    }
+
+    /** Packs variable width LZW codes LSB first into 255 byte data sub-blocks. */
+    class LzwBitWriter
+    {
+    public:
+        explicit LzwBitWriter(QByteArray& out) : mOut(out) {}
+
+        void write(int code, int codeSize)
+        {
+            mBits |= static_cast<quint32>(code) << mBitCount;
+            mBitCount += codeSize;
+            while (mBitCount >= 8)
+            {
+                pushByte(static_cast<char>(mBits & 0xFF));
+                mBits >>= 8;
+                mBitCount -= 8;
+            }
+        }
+
+        void finish()
+        {
+            if (mBitCount > 0) pushByte(static_cast<char>(mBits & 0xFF));
+            flushBlock();
+            mOut.append('\0'); // block terminator
+        }
+
+    private:
+        void pushByte(char b)
+        {
+            mBlock.append(b);
+            if (mBlock.size() == 255) flushBlock();
+        }
+
+        void flushBlock()
+        {
+            if (mBlock.isEmpty()) return;
+            mOut.append(static_cast<char>(mBlock.size()));
+            mOut.append(mBlock);
+            mBlock.clear();
+        }
+
+        QByteArray& mOut;
+        QByteArray mBlock;
+        quint32 mBits = 0;
+        int mBitCount = 0;
+    };
+
+    /** Open addressing (prefix, byte) -> code table, cheap to reset when the dictionary fills up. */
+    class LzwTable
+    {
+    public:
+        LzwTable() : mKeys(TABLE_SIZE), mCodes(TABLE_SIZE) { clear(); }
+
+        void clear() { std::fill(mKeys.begin(), mKeys.end(), -1); }
+
+        int find(int key) const
+        {
+            int slot = hash(key);
+            while (mKeys[slot] != -1)
+            {
+                if (mKeys[slot] == key) return mCodes[slot];
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+            }
+            return -1;
+        }
+
+        void insert(int key, int code)
+        {
+            int slot = hash(key);
+            while (mKeys[slot] != -1) slot = (slot + 1) & (TABLE_SIZE - 1);
+            mKeys[slot] = key;
+            mCodes[slot] = static_cast<quint16>(code);
+        }
+
+    private:
+        static const int TABLE_SIZE = 8192;
+        static int hash(int key) { return (key * 2654435761u) >> 19 & (TABLE_SIZE - 1); }
+
+        std::vector<int> mKeys;
+        std::vector<quint16> mCodes;
+    };
+
+    struct ColorBox
+    {
+        int begin = 0;
+        int end = 0;
+        int channel = 0;
+        int range = 0;
+    };
+
+    inline int channelOf(int c15, int channel)
+    {
+        return (c15 >> (10 - channel * 5)) & 0x1F;
+    }
+
+    void measureBox(ColorBox& box, const std::vector<int>& colors)
+    {
+        int lo[3] = { 31, 31, 31 };
+        int hi[3] = { 0, 0, 0 };
+        for (int i = box.begin; i < box.end; i++)
+        {
+            for (int ch = 0; ch < 3; ch++)
+            {
+                const int v = channelOf(colors[i], ch);
+                lo[ch] = std::min(lo[ch], v);
+                hi[ch] = std::max(hi[ch], v);
+            }
+        }
+        box.range = -1;
+        for (int ch = 0; ch < 3; ch++)
+        {
+            if (hi[ch] - lo[ch] > box.range)
+            {
+                box.range = hi[ch] - lo[ch];
+                box.channel = ch;
+            }
+        }
+    }
+}
+
+GifEncoder::GifEncoder()
+{
+}
+
+GifEncoder::~GifEncoder()
+{
+    if (mFile.isOpen()) cancel();
+}
+
+Status GifEncoder::open(const QString& filePath, QSize size, const QVector<QRgb>& palette, bool loop)
+{
+    DebugDetails dd;
+    dd << "GifEncoder::open";
+    dd << QString("filePath = ").append(filePath);
+
+    Q_ASSERT(palette.size() <= TRANSPARENT_INDEX);
+
+    mFile.setFileName(filePath);
+    if (!mFile.open(QIODevice::WriteOnly))
+    {
+        dd << ("file.error() = " + mFile.errorString());
+        return Status(Status::FAIL, dd);
+    }
+
+    mSize = size;
+    mPalette = palette.mid(0, TRANSPARENT_INDEX);
+    mColorLookup.assign(1 << 15, -1);
+    mPrevious.clear();
+    mPendingFrame.clear();
+    mPendingDelay = 0;
+
+    QByteArray header("GIF89a");
+    appendUInt16(header, size.width());
+    appendUInt16(header, size.height());
+    header.append(static_cast<char>(0xF7)); // global color table of 256 entries
+    header.append('\0'); // background color index
+    header.append('\0'); // pixel aspect ratio
+    for (int i = 0; i < 256; i++)
+    {
+        const QRgb c = mPalette.value(i, qRgb(0, 0, 0));
+        header.append(static_cast<char>(qRed(c)));
+        header.append(static_cast<char>(qGreen(c)));
+        header.append(static_cast<char>(qBlue(c)));
+    }
+
+    if (loop)
+    {
+        header.append("\x21\xFF\x0B" "NETSCAPE2.0" "\x03\x01", 16);
+        appendUInt16(header, 0); // loop forever
+        header.append('\0');
+    }
+
+    if (mFile.write(header) != header.size())
+    {
+        dd << ("file.error() = " + mFile.errorString());
+        return Status(Status::FAIL, dd);
+    }
+    return Status::OK;
+}
+
+Status GifEncoder::addFrame(const QImage& frame, int delayCentiseconds)
+{
+    Q_ASSERT(frame.size() == mSize);
+    indexFrame(frame, mCurrent);
+
+    const int w = mSize.width();
+    const int h = mSize.height();
+    QRect changed(0, 0, w, h);
+
+    if (!mPrevious.empty())
+    {
+        int left = w, top = h, right = -1, bottom = -1;
+        for (int y = 0; y < h; y++)
+        {
+            const uchar* cur = mCurrent.data() + y * w;
+            const uchar* prev = mPrevious.data() + y * w;
+            int x0 = 0;
+            while (x0 < w && cur[x0] == prev[x0]) x0++;
+            if (x0 == w) continue;
+            int x1 = w - 1;
+            while (cur[x1] == prev[x1]) x1--;
+
+            left = std::min(left, x0);
+            right = std::max(right, x1);
+            top = std::min(top, y);
+            bottom = y;
+        }
+
+        if (right < 0)
+        {
+            // Identical to the previous frame, just show that one longer
+            mPendingDelay += delayCentiseconds;
+            return Status::OK;
+        }
+        changed = QRect(QPoint(left, top), QPoint(right, bottom));
+        writePendingFrame();
+    }
+
+    std::vector<uchar> indices(static_cast<size_t>(changed.width()) * changed.height());
+    uchar* dst = indices.data();
+    for (int y = changed.top(); y <= changed.bottom(); y++)
+    {
+        const uchar* cur = mCurrent.data() + y * w;
+        if (mPrevious.empty())
+        {
+            std::copy(cur + changed.left(), cur + changed.right() + 1, dst);
+            dst += changed.width();
+            continue;
+        }
+        const uchar* prev = mPrevious.data() + y * w;
+        for (int x = changed.left(); x <= changed.right(); x++)
+        {
+            *dst++ = (cur[x] == prev[x]) ? TRANSPARENT_INDEX : cur[x];
+        }
+    }
+
+    mPendingTransparent = !mPrevious.empty();
+    mPendingDelay = delayCentiseconds;
+    mPendingFrame.clear();
+    mPendingFrame.append(',');
+    appendUInt16(mPendingFrame, changed.left());
+    appendUInt16(mPendingFrame, changed.top());
+    appendUInt16(mPendingFrame, changed.width());
+    appendUInt16(mPendingFrame, changed.height());
+    mPendingFrame.append('\0'); // no local color table, not interlaced
+    writeLzw(indices);
+
+    std::swap(mPrevious, mCurrent);
+
+    if (mFile.error() != QFileDevice::NoError)
+    {
+        DebugDetails dd;
+        dd << "GifEncoder::addFrame";
+        dd << ("file.error() = " + mFile.errorString());
+        return Status(Status::FAIL, dd);
+    }
+    return Status::OK;
+}
+
+Status GifEncoder::close()
+{
+    writePendingFrame();
+    mFile.write(";", 1); // trailer
+
+    // Fails, and discards the file, if any write failed
+    const bool ok = mFile.commit();
+    QString error = mFile.errorString();
+    mPrevious.clear();
+    mCurrent.clear();
+
+    if (!ok)
+    {
+        DebugDetails dd;
+        dd << "GifEncoder::close";
+        dd << ("file.error() = " + error);
+        return Status(Status::FAIL, dd);
+    }
+    return Status::OK;
+}
+
+void GifEncoder::cancel()
+{
+    mFile.cancelWriting();
+    mFile.commit(); // only discards the temporary file once writing was cancelled
+    mPendingFrame.clear();
+    mPrevious.clear();
+    mCurrent.clear();
+}
+
+void GifEncoder::writePendingFrame()
+{
+    if (mPendingFrame.isEmpty()) return;
+
+    QByteArray control("\x21\xF9\x04", 3);
+    // disposal method 1 keeps the frame in place so the next one can draw over it
+    control.append(static_cast<char>((1 << 2) | (mPendingTransparent ? 1 : 0)));
+    appendUInt16(control, std::min(mPendingDelay, 0xFFFF));
+    control.append(static_cast<char>(TRANSPARENT_INDEX));
+    control.append('\0');
+
+    mFile.write(control);
+    mFile.write(mPendingFrame);
+    mPendingFrame.clear();
+}
+
+void GifEncoder::indexFrame(const QImage& frame, std::vector<uchar>& indices)
+{
+    const QImage rgb = (frame.format() == QImage::Format_RGB32) ? frame : frame.convertToFormat(QImage::Format_RGB32);
+    const int w = rgb.width();
+    indices.resize(static_cast<size_t>(w) * rgb.height());
+
+    uchar* dst = indices.data();
+    for (int y = 0; y < rgb.height(); y++)
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+        for (int x = 0; x < w; x++)
+        {
+            *dst++ = nearestIndex(line[x]);
+        }
+    }
+}
+
+uchar GifEncoder::nearestIndex(QRgb color)
+{
+    const int key = rgb15(color);
+    int& cached = mColorLookup[key];
+    if (cached >= 0) return static_cast<uchar>(cached);
+
+    const int r = expand5(key >> 10);
+    const int g = expand5((key >> 5) & 0x1F);
+    const int b = expand5(key & 0x1F);
+
+    int best = 0;
+    int bestDistance = INT_MAX;
+    for (int i = 0; i < mPalette.size(); i++)
+    {
+        const int dr = qRed(mPalette[i]) - r;
+        const int dg = qGreen(mPalette[i]) - g;
+        const int db = qBlue(mPalette[i]) - b;
+        const int distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    cached = best;
+    return static_cast<uchar>(best);
+}
+
+void GifEncoder::writeLzw(const std::vector<uchar>& indices)
+{
+    const int clearCode = 1 << MIN_CODE_SIZE;
+    mPendingFrame.append(static_cast<char>(MIN_CODE_SIZE));
+
+    LzwBitWriter writer(mPendingFrame);
+    LzwTable table;
+
+    int codeSize = MIN_CODE_SIZE + 1;
+    int maxCode = clearCode + 1;
+    writer.write(clearCode, codeSize);
+
+    int prefix = indices.empty() ? 0 : indices[0];
+    for (size_t i = 1; i < indices.size(); i++)
+    {
+        const int next = indices[i];
+        const int key = (prefix << 8) | next;
+        const int code = table.find(key);
+        if (code >= 0)
+        {
+            prefix = code;
+            continue;
+        }
+
+        writer.write(prefix, codeSize);
+        table.insert(key, ++maxCode);
+        if (maxCode >= (1 << codeSize))
+        {
+            codeSize++;
+        }
+        if (maxCode == MAX_CODE)
+        {
+            writer.write(clearCode, codeSize);
+            table.clear();
+            codeSize = MIN_CODE_SIZE + 1;
+            maxCode = clearCode + 1;
+        }
+        prefix = next;
+    }
+
+    writer.write(prefix, codeSize);
+    writer.write(clearCode, codeSize);
+    writer.write(clearCode + 1, MIN_CODE_SIZE + 1);
+    writer.finish();
+}
+
+QVector<QRgb> GifEncoder::buildPalette(const QVector<QImage>& samples, int maxColors)
+{
+    std::vector<quint32> histogram(1 << 15, 0);
+    for (const QImage& sample : samples)
+    {
+        const QImage rgb = sample.convertToFormat(QImage::Format_RGB32);
+        for (int y = 0; y < rgb.height(); y++)
+        {
+            const QRgb* line = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+            for (int x = 0; x < rgb.width(); x++)
+            {
+                histogram[rgb15(line[x])]++;
+            }
+        }
+    }
+
+    std::vector<int> colors;
+    for (int c = 0; c < (1 << 15); c++)
+    {
+        if (histogram[c] > 0) colors.push_back(c);
+    }
+    if (colors.empty()) return { qRgb(255, 255, 255) };
+
+    std::vector<ColorBox> boxes(1);
+    boxes[0].end = static_cast<int>(colors.size());
+    measureBox(boxes[0], colors);
+
+    while (static_cast<int>(boxes.size()) < maxColors)
+    {
+        auto widest = std::max_element(boxes.begin(), boxes.end(), [](const ColorBox& a, const ColorBox& b)
+        {
+            return a.range < b.range;
+        });
+        if (widest->range <= 0) break; // every box holds a single color
+
+        ColorBox box = *widest;
+        const int channel = box.channel;
+        std::sort(colors.begin() + box.begin, colors.begin() + box.end, [channel](int a, int b)
+        {
+            return channelOf(a, channel) < channelOf(b, channel);
+        });
+
+        // split at the pixel count median
+        quint64 total = 0;
+        for (int i = box.begin; i < box.end; i++) total += histogram[colors[i]];
+        quint64 acc = 0;
+        int split = box.begin + 1;
+        for (int i = box.begin; i < box.end - 1; i++)
+        {
+            acc += histogram[colors[i]];
+            split = i + 1;
+            if (acc * 2 >= total) break;
+        }
+
+        ColorBox lower = box, upper = box;
+        lower.end = split;
+        upper.begin = split;
+        measureBox(lower, colors);
+        measureBox(upper, colors);
+        *widest = lower;
+        boxes.push_back(upper);
+    }
+
+    QVector<QRgb> palette;
+    for (const ColorBox& box : boxes)
+    {
+        quint64 sum[3] = { 0, 0, 0 };
+        quint64 count = 0;
+        for (int i = box.begin; i < box.end; i++)
+        {
+            const quint64 n = histogram[colors[i]];
+            for (int ch = 0; ch < 3; ch++) sum[ch] += n * expand5(channelOf(colors[i], ch));
+            count += n;
+        }
+        palette.append(qRgb(static_cast<int>(sum[0] / count), static_cast<int>(sum[1] / count), static_cast<int>(sum[2] / count)));
+    }
+    return palette;
+}
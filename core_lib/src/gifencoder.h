@@ -0,0 +1,72 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef GIFENCODER_H
+#define GIFENCODER_H
+
+#include <vector>
+#include <QImage>
+#include <QSaveFile>
+#include <QVector>
+#include "pencilerror.h"
+
+/**
+ * Streams frames into an animated GIF with a fixed palette.
+ *
+ * Only the rectangle that changed since the previous frame is encoded, and pixels
+ * inside it that did not change are written as transparent so the previous frame
+ * shows through. Frames identical to the previous one extend its delay instead of
+ * being written again. Only two indexed frames are kept in memory at any time.
+ *
+ * The animation is written to a temporary file that only replaces the file at the
+ * output path once close() succeeds, so a cancelled or failed export leaves nothing behind.
+ */
+class GifEncoder
+{
+public:
+    GifEncoder();
+    ~GifEncoder();
+
+    Status open(const QString& filePath, QSize size, const QVector<QRgb>& palette, bool loop);
+    Status addFrame(const QImage& frame, int delayCentiseconds);
+    /** Finishes the animation and moves it to the output path */
+    Status close();
+    /** Throws the animation away, an existing file at the output path is left as it was */
+    void cancel();
+
+    /** Median cut palette of at most maxColors opaque colors, leaving room for the transparent index. */
+    static QVector<QRgb> buildPalette(const QVector<QImage>& samples, int maxColors = 255);
+
+private:
+    void indexFrame(const QImage& frame, std::vector<uchar>& indices);
+    uchar nearestIndex(QRgb color);
+    void writePendingFrame();
+    void writeLzw(const std::vector<uchar>& indices);
+
+    QSaveFile mFile;
+    QSize mSize;
+    QVector<QRgb> mPalette;
+    std::vector<int> mColorLookup; //< 15-bit rgb -> palette index, -1 until first used
+
+    std::vector<uchar> mPrevious;
+    std::vector<uchar> mCurrent;
+
+    QByteArray mPendingFrame; //< image descriptor and data of the last frame, written once its delay is known
+    bool mPendingTransparent = false;
+    int mPendingDelay = 0;
+};
+
+#endif // GIFENCODER_H
@@ -16,8 +16,10 @@ GNU General Public License for more details.
 */
 #include "bitmapbucket.h"
 
+#include <atomic>
 #include <QtMath>
 #include <QDebug>
+#include <QThreadPool>
 
 #include "editor.h"
 #include "layermanager.h"
@@ -32,8 +34,10 @@ BitmapBucket::BitmapBucket(Editor* editor,
                            QColor color,
                            QRect maxFillRegion,
                            QPointF fillPoint,
-                           BucketToolProperties properties):
+                           BucketToolProperties properties,
+                           BitmapBucketCache* cache):
     mEditor(editor),
+    mCache(cache),
     mMaxFillRegion(maxFillRegion),
     mProperties(properties)
 
@@ -52,10 +56,13 @@ BitmapBucket::BitmapBucket(Editor* editor,
 
     Q_ASSERT(mTargetFillToLayer);
 
+    BitmapBucketCache localCache;
+    if (cache == nullptr) { cache = &localCache; }
+
     BitmapImage singleLayerImage = *static_cast<BitmapImage*>(initialLayer->getLastKeyFrameAtPosition(frameIndex));
     if (properties.fillReferenceMode() == 1) // All layers
     {
-        mReferenceImage = flattenBitmapLayersToImage();
+        mReferenceImage = cache->flattenedImage(mEditor, frameIndex, initialLayerIndex);
     } else {
         mReferenceImage = singleLayerImage;
     }
@@ -82,7 +89,7 @@ bool BitmapBucket::canUseDragToFill(const QPoint& fillPoint, const QColor& bucke
     return true;
 }
 
-bool BitmapBucket::allowFill(const QPoint& checkPoint, const QRgb& checkColor) const
+bool BitmapBucket::allowFill(const QPoint& checkPoint, const QRgb& checkColor)
 {
     // A normal click to fill should happen unconditionally, because the alternative is utterly confusing.
     if (!mFilledOnce) {
@@ -92,14 +99,12 @@ bool BitmapBucket::allowFill(const QPoint& checkPoint, const QRgb& checkColor) c
     return allowContinuousFill(checkPoint, checkColor);
 }
 
-bool BitmapBucket::allowContinuousFill(const QPoint& checkPoint, const QRgb& checkColor) const
+bool BitmapBucket::allowContinuousFill(const QPoint& checkPoint, const QRgb& checkColor)
 {
     if (!mUseDragToFill) {
         return false;
     }
 
-    const QRgb& colorOfReferenceImage = mReferenceImage.constScanLine(checkPoint.x(), checkPoint.y());
-
     if (checkColor == mBucketColor && (mProperties.fillMode() == 1 || qAlpha(checkColor) == 255))
     {
         // Avoid filling if target pixel color matches fill color
@@ -107,10 +112,30 @@ bool BitmapBucket::allowContinuousFill(const QPoint& checkPoint, const QRgb& che
         return false;
     }
 
-    return BitmapImage::compareColor(colorOfReferenceImage, mStartReferenceColor, mTolerance, mPixelCache) &&
+    return referenceMatches(checkPoint) &&
            (checkColor == 0 || BitmapImage::compareColor(checkColor, mStartReferenceColor, mTolerance, mPixelCache));
 }
 
+bool BitmapBucket::referenceMatches(const QPoint& point)
+{
+    if (!mReferenceMaskBuilt)
+    {
+        // Dragging checks the reference at every point it passes, so it's worked out for all pixels at once
+        BitmapBucketCache localCache;
+        BitmapBucketCache* cache = mCache ? mCache : &localCache;
+        mReferenceMask = cache->matchMask(mReferenceImage, mStartReferenceColor, mTolerance);
+        mReferenceMaskBounds = mReferenceImage.bounds();
+        mTransparentMatches = BitmapImage::compareColor(0, mStartReferenceColor, mTolerance, mPixelCache);
+        mReferenceMaskBuilt = true;
+    }
+
+    if (!mReferenceMaskBounds.contains(point)) {
+        return mTransparentMatches;
+    }
+    const QPoint offset = point - mReferenceMaskBounds.topLeft();
+    return mReferenceMask.testBit(offset.y() * mReferenceMaskBounds.width() + offset.x());
+}
+
 void BitmapBucket::paint(const QPointF& updatedPoint, std::function<void(BucketState, int, int)> state)
 {
     const int currentFrameIndex = mEditor->currentFrame();
@@ -131,18 +156,6 @@ void BitmapBucket::paint(const QPointF& updatedPoint, std::function<void(BucketS
         return;
     }
 
-    QRgb fillColor = mBucketColor;
-    if (mProperties.fillMode() == 1)
-    {
-        // Pass a fully opaque version of the new color to floodFill
-        // This is required so we can fully mask out the existing data before
-        // writing the new color.
-        QColor tempColor;
-        tempColor.setRgba(fillColor);
-        tempColor.setAlphaF(1);
-        fillColor = tempColor.rgba();
-    }
-
     BitmapImage* replaceImage = nullptr;
 
     int expandValue = mProperties.fillExpandEnabled() ? mProperties.fillExpandAmount() : 0;
@@ -150,7 +163,7 @@ void BitmapBucket::paint(const QPointF& updatedPoint, std::function<void(BucketS
                            &mReferenceImage,
                            mMaxFillRegion,
                            point,
-                           fillColor,
+                           fillColor(),
                            mTolerance,
                            expandValue);
 
@@ -162,6 +175,162 @@ void BitmapBucket::paint(const QPointF& updatedPoint, std::function<void(BucketS
 
     state(BucketState::WillFillTarget, mTargetFillToLayerIndex, currentFrameIndex);
 
+    const qint64 keyBeforeFill = targetImage->image()->cacheKey();
+    applyFill(targetImage, replaceImage);
+    if (mCache && mProperties.fillReferenceMode() != 1)
+    {
+        // The target is its own reference, so the mask of the next press only has to match the filled pixels again
+        mCache->updateMask(keyBeforeFill, *targetImage, replaceImage->bounds());
+    }
+    delete replaceImage;
+
+    state(BucketState::DidFillTarget, mTargetFillToLayerIndex, currentFrameIndex);
+    mFilledOnce = true;
+}
+
+int BitmapBucket::paintFrames(const QPointF& point,
+                              const QList<int>& frames,
+                              std::function<void(BucketState, int, int)> state,
+                              std::function<bool(int, int)> progress)
+{
+    struct FrameFill
+    {
+        int frame = 0;
+        QPoint seed;
+        BitmapImage referenceImage;
+        BitmapImage* replaceImage = nullptr;
+    };
+
+    const QPoint pressPoint(qFloor(point.x()), qFloor(point.y()));
+    LayerBitmap* layer = static_cast<LayerBitmap*>(mTargetFillToLayer);
+
+    // Reading the layers may load images from disk, so it's done here rather than in the workers
+    std::vector<FrameFill> fills;
+    fills.reserve(static_cast<size_t>(frames.size()));
+    for (int frame : frames)
+    {
+        BitmapImage* targetImage = layer->getBitmapImageAtFrame(frame);
+        if (targetImage == nullptr) { continue; }
+        targetImage->loadFile();
+
+        FrameFill fill;
+        fill.frame = frame;
+        fill.seed = pressPoint;
+        fill.referenceImage = referenceImageAtFrame(frame);
+        if (!findSeedPoint(fill.referenceImage, fill.seed)) { continue; }
+
+        // floodFill only searches this frame's own bounds and the camera, so a seed outside of both has nothing to fill
+        const QRect fillRegion = fill.referenceImage.bounds().adjusted(-1, -1, 1, 1).united(mMaxFillRegion);
+        if (!fillRegion.contains(fill.seed)) { continue; }
+        fills.push_back(fill);
+    }
+
+    const int total = static_cast<int>(fills.size());
+    const QRgb color = fillColor();
+    const int expandValue = mProperties.fillExpandEnabled() ? mProperties.fillExpandAmount() : 0;
+    std::atomic<int> done(0);
+
+    QThreadPool pool;
+    for (FrameFill& fill : fills)
+    {
+        FrameFill* f = &fill;
+        pool.start([this, f, color, expandValue, &done]
+        {
+            BitmapImage::floodFill(&f->replaceImage, &f->referenceImage, mMaxFillRegion, f->seed, color, mTolerance, expandValue);
+            done++;
+        });
+    }
+
+    bool cancelled = false;
+    while (!pool.waitForDone(50))
+    {
+        if (!cancelled && !progress(done, total))
+        {
+            cancelled = true;
+            pool.clear(); // drop the fills that haven't started yet
+        }
+    }
+    if (!cancelled)
+    {
+        cancelled = !progress(done, total);
+    }
+
+    int filledCount = 0;
+    for (FrameFill& fill : fills)
+    {
+        if (!cancelled && fill.replaceImage != nullptr)
+        {
+            state(BucketState::WillFillTarget, mTargetFillToLayerIndex, fill.frame);
+            applyFill(layer->getBitmapImageAtFrame(fill.frame), fill.replaceImage);
+            state(BucketState::DidFillTarget, mTargetFillToLayerIndex, fill.frame);
+            filledCount++;
+        }
+        delete fill.replaceImage;
+    }
+    return filledCount;
+}
+
+BitmapImage BitmapBucket::referenceImageAtFrame(int frame)
+{
+    if (mProperties.fillReferenceMode() == 1) // All layers
+    {
+        return flattenBitmapLayersToImage(frame);
+    }
+    return *static_cast<LayerBitmap*>(mTargetFillToLayer)->getLastBitmapImageAtFrame(frame);
+}
+
+/** Moves @p point to the closest pixel that matches the pressed reference color, within a few pixels.
+ *  @return false if there is none */
+bool BitmapBucket::findSeedPoint(const BitmapImage& referenceImage, QPoint& point) const
+{
+    const int searchRadius = 8;
+
+    auto matches = [&](const QPoint& p)
+    {
+        return BitmapImage::compareColor(referenceImage.constScanLine(p.x(), p.y()), mStartReferenceColor, mTolerance, mPixelCache);
+    };
+
+    if (matches(point)) { return true; }
+
+    for (int radius = 1; radius <= searchRadius; radius++)
+    {
+        for (int i = -radius; i <= radius; i++)
+        {
+            const QPoint candidates[] = {
+                point + QPoint(i, -radius), point + QPoint(i, radius),
+                point + QPoint(-radius, i), point + QPoint(radius, i)
+            };
+            for (const QPoint& candidate : candidates)
+            {
+                if (matches(candidate))
+                {
+                    point = candidate;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+QRgb BitmapBucket::fillColor() const
+{
+    QRgb fillColor = mBucketColor;
+    if (mProperties.fillMode() == 1)
+    {
+        // Pass a fully opaque version of the new color to floodFill
+        // This is required so we can fully mask out the existing data before
+        // writing the new color.
+        QColor tempColor;
+        tempColor.setRgba(fillColor);
+        tempColor.setAlphaF(1);
+        fillColor = tempColor.rgba();
+    }
+    return fillColor;
+}
+
+void BitmapBucket::applyFill(BitmapImage* targetImage, BitmapImage* replaceImage) const
+{
     if (mProperties.fillMode() == 0)
     {
         targetImage->paste(replaceImage);
@@ -182,16 +351,12 @@ void BitmapBucket::paint(const QPointF& updatedPoint, std::function<void(BucketS
     }
 
     targetImage->modification();
-    delete replaceImage;
-
-    state(BucketState::DidFillTarget, mTargetFillToLayerIndex, currentFrameIndex);
-    mFilledOnce = true;
 }
 
-BitmapImage BitmapBucket::flattenBitmapLayersToImage()
+BitmapImage BitmapBucket::flattenBitmapLayersToImage(int frame)
 {
     BitmapImage flattenImage = BitmapImage();
-    int currentFrame = mEditor->currentFrame();
+    int currentFrame = frame;
     auto layerMan = mEditor->layers();
     for (int i = 0; i < layerMan->count(); i++)
     {
@@ -207,3 +372,149 @@ BitmapImage BitmapBucket::flattenBitmapLayersToImage()
     }
     return flattenImage;
 }
+
+BitmapImage BitmapBucketCache::flattenedImage(Editor* editor, int frame, int targetLayerIndex)
+{
+    QVector<BitmapImage*> below;
+    QVector<BitmapImage*> above;
+    BitmapImage* target = nullptr;
+
+    auto layerMan = editor->layers();
+    for (int i = 0; i < layerMan->count(); i++)
+    {
+        Layer* layer = layerMan->getLayer(i);
+        Q_ASSERT(layer);
+        if (layer->type() != Layer::BITMAP || !layer->visible()) { continue; }
+
+        BitmapImage* image = static_cast<LayerBitmap*>(layer)->getLastBitmapImageAtFrame(frame);
+        if (image == nullptr) { continue; }
+
+        if (i < targetLayerIndex) {
+            below.append(image);
+        } else if (i > targetLayerIndex) {
+            above.append(image);
+        } else {
+            target = image;
+        }
+    }
+
+    QVector<BitmapImage*> all = below;
+    if (target) { all.append(target); }
+    all.append(above);
+
+    const QVector<Source> sources = sourcesOf(all);
+    if (sources == mFlattened.sources) {
+        return mFlattened.image;
+    }
+
+    // Layers are pasted with source over, which can be grouped, so the parts that didn't change are reused as a whole
+    BitmapImage flattened = composite(mBelow, below);
+    if (target) {
+        flattened.paste(target);
+    }
+    BitmapImage aboveImage = composite(mAbove, above);
+    flattened.paste(&aboveImage);
+    flattened.autoCrop(); // Cropped once here rather than on every copy handed out
+
+    mFlattened.sources = sources;
+    mFlattened.image = flattened;
+    return flattened;
+}
+
+QBitArray BitmapBucketCache::matchMask(BitmapImage& referenceImage, QRgb color, int tolerance)
+{
+    const QRect bounds = referenceImage.bounds();
+    const QImage* image = referenceImage.image();
+
+    if (image->cacheKey() == mMaskCacheKey && bounds == mMaskBounds &&
+        color == mMaskColor && tolerance == mMaskTolerance) {
+        return mMask;
+    }
+
+    QBitArray mask(bounds.width() * bounds.height());
+    QHash<QRgb, bool> pixelCache;
+    for (int y = 0; y < bounds.height(); y++)
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image->constScanLine(y));
+        for (int x = 0; x < bounds.width(); x++)
+        {
+            if (BitmapImage::compareColor(line[x], color, tolerance, &pixelCache)) {
+                mask.setBit(y * bounds.width() + x);
+            }
+        }
+    }
+
+    mMaskCacheKey = image->cacheKey();
+    mMaskBounds = bounds;
+    mMaskColor = color;
+    mMaskTolerance = tolerance;
+    mMask = mask;
+    return mask;
+}
+
+void BitmapBucketCache::updateMask(qint64 previousKey, BitmapImage& referenceImage, const QRect& changedRect)
+{
+    const QRect bounds = referenceImage.bounds();
+    const QImage* image = referenceImage.image();
+
+    if (previousKey != mMaskCacheKey || bounds != mMaskBounds) {
+        // Not the image the mask was built from, or the fill grew it, the mask is built again when needed
+        return;
+    }
+
+    const QRect rect = changedRect.intersected(bounds).translated(-bounds.topLeft());
+    QHash<QRgb, bool> pixelCache;
+    for (int y = rect.top(); y <= rect.bottom(); y++)
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image->constScanLine(y));
+        for (int x = rect.left(); x <= rect.right(); x++)
+        {
+            mMask.setBit(y * bounds.width() + x, BitmapImage::compareColor(line[x], mMaskColor, mMaskTolerance, &pixelCache));
+        }
+    }
+    mMaskCacheKey = image->cacheKey();
+}
+
+void BitmapBucketCache::clear()
+{
+    mBelow = Composite();
+    mAbove = Composite();
+    mFlattened = Composite();
+    mMaskCacheKey = 0;
+    mMaskBounds = QRect();
+    mMaskTolerance = -1;
+    mMask.clear();
+}
+
+QVector<BitmapBucketCache::Source> BitmapBucketCache::sourcesOf(const QVector<BitmapImage*>& images)
+{
+    QVector<Source> sources;
+    sources.reserve(images.size());
+    for (BitmapImage* image : images)
+    {
+        Source source;
+        source.image = image;
+        source.bounds = image->bounds(); // Crops first, so the key doesn't change when the image is pasted
+        source.cacheKey = image->image()->cacheKey();
+        sources.append(source);
+    }
+    return sources;
+}
+
+BitmapImage BitmapBucketCache::composite(Composite& composite, const QVector<BitmapImage*>& images)
+{
+    const QVector<Source> sources = sourcesOf(images);
+    if (sources == composite.sources) {
+        return composite.image;
+    }
+
+    BitmapImage image;
+    for (BitmapImage* source : images)
+    {
+        image.paste(source);
+    }
+    image.autoCrop();
+    composite.sources = sources;
+    composite.image = image;
+    return image;
+}
@@ -21,6 +21,7 @@ GNU General Public License for more details.
 #include "basetool.h"
 
 #include <functional>
+#include <QBitArray>
 
 class Layer;
 class Editor;
@@ -31,11 +32,67 @@ enum class BucketState
     DidFillTarget, // After calling floodfill and applied to target
 };
 
+/** Keeps what the bucket compares against between fills, so clicking region after region doesn't start over each time.
+ *
+ *  Compositing every layer is the slow part of filling with the "all layers" reference, so the layers below and above
+ *  the filled one are composited separately and only redone when one of their images change.
+ */
+class BitmapBucketCache
+{
+public:
+    /** @return the composite of all visible bitmap layers at @p frame */
+    BitmapImage flattenedImage(Editor* editor, int frame, int targetLayerIndex);
+
+    /** @return one bit per pixel within the bounds of @p referenceImage, set where it matches @p color within @p tolerance */
+    QBitArray matchMask(BitmapImage& referenceImage, QRgb color, int tolerance);
+
+    /**
+     * Carries the last mask over a fill of @p referenceImage, which had the cache key @p previousKey before,
+     * by only matching the pixels in @p changedRect again. Filling region after region keeps the mask this way.
+     */
+    void updateMask(qint64 previousKey, BitmapImage& referenceImage, const QRect& changedRect);
+
+    void clear();
+
+private:
+    struct Source
+    {
+        const BitmapImage* image = nullptr;
+        qint64 cacheKey = 0;
+        QRect bounds;
+
+        bool operator==(const Source& other) const
+        {
+            return image == other.image && cacheKey == other.cacheKey && bounds == other.bounds;
+        }
+    };
+
+    struct Composite
+    {
+        QVector<Source> sources;
+        BitmapImage image;
+    };
+
+    static QVector<Source> sourcesOf(const QVector<BitmapImage*>& images);
+    BitmapImage composite(Composite& composite, const QVector<BitmapImage*>& images);
+
+    Composite mBelow;
+    Composite mAbove;
+    Composite mFlattened;
+
+    qint64 mMaskCacheKey = 0;
+    QRect mMaskBounds;
+    QRgb mMaskColor = 0;
+    int mMaskTolerance = -1;
+    QBitArray mMask;
+};
+
 class BitmapBucket
 {
 public:
     explicit BitmapBucket();
-    explicit BitmapBucket(Editor* editor, QColor color, QRect maxFillRegion, QPointF fillPoint, BucketToolProperties properties);
+    explicit BitmapBucket(Editor* editor, QColor color, QRect maxFillRegion, QPointF fillPoint, BucketToolProperties properties,
+                          BitmapBucketCache* cache = nullptr);
 
     /** Will paint at the given point, given that it makes sense.. canUse is always called prior to painting
      *
@@ -45,6 +102,23 @@ public:
      */
     void paint(const QPointF& updatedPoint, std::function<void(BucketState, int, int)> progress);
 
+    /** Fills at the given point on each of the given keyframes of the target layer, as a click on each of them would.
+     *  The reference images are prepared and the fills applied on the calling thread, while the flood fills themselves
+     *  run concurrently. If the point is on a line in a frame, the fill starts from the closest pixel matching the
+     *  pressed color instead, so it keeps tracking the region while it moves a little between drawings.
+     *
+     * @param point - the point where to fill
+     * @param frames - the keyframe positions to fill
+     * @param state - called before and after each keyframe is filled, with the layer and frame affected
+     * @param progress - called with the number of frames done and the total while filling, return false to cancel.
+     * When cancelled, none of the frames are changed.
+     * @return the number of frames filled
+     */
+    int paintFrames(const QPointF& point,
+                    const QList<int>& frames,
+                    std::function<void(BucketState, int, int)> state,
+                    std::function<bool(int, int)> progress);
+
 private:
 
 
@@ -57,20 +131,33 @@ private:
      * @param checkPoint
      * @return True if you are allowed to fill, otherwise false
      */
-    bool allowFill(const QPoint& checkPoint, const QRgb& checkColor) const;
-    bool allowContinuousFill(const QPoint& checkPoint, const QRgb& checkColor) const;
+    bool allowFill(const QPoint& checkPoint, const QRgb& checkColor);
+    bool allowContinuousFill(const QPoint& checkPoint, const QRgb& checkColor);
+
+    /** Whether the reference image matches the color pressed at the given point.
+     *  The mask is only built once a drag needs it, so plain clicks don't pay for it. */
+    bool referenceMatches(const QPoint& point);
 
     /** Determines whether fill to drag feature can be used */
     bool canUseDragToFill(const QPoint& fillPoint, const QColor& bucketColor, const BitmapImage& referenceImage);
 
-    BitmapImage flattenBitmapLayersToImage();
+    BitmapImage flattenBitmapLayersToImage(int frame);
+    BitmapImage referenceImageAtFrame(int frame);
+    bool findSeedPoint(const BitmapImage& referenceImage, QPoint& point) const;
+    QRgb fillColor() const;
+    void applyFill(BitmapImage* targetImage, BitmapImage* replaceImage) const;
 
     Editor* mEditor = nullptr;
     Layer* mTargetFillToLayer = nullptr;
+    BitmapBucketCache* mCache = nullptr;
 
     QHash<QRgb, bool> *mPixelCache;
 
     BitmapImage mReferenceImage;
+    QBitArray mReferenceMask;
+    QRect mReferenceMaskBounds;
+    bool mReferenceMaskBuilt = false;
+    bool mTransparentMatches = false;
     QRgb mBucketColor = 0;
     QRgb mStartReferenceColor = 0;
 
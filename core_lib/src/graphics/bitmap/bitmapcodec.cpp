@@ -0,0 +1,291 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "bitmapcodec.h"
+
+#include <climits>
+#include <cstring>
+#include <QFile>
+#include <QtEndian>
+
+namespace
+{
+    const quint8 OP_INDEX = 0x00; // 00xxxxxx: index into the table of recent pixels
+    const quint8 OP_DIFF = 0x40;  // 01rrggbb: each channel differs by -2..1 from the previous pixel
+    const quint8 OP_LUMA = 0x80;  // 10gggggg rrrrbbbb: green differs by -32..31, red and blue by -8..7 more than green
+    const quint8 OP_RUN = 0xC0;   // 11xxxxxx: the previous pixel repeated 1..62 times
+    const quint8 OP_RGB = 0xFE;   // followed by red, green and blue, alpha is kept
+    const quint8 OP_RGBA = 0xFF;  // followed by red, green, blue and alpha
+    const quint8 OP_MASK = 0xC0;
+
+    const int MAX_RUN = 62;
+    const int MAX_BYTES_PER_PIXEL = 5;
+
+    inline int hashIndex(QRgb p)
+    {
+        return (qRed(p) * 3 + qGreen(p) * 5 + qBlue(p) * 7 + qAlpha(p) * 11) % 64;
+    }
+
+    bool readHeader(const uchar* data, int size, QRect& bounds)
+    {
+        if (size < BitmapCodec::HEADER_SIZE || memcmp(data, BitmapCodec::MAGIC, BitmapCodec::MAGIC_SIZE) != 0)
+            return false;
+
+        const uchar* p = data + BitmapCodec::MAGIC_SIZE;
+        const quint16 version = qFromLittleEndian<quint16>(p);
+        if (version > BitmapCodec::VERSION)
+            return false;
+        p += 2;
+
+        const qint32 x = qFromLittleEndian<qint32>(p);
+        const qint32 y = qFromLittleEndian<qint32>(p + 4);
+        const qint32 width = qFromLittleEndian<qint32>(p + 8);
+        const qint32 height = qFromLittleEndian<qint32>(p + 12);
+        if (width <= 0 || height <= 0 || static_cast<qint64>(width) * height > INT_MAX / 4)
+            return false;
+
+        bounds = QRect(x, y, width, height);
+        return true;
+    }
+}
+
+QByteArray BitmapCodec::encode(const QImage& source, const QPoint& topLeft)
+{
+    const QImage image = (source.format() == QImage::Format_ARGB32_Premultiplied)
+        ? source : source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int width = image.width();
+    const int height = image.height();
+
+    QByteArray data(HEADER_SIZE, Qt::Uninitialized);
+    uchar* header = reinterpret_cast<uchar*>(data.data());
+    memcpy(header, MAGIC, MAGIC_SIZE);
+    qToLittleEndian<quint16>(VERSION, header + MAGIC_SIZE);
+    qToLittleEndian<qint32>(topLeft.x(), header + MAGIC_SIZE + 2);
+    qToLittleEndian<qint32>(topLeft.y(), header + MAGIC_SIZE + 6);
+    qToLittleEndian<qint32>(width, header + MAGIC_SIZE + 10);
+    qToLittleEndian<qint32>(height, header + MAGIC_SIZE + 14);
+
+    QRgb index[64] = {};
+    QRgb prev = 0;
+    int run = 0;
+    int size = HEADER_SIZE;
+
+    for (int y = 0; y < height; ++y)
+    {
+        // Room for the worst case of this row plus a run left over from the previous one
+        data.resize(size + width * MAX_BYTES_PER_PIXEL + 1);
+        uchar* const begin = reinterpret_cast<uchar*>(data.data());
+        uchar* out = begin + size;
+
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x)
+        {
+            const QRgb px = line[x];
+            if (px == prev)
+            {
+                if (++run == MAX_RUN)
+                {
+                    *out++ = OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                *out++ = OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            const int hash = hashIndex(px);
+            if (index[hash] == px)
+            {
+                *out++ = OP_INDEX | hash;
+            }
+            else
+            {
+                index[hash] = px;
+
+                if (qAlpha(px) == qAlpha(prev))
+                {
+                    const signed char vr = static_cast<signed char>(qRed(px) - qRed(prev));
+                    const signed char vg = static_cast<signed char>(qGreen(px) - qGreen(prev));
+                    const signed char vb = static_cast<signed char>(qBlue(px) - qBlue(prev));
+                    const int vgr = vr - vg;
+                    const int vgb = vb - vg;
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                    {
+                        *out++ = OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2);
+                    }
+                    else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+                    {
+                        *out++ = OP_LUMA | (vg + 32);
+                        *out++ = static_cast<uchar>(((vgr + 8) << 4) | (vgb + 8));
+                    }
+                    else
+                    {
+                        *out++ = OP_RGB;
+                        *out++ = static_cast<uchar>(qRed(px));
+                        *out++ = static_cast<uchar>(qGreen(px));
+                        *out++ = static_cast<uchar>(qBlue(px));
+                    }
+                }
+                else
+                {
+                    *out++ = OP_RGBA;
+                    *out++ = static_cast<uchar>(qRed(px));
+                    *out++ = static_cast<uchar>(qGreen(px));
+                    *out++ = static_cast<uchar>(qBlue(px));
+                    *out++ = static_cast<uchar>(qAlpha(px));
+                }
+            }
+            prev = px;
+        }
+        size = static_cast<int>(out - begin);
+    }
+
+    if (run > 0)
+    {
+        data.resize(size + 1);
+        data[size++] = static_cast<char>(OP_RUN | (run - 1));
+    }
+    data.resize(size);
+    return data;
+}
+
+QImage BitmapCodec::decode(const QByteArray& data, QRect* bounds)
+{
+    const uchar* in = reinterpret_cast<const uchar*>(data.constData());
+    const uchar* const end = in + data.size();
+
+    QRect rect;
+    if (!readHeader(in, data.size(), rect))
+        return QImage();
+    in += HEADER_SIZE;
+
+    QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+        return QImage();
+
+    QRgb index[64] = {};
+    QRgb px = 0;
+    int run = 0;
+
+    for (int y = 0; y < rect.height(); ++y)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < rect.width(); ++x)
+        {
+            if (run > 0)
+            {
+                --run;
+                line[x] = px;
+                continue;
+            }
+
+            if (in >= end)
+                return QImage();
+
+            const quint8 b1 = *in++;
+            if (b1 == OP_RGB)
+            {
+                if (end - in < 3)
+                    return QImage();
+                px = qRgba(in[0], in[1], in[2], qAlpha(px));
+                in += 3;
+            }
+            else if (b1 == OP_RGBA)
+            {
+                if (end - in < 4)
+                    return QImage();
+                px = qRgba(in[0], in[1], in[2], in[3]);
+                in += 4;
+            }
+            else
+            {
+                switch (b1 & OP_MASK)
+                {
+                case OP_INDEX:
+                    px = index[b1];
+                    break;
+                case OP_DIFF:
+                    px = qRgba((qRed(px) + ((b1 >> 4) & 0x03) - 2) & 0xFF,
+                               (qGreen(px) + ((b1 >> 2) & 0x03) - 2) & 0xFF,
+                               (qBlue(px) + (b1 & 0x03) - 2) & 0xFF,
+                               qAlpha(px));
+                    break;
+                case OP_LUMA:
+                {
+                    if (in >= end)
+                        return QImage();
+                    const quint8 b2 = *in++;
+                    const int vg = (b1 & 0x3F) - 32;
+                    px = qRgba((qRed(px) + vg - 8 + ((b2 >> 4) & 0x0F)) & 0xFF,
+                               (qGreen(px) + vg) & 0xFF,
+                               (qBlue(px) + vg - 8 + (b2 & 0x0F)) & 0xFF,
+                               qAlpha(px));
+                    break;
+                }
+                default: // OP_RUN
+                    run = b1 & 0x3F;
+                    break;
+                }
+            }
+
+            index[hashIndex(px)] = px;
+            line[x] = px;
+        }
+    }
+
+    if (bounds)
+        *bounds = rect;
+    return image;
+}
+
+bool BitmapCodec::isEncoded(const QByteArray& data)
+{
+    return data.startsWith(QByteArray::fromRawData(MAGIC, MAGIC_SIZE));
+}
+
+bool BitmapCodec::writeFile(const QString& filePath, const QImage& image, const QPoint& topLeft)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    const QByteArray data = encode(image, topLeft);
+    return file.write(data) == data.size();
+}
+
+bool BitmapCodec::readFile(const QString& filePath, QImage& image)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly) || !isEncoded(file.peek(MAGIC_SIZE)))
+        return false;
+
+    image = decode(file.readAll());
+    return true;
+}
+
+bool BitmapCodec::readBounds(const QString& filePath, QRect& bounds)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    const QByteArray header = file.read(HEADER_SIZE);
+    return readHeader(reinterpret_cast<const uchar*>(header.constData()), header.size(), bounds);
+}
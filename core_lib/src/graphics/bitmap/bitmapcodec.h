@@ -0,0 +1,68 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#ifndef BITMAPCODEC_H
+#define BITMAPCODEC_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QRect>
+
+/**
+ * A fast lossless keyframe format for bitmap layers, meant for storage inside a project only.
+ * PNG remains the format used for interchange.
+ *
+ * Layout (little-endian):
+ *   "P2DB" magic, quint16 version, qint32 x, y, width, height of the keyframe bounds,
+ *   then the pixels row by row.
+ *
+ * Pixels are kept premultiplied, exactly as Format_ARGB32_Premultiplied holds them in memory,
+ * and are packed with the QOI operations: runs of the previous pixel, references into a table
+ * of 64 recently seen pixels, small per channel differences and full pixels.
+ * The previous pixel starts out transparent, so the empty space around line art collapses into runs.
+ */
+namespace BitmapCodec
+{
+    const char MAGIC[] = "P2DB";
+    const int MAGIC_SIZE = 4;
+    const quint16 VERSION = 1;
+    const int HEADER_SIZE = MAGIC_SIZE + 2 + 4 * 4;
+
+    /** File suffix of keyframes saved in this format */
+    const char SUFFIX[] = "pbi";
+
+    QByteArray encode(const QImage& image, const QPoint& topLeft);
+
+    /**
+     * @return The image in Format_ARGB32_Premultiplied, or a null image if @p data is not valid
+     * @param bounds Receives the keyframe bounds stored in the header, if not null
+     */
+    QImage decode(const QByteArray& data, QRect* bounds = nullptr);
+
+    bool isEncoded(const QByteArray& data);
+
+    bool writeFile(const QString& filePath, const QImage& image, const QPoint& topLeft);
+
+    /**
+     * Loads @p filePath into @p image if the file is in this format.
+     * @return False if the file is in another format, in which case @p image is untouched
+     */
+    bool readFile(const QString& filePath, QImage& image);
+
+    /** Reads only the bounds stored in the header of @p filePath */
+    bool readBounds(const QString& filePath, QRect& bounds);
+}
+
+#endif // BITMAPCODEC_H
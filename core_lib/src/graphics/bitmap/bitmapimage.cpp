@@ -16,6 +16,7 @@ GNU General Public License for more details.
 */
 #include "bitmapimage.h"
 
+#include <cmath>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -24,9 +25,42 @@ GNU General Public License for more details.
 #include <QPainterPath>
 #include "util.h"
 
+#include "bitmapcodec.h"
 #include "blitrect.h"
 #include "tile.h"
 #include "tiledbuffer.h"
+#include "tracer.h"
+
+namespace
+{
+    /** Halves a premultiplied image, each pixel being the average of the 2x2 block it covers */
+    QImage halfSize(const QImage& source)
+    {
+        const int width = qMax(1, (source.width() + 1) / 2);
+        const int height = qMax(1, (source.height() + 1) / 2);
+        const int lastX = source.width() - 1;
+        const int lastY = source.height() - 1;
+
+        QImage result(width, height, QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < height; y++)
+        {
+            const QRgb* row0 = reinterpret_cast<const QRgb*>(source.constScanLine(qMin(2 * y, lastY)));
+            const QRgb* row1 = reinterpret_cast<const QRgb*>(source.constScanLine(qMin(2 * y + 1, lastY)));
+            QRgb* out = reinterpret_cast<QRgb*>(result.scanLine(y));
+            for (int x = 0; x < width; x++)
+            {
+                const int x0 = qMin(2 * x, lastX);
+                const int x1 = qMin(2 * x + 1, lastX);
+                const QRgb a = row0[x0], b = row0[x1], c = row1[x0], d = row1[x1];
+                out[x] = qRgba((qRed(a) + qRed(b) + qRed(c) + qRed(d) + 2) >> 2,
+                               (qGreen(a) + qGreen(b) + qGreen(c) + qGreen(d) + 2) >> 2,
+                               (qBlue(a) + qBlue(b) + qBlue(c) + qBlue(d) + 2) >> 2,
+                               (qAlpha(a) + qAlpha(b) + qAlpha(c) + qAlpha(d) + 2) >> 2);
+            }
+        }
+        return result;
+    }
+}
 
 BitmapImage::BitmapImage()
 {
@@ -131,17 +165,38 @@ void BitmapImage::loadFile()
 {
     if (!fileName().isEmpty() && !isLoaded())
     {
-        mImage = QImage(fileName()).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        TRACE_SCOPE("frames", "BitmapImage::loadFile");
+        loadFile(decodeFile(fileName()));
+    }
+}
+
+void BitmapImage::loadFile(const QImage& decodedImage)
+{
+    if (!fileName().isEmpty() && !isLoaded())
+    {
+        mImage = decodedImage;
         mBounds.setSize(mImage.size());
         mMinBound = false;
     }
 }
 
+QImage BitmapImage::decodeFile(const QString& filePath)
+{
+    QImage image;
+    if (!BitmapCodec::readFile(filePath, image))
+    {
+        image = QImage(filePath).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    return image;
+}
+
 void BitmapImage::unloadFile()
 {
     if (isModified() == false)
     {
+        TRACE_SCOPE("frames", "BitmapImage::unloadFile");
         mImage = QImage();
+        mMipmaps.clear();
     }
 }
 
@@ -150,8 +205,10 @@ bool BitmapImage::isLoaded() const
     return mImage.width() == mBounds.width();
 }
 
-quint64 BitmapImage::memoryUsage()
+quint64 BitmapImage::memoryUsage() const
 {
+    // The mipmap levels are left out: they're built long after the frame pool took the size
+    // of the frame, and at most add a third of the image, which the pool's budget absorbs
     if (!mImage.isNull())
     {
         return imageSize(mImage);
@@ -177,6 +234,31 @@ QImage* BitmapImage::image()
     return &mImage;
 }
 
+const QImage& BitmapImage::mipmap(qreal scale)
+{
+    loadFile();
+    if (scale > 0.5 || scale <= 0 || mImage.isNull())
+    {
+        return mImage;
+    }
+
+    if (mMipmapImageKey != mImage.cacheKey())
+    {
+        mMipmaps.clear();
+        mMipmapImageKey = mImage.cacheKey();
+    }
+
+    // The smallest level that still has at least as many pixels as the screen shows
+    const int level = static_cast<int>(std::floor(std::log2(1.0 / scale))) - 1;
+    while (mMipmaps.size() <= level)
+    {
+        const QImage& previous = mMipmaps.isEmpty() ? mImage : mMipmaps.last();
+        if (previous.width() <= 1 && previous.height() <= 1) { break; }
+        mMipmaps.append(halfSize(previous));
+    }
+    return mMipmaps.isEmpty() ? mImage : mMipmaps[qMin(level, mMipmaps.size() - 1)];
+}
+
 BitmapImage BitmapImage::copy()
 {
     return BitmapImage(mBounds.topLeft(), *image());
@@ -786,13 +868,24 @@ BitmapImage* BitmapImage::scanToTransparent(BitmapImage *img, const int threshol
     return img;
 }
 
-Status BitmapImage::writeFile(const QString& filename)
+Status BitmapImage::writeFile(const QString& filename, const QString& format) const
 {
+    TRACE_SCOPE("frames", "BitmapImage::writeFile");
     DebugDetails dd;
     dd << "BitmapImage::writeFile";
     dd << QString("&nbsp;&nbsp;filename = ").append(filename);
+    dd << QString("&nbsp;&nbsp;format = ").append(format);
 
-    QImageWriter writer(filename);
+    if (!mImage.isNull() && format == "PBI")
+    {
+        if (BitmapCodec::writeFile(filename, mImage, mBounds.topLeft())) {
+            return Status::OK;
+        }
+        dd << "&nbsp;&nbsp;Error: Unable to write the file";
+        return Status(Status::FAIL, dd);
+    }
+
+    QImageWriter writer(filename, format.toLatin1());
     if (!mImage.isNull())
     {
         bool b = writer.write(mImage);
@@ -804,7 +897,7 @@ Status BitmapImage::writeFile(const QString& filename)
         }
     }
 
-    if (bounds().isEmpty())
+    if (mBounds.isEmpty())
     {
         QFile f(filename);
         if(f.exists())
@@ -815,10 +908,6 @@ Status BitmapImage::writeFile(const QString& filename)
                 return Status::FAIL;
             }
         }
-
-        // The frame is likely empty, act like there's no file name
-        // so we don't end up writing to it later.
-        setFileName("");
     }
     return Status::SAFE;
 }
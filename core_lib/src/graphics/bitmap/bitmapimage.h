@@ -21,6 +21,7 @@ GNU General Public License for more details.
 #include "keyframe.h"
 #include <QtMath>
 #include <QHash>
+#include <QVector>
 
 class TiledBuffer;
 
@@ -44,9 +45,11 @@ public:
 
     BitmapImage* clone() const override;
     void loadFile() override;
+    /** Takes @p decodedImage as the content of fileName(), e.g. when it was decoded ahead on another thread */
+    void loadFile(const QImage& decodedImage);
     void unloadFile() override;
     bool isLoaded() const override;
-    quint64 memoryUsage() override;
+    quint64 memoryUsage() const override;
 
     void paintImage(QPainter& painter);
     void paintImage(QPainter &painter, QImage &image, QRect sourceRect, QRect destRect);
@@ -54,6 +57,13 @@ public:
     QImage* image();
     void    setImage(QImage* pImg);
 
+    /**
+     * The image downsampled for drawing at @p scale, e.g. on a zoomed out canvas.
+     * Each level halves the previous one with a box filter. Levels are built on first use
+     * and rebuilt once the image has changed. Scales above 1/2 get the image itself.
+     */
+    const QImage& mipmap(qreal scale);
+
     BitmapImage copy();
     BitmapImage copy(QRect rectangle);
     void paste(BitmapImage*, QPainter::CompositionMode cm = QPainter::CompositionMode_SourceOver);
@@ -127,7 +137,17 @@ public:
     void setOpacity(qreal opacity) { mOpacity = opacity; }
     qreal getOpacity() const { return mOpacity; }
 
-    Status writeFile(const QString& filename);
+    /**
+     * @param format "PNG", or "PBI" for the fast keyframe format of BitmapCodec.
+     * Both are recognized by loadFile().
+     *
+     * The image is written as it is, without cropping it first, so that several keyframes
+     * can be written from worker threads at once. An empty image removes the file instead.
+     */
+    Status writeFile(const QString& filename, const QString& format = "PNG") const;
+
+    /** Reads a keyframe file in either format into Format_ARGB32_Premultiplied. Safe to call from any thread. */
+    static QImage decodeFile(const QString& filePath);
 
     /** Compare colors for the purposes of flood filling
      *
@@ -183,6 +203,10 @@ private:
     QImage mImage;
     QRect mBounds{0, 0, 0, 0};
 
+    /** Level n is 1/2^(n+1) of mImage, valid while mImage keeps mMipmapImageKey */
+    QVector<QImage> mMipmaps;
+    qint64 mMipmapImageKey = 0;
+
     /** @see isMinimallyBounded() */
     bool mMinBound = true;
     bool mEnableAutoCrop = false;
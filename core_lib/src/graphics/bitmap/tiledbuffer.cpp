@@ -20,6 +20,7 @@ GNU General Public License for more details.
 #include <QtMath>
 
 #include "tile.h"
+#include "memoryreport.h"
 
 TiledBuffer::TiledBuffer(QObject* parent) : QObject(parent)
 {
@@ -158,6 +159,16 @@ void TiledBuffer::drawPath(QPainterPath path, QPen pen, QBrush brush,
     }
 }
 
+quint64 TiledBuffer::memoryUsage() const
+{
+    quint64 bytes = 0;
+    for (const Tile* tile : mTiles)
+    {
+        bytes += MemoryReport::pixmapBytes(tile->pixmap());
+    }
+    return bytes;
+}
+
 void TiledBuffer::clear()
 {
     QHashIterator<TileIndex, Tile*> i(mTiles);
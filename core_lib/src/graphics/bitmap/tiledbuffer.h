@@ -71,6 +71,9 @@ public:
 
     const QRect& bounds() const { return mTileBounds; }
 
+    /** Bytes held by the pixmaps of the tiles */
+    quint64 memoryUsage() const;
+
 signals:
     void tileUpdated(TiledBuffer* tiledBuffer, Tile* tile);
     void tileCreated(TiledBuffer* tiledBuffer, Tile* tile);
@@ -18,8 +18,10 @@ GNU General Public License for more details.
 
 #include "bezierarea.h"
 #include "pencilerror.h"
+#include "vectorbinary.h"
 
 #include <QXmlStreamWriter>
+#include <QXmlStreamReader>
 #include <QDomElement>
 
 BezierArea::BezierArea()
@@ -51,7 +53,7 @@ void BezierArea::setSelected(bool YesOrNo)
     mSelected = YesOrNo;
 }
 
-Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream )
+Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream ) const
 {
     xmlStream.writeStartElement( "area" );
     xmlStream.writeAttribute( "colourNumber", QString::number( mColorNumber ) );
@@ -105,3 +107,50 @@ void BezierArea::loadDomElement(const QDomElement& element)
         vertexTag = vertexTag.nextSibling();
     }
 }
+
+void BezierArea::loadXmlStream(QXmlStreamReader& xmlStream)
+{
+    mColorNumber = xmlStream.attributes().value("colourNumber").toInt();
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("vertex"))
+        {
+            const QXmlStreamAttributes attrs = xmlStream.attributes();
+            mVertex.append( VertexRef(attrs.value("curve").toInt(), attrs.value("vertex").toInt()) );
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
+void BezierArea::writeBinary(QDataStream& stream) const
+{
+    VectorBinary::writeVarInt(stream, mColorNumber);
+    stream << static_cast<quint8>(mIsFilled);
+
+    VectorBinary::writeVarUInt(stream, static_cast<quint64>(mVertex.size()));
+    int previousCurve = 0;
+    for (const VertexRef& ref : mVertex)
+    {
+        VectorBinary::writeVarInt(stream, ref.curveNumber - previousCurve);
+        VectorBinary::writeVarInt(stream, ref.vertexNumber);
+        previousCurve = ref.curveNumber;
+    }
+}
+
+void BezierArea::loadBinary(QDataStream& stream)
+{
+    mColorNumber = static_cast<int>(VectorBinary::readVarInt(stream));
+    quint8 filled = 0;
+    stream >> filled;
+    mIsFilled = filled != 0;
+
+    const quint64 vertexCount = VectorBinary::readVarUInt(stream);
+    int curveNumber = 0;
+    for (quint64 i = 0; i < vertexCount && stream.status() == QDataStream::Ok; i++)
+    {
+        curveNumber += static_cast<int>(VectorBinary::readVarInt(stream));
+        int vertexNumber = static_cast<int>(VectorBinary::readVarInt(stream));
+        mVertex.append(VertexRef(curveNumber, vertexNumber));
+    }
+}
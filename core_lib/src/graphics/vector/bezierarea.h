@@ -24,7 +24,9 @@ GNU General Public License for more details.
 
 class Status;
 class QXmlStreamWriter;
+class QXmlStreamReader;
 class QDomElement;
+class QDataStream;
 
 
 class BezierArea
@@ -33,8 +35,11 @@ public:
     BezierArea();
     BezierArea(QList<VertexRef> vertexList, int color);
 
-    Status createDomElement(QXmlStreamWriter& xmlStream);
+    Status createDomElement(QXmlStreamWriter& xmlStream) const;
     void loadDomElement(const QDomElement& element);
+    void loadXmlStream(QXmlStreamReader& xmlStream);
+    void writeBinary(QDataStream& stream) const;
+    void loadBinary(QDataStream& stream);
 
     VertexRef getVertexRef(int i);
     int getColorNumber() { return mColorNumber; }
@@ -20,11 +20,13 @@ GNU General Public License for more details.
 #include <cmath>
 #include <QList>
 #include <QXmlStreamWriter>
+#include <QXmlStreamReader>
 #include <QDomElement>
 #include <QDebug>
 #include <QPainterPath>
 #include "object.h"
 #include "pencilerror.h"
+#include "vectorbinary.h"
 
 
 BezierCurve::BezierCurve()
@@ -84,7 +86,7 @@ BezierCurve::BezierCurve(const QList<QPointF>& pointList, const QList<qreal>& pr
 }
 
 
-Status BezierCurve::createDomElement( QXmlStreamWriter& xmlStream )
+Status BezierCurve::createDomElement( QXmlStreamWriter& xmlStream ) const
 {
     xmlStream.writeStartElement( "curve" );
     xmlStream.writeAttribute( "width", QString::number( width ) );
@@ -155,6 +157,7 @@ void BezierCurve::loadDomElement(const QDomElement& element)
 
     colorNumber = element.attribute("colourNumber").toInt();
     origin = QPointF( element.attribute("originX").toFloat(), element.attribute("originY").toFloat() );
+    invalidatePaths();
     pressure.append( element.attribute("originPressure").toFloat() );
     selected.append(false);
 
@@ -177,10 +180,109 @@ void BezierCurve::loadDomElement(const QDomElement& element)
     }
 }
 
+/**
+ * Reads a curve from a stream positioned on a <curve> start element.
+ * The reader is left on the matching end element.
+ */
+void BezierCurve::loadXmlStream(QXmlStreamReader& xmlStream)
+{
+    const QXmlStreamAttributes attrs = xmlStream.attributes();
+    width = attrs.value("width").toDouble();
+    variableWidth = (attrs.value("variableWidth") == QLatin1String("1")) || (attrs.value("variableWidth") == QLatin1String("true"));
+    feather = attrs.value("feather").toDouble();
+    invisible = (attrs.value("invisible") == QLatin1String("1")) || (attrs.value("invisible") == QLatin1String("true"));
+    mFilled = (attrs.value("filled") == QLatin1String("1")) || (attrs.value("filled") == QLatin1String("true"));
+    if (width == 0) invisible = true;
+
+    colorNumber = attrs.value("colourNumber").toInt();
+    origin = QPointF( attrs.value("originX").toFloat(), attrs.value("originY").toFloat() );
+    invalidatePaths();
+    pressure.append( attrs.value("originPressure").toFloat() );
+    selected.append(false);
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("segment"))
+        {
+            const QXmlStreamAttributes segment = xmlStream.attributes();
+            QPointF c1Point = QPointF(segment.value("c1x").toFloat(), segment.value("c1y").toFloat());
+            QPointF c2Point = QPointF(segment.value("c2x").toFloat(), segment.value("c2y").toFloat());
+            QPointF vertexPoint = QPointF(segment.value("vx").toFloat(), segment.value("vy").toFloat());
+            qreal pressureValue = segment.value("pressure").toFloat();
+            appendCubic(c1Point, c2Point, vertexPoint, pressureValue);
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
+
+/**
+ * Writes the curve in the compact binary vector format, see vectorbinary.h.
+ * Points are quantized and delta encoded along the curve.
+ */
+void BezierCurve::writeBinary(QDataStream& stream) const
+{
+    quint8 flags = 0;
+    if (variableWidth) flags |= 0x1;
+    if (invisible) flags |= 0x2;
+    if (mFilled) flags |= 0x4;
+    stream << flags;
+    VectorBinary::writeVarInt(stream, colorNumber);
+    stream << width << feather;
+
+    qint64 previous[2] = { 0, 0 };
+    VectorBinary::writePoint(stream, origin, previous);
+
+    VectorBinary::writeVarUInt(stream, static_cast<quint64>(vertex.size()));
+    qint64 previousPressure = VectorBinary::quantize(pressure.value(0), VectorBinary::PRESSURE_SCALE);
+    VectorBinary::writeVarInt(stream, previousPressure);
+    for (int i = 0; i < vertex.size(); i++)
+    {
+        const qint64 p = VectorBinary::quantize(pressure.value(i + 1), VectorBinary::PRESSURE_SCALE);
+        VectorBinary::writeVarInt(stream, p - previousPressure);
+        previousPressure = p;
+
+        VectorBinary::writePoint(stream, c1.at(i), previous);
+        VectorBinary::writePoint(stream, c2.at(i), previous);
+        VectorBinary::writePoint(stream, vertex.at(i), previous);
+    }
+}
+
+void BezierCurve::loadBinary(QDataStream& stream)
+{
+    quint8 flags = 0;
+    stream >> flags;
+    variableWidth = flags & 0x1;
+    invisible = flags & 0x2;
+    mFilled = flags & 0x4;
+    colorNumber = static_cast<int>(VectorBinary::readVarInt(stream));
+    stream >> width >> feather;
+    if (width == 0) invisible = true;
+
+    qint64 previous[2] = { 0, 0 };
+    origin = VectorBinary::readPoint(stream, previous);
+    invalidatePaths();
+
+    const quint64 segmentCount = VectorBinary::readVarUInt(stream);
+    qint64 previousPressure = VectorBinary::readVarInt(stream);
+    pressure.append(previousPressure / VectorBinary::PRESSURE_SCALE);
+    selected.append(false);
+
+    for (quint64 i = 0; i < segmentCount && stream.status() == QDataStream::Ok; i++)
+    {
+        previousPressure += VectorBinary::readVarInt(stream);
+        QPointF c1Point = VectorBinary::readPoint(stream, previous);
+        QPointF c2Point = VectorBinary::readPoint(stream, previous);
+        QPointF vertexPoint = VectorBinary::readPoint(stream, previous);
+        appendCubic(c1Point, c2Point, vertexPoint, previousPressure / VectorBinary::PRESSURE_SCALE);
+    }
+}
+
 
 void BezierCurve::setOrigin(const QPointF& point)
 {
     origin = point;
+    invalidatePaths();
 }
 
 void BezierCurve::setOrigin(const QPointF& point, const qreal& pressureValue, const bool& trueOrFalse)
@@ -188,6 +290,7 @@ void BezierCurve::setOrigin(const QPointF& point, const qreal& pressureValue, co
     origin = point;
     pressure[0] = pressureValue;
     selected[0] = trueOrFalse;
+    invalidatePaths();
 }
 
 void BezierCurve::setC1(int i, const QPointF& point)
@@ -195,6 +298,7 @@ void BezierCurve::setC1(int i, const QPointF& point)
     if ( i >= 0 || i < c1.size() )
     {
         c1[i] = point;
+        invalidatePaths();
     }
     else
     {
@@ -207,6 +311,7 @@ void BezierCurve::setC2(int i, const QPointF& point)
     if ( i >= 0 || i < c2.size() )
     {
         c2[i] = point;
+        invalidatePaths();
     }
     else
     {
@@ -219,10 +324,12 @@ void BezierCurve::setVertex(int i, const QPointF& point)
     if (i == -1)
     {
         origin = point;
+        invalidatePaths();
     }
     else if (i >= 0 && i < vertex.size())
     {
         vertex[i] = point;
+        invalidatePaths();
     }
     else
     {
@@ -235,6 +342,7 @@ void BezierCurve::setLastVertex(const QPointF& point)
     if (vertex.size() > 0)
     {
         vertex[vertex.size()-1] = point;
+        invalidatePaths();
     }
     else
     {
@@ -246,16 +354,19 @@ void BezierCurve::setLastVertex(const QPointF& point)
 void BezierCurve::setWidth(qreal desiredWidth)
 {
     width = desiredWidth;
+    invalidatePaths();
 }
 
 void BezierCurve::setFeather(qreal desiredFeather)
 {
     feather = desiredFeather;
+    invalidatePaths();
 }
 
 void BezierCurve::setVariableWidth(bool YesOrNo)
 {
     variableWidth = YesOrNo;
+    invalidatePaths();
 }
 
 void BezierCurve::setInvisibility(bool YesOrNo)
@@ -324,6 +435,7 @@ void BezierCurve::transform(QTransform transformation)
             vertex[i] = transformation.map(vertex.at(i));
         }
     }
+    invalidatePaths();
     //smoothCurve();
 }
 
@@ -334,6 +446,7 @@ void BezierCurve::appendCubic(const QPointF& c1Point, const QPointF& c2Point, co
     vertex.append(vertexPoint);
     pressure.append(pressureValue);
     selected.append(false);
+    invalidatePaths();
 }
 
 void BezierCurve::addPoint(int position, const QPointF point)
@@ -353,6 +466,7 @@ void BezierCurve::addPoint(int position, const QPointF point)
         vertex.insert(position, point);
         pressure.insert(position, getPressure(position));
         selected.insert(position, isSelected(position) && isSelected(position-1));
+        invalidatePaths();
 
         //smoothCurve();
     }
@@ -388,6 +502,7 @@ void BezierCurve::addPoint(int position, const qreal fraction) // fraction is wh
         vertex.insert(position, vM);
         pressure.insert(position, getPressure(position));
         selected.insert(position, isSelected(position) && isSelected(position-1));
+        invalidatePaths();
 
         //smoothCurve();
     }
@@ -426,6 +541,7 @@ void BezierCurve::removeVertex(int i)
                 c1.removeAt(i);
             }
         }
+        invalidatePaths();
     }
 }
 
@@ -433,15 +549,20 @@ void BezierCurve::drawPath(QPainter& painter, const Object& object, QTransform t
 {
     QColor color = object.getColor(colorNumber).color;
 
-    BezierCurve myCurve;
-    if (isPartlySelected()) { myCurve = (transformed(transformation)); }
-    else { myCurve = *this; }
+    // Only a selected curve is drawn transformed, the others are drawn with their cached paths
+    BezierCurve transformedCurve;
+    BezierCurve* myCurve = this;
+    if (isPartlySelected())
+    {
+        transformedCurve = transformed(transformation);
+        myCurve = &transformedCurve;
+    }
 
     if ( variableWidth && !simplified && !invisible)
     {
         painter.setPen(QPen(QBrush(color), 1, Qt::NoPen, Qt::RoundCap,Qt::RoundJoin));
         painter.setBrush(color);
-        painter.drawPath(myCurve.getStrokedPath());
+        painter.drawPath(myCurve->getStrokedPath());
     }
     else
     {
@@ -478,8 +599,7 @@ void BezierCurve::drawPath(QPainter& painter, const Object& object, QTransform t
             painter.setPen( QPen( QBrush( color ), renderedWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin ) );
             //painter.setPen( QPen( Qt::darkYellow , 5, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin ) );
         }
-        QPainterPath path = myCurve.getSimplePath();
-        painter.drawPath( path );
+        painter.drawPath(myCurve->getSimplePath());
     }
 
     if (!simplified)
@@ -490,7 +610,7 @@ void BezierCurve::drawPath(QPainter& painter, const Object& object, QTransform t
         qreal lineWidth = 1.5/painter.worldTransform().m11();
         lineWidth = fabs(lineWidth); // make sure line width is positive, otherwise nothing is drawn
         painter.setPen(QPen(QBrush(color), lineWidth, Qt::SolidLine, Qt::RoundCap,Qt::RoundJoin));
-        if (isSelected()) painter.drawPath(myCurve.getSimplePath());
+        if (isSelected()) painter.drawPath(myCurve->getSimplePath());
 
 
         for(int i=-1; i< vertex.size(); i++)
@@ -528,18 +648,30 @@ QPainterPath BezierCurve::getStraightPath()
 // With bezier curve fitting
 QPainterPath BezierCurve::getSimplePath()
 {
+    if (mSimplePathValid)
+    {
+        return mSimplePath;
+    }
+
     QPainterPath path;
     path.moveTo(origin);
     for(int i=0; i<vertex.size(); i++)
     {
         path.cubicTo(c1.at(i), c2.at(i), vertex.at(i));
     }
+    mSimplePath = path;
+    mSimplePathValid = true;
     return path;
 }
 
 QPainterPath BezierCurve::getStrokedPath()
 {
-    return getStrokedPath( width );
+    if (!mStrokedPathValid)
+    {
+        mStrokedPath = getStrokedPath( width );
+        mStrokedPathValid = true;
+    }
+    return mStrokedPath;
 }
 
 QPainterPath BezierCurve::getStrokedPath(qreal width)
@@ -621,8 +753,20 @@ QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
 
 QRectF BezierCurve::getBoundingRect()
 {
-    qreal radius = getWidth() / 2;
-    return getSimplePath().boundingRect().adjusted(-radius, -radius, radius, radius);
+    if (!mBoundingRectValid)
+    {
+        qreal radius = getWidth() / 2;
+        mBoundingRect = getSimplePath().boundingRect().adjusted(-radius, -radius, radius, radius);
+        mBoundingRectValid = true;
+    }
+    return mBoundingRect;
+}
+
+void BezierCurve::invalidatePaths()
+{
+    mSimplePathValid = false;
+    mStrokedPathValid = false;
+    mBoundingRectValid = false;
 }
 
 void BezierCurve::createCurve(const QList<QPointF>& pointList, const QList<qreal>& pressureList, bool smooth)
@@ -656,6 +800,7 @@ void BezierCurve::createCurve(const QList<QPointF>& pointList, const QList<qreal
     }
     //colorNumber = 0;
     feather = 0;
+    invalidatePaths();
 }
 
 
@@ -702,6 +847,7 @@ void BezierCurve::smoothCurve()
         this->c1[n-1] = c2old;
         this->c2[n-1] = 0.5*(c2old+vertex.at(n-1));
     }
+    invalidatePaths();
 }
 
 void BezierCurve::simplify(double tol, const QList<QPointF>& inputList, int j, int k, QList<bool>& markList)
@@ -17,11 +17,14 @@ GNU General Public License for more details.
 #define BEZIERCURVE_H
 
 #include <QPainter>
+#include <QPainterPath>
 
 class Object;
 class Status;
 class QXmlStreamWriter;
+class QXmlStreamReader;
 class QDomElement;
+class QDataStream;
 
 struct Intersection
 {
@@ -37,8 +40,11 @@ public:
     explicit BezierCurve(const QList<QPointF>& pointList, bool smooth=true);
     explicit BezierCurve(const QList<QPointF>& pointList, const QList<qreal>& pressureList, double tol, bool smooth=true);
 
-    Status createDomElement(QXmlStreamWriter &xmlStream);
+    Status createDomElement(QXmlStreamWriter &xmlStream) const;
     void loadDomElement(const QDomElement& element);
+    void loadXmlStream(QXmlStreamReader& xmlStream);
+    void writeBinary(QDataStream& stream) const;
+    void loadBinary(QDataStream& stream);
 
     qreal getWidth() const { return width; }
     qreal getFeather() const { return feather; }
@@ -103,6 +109,9 @@ public:
     static bool findIntersection(BezierCurve curve1, int i1, BezierCurve curve2, int i2, QList<Intersection>& intersections); //finds the intersection between two cubic sections
 
 private:
+    /** Drops the cached paths, to be called whenever the points, pressure or width change */
+    void invalidatePaths();
+
     QPointF origin;
     QList<QPointF> c1;
     QList<QPointF> c2;
@@ -115,6 +124,14 @@ private:
     bool invisible = false;
     bool mFilled = false;
     QList<bool> selected; // this list has one more element than the other list (the first element is for the origin)
+
+    // Built on first use and kept until the curve changes, painting rebuilds them otherwise
+    QPainterPath mSimplePath;
+    QPainterPath mStrokedPath;
+    QRectF mBoundingRect;
+    bool mSimplePathValid = false;
+    bool mStrokedPathValid = false;
+    bool mBoundingRectValid = false;
 };
 
 #endif
@@ -0,0 +1,102 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#ifndef VECTORBINARY_H
+#define VECTORBINARY_H
+
+#include <cmath>
+#include <QDataStream>
+#include <QPointF>
+
+/**
+ * Helpers for the compact binary vector keyframe format.
+ *
+ * Layout (little-endian):
+ *   "P2DV" magic, quint16 version,
+ *   varint curve count, curves..., varint area count, areas...
+ *
+ * Coordinates are quantized to 1/COORD_SCALE pixel and stored as zigzag varints,
+ * each point being a delta from the previous vertex of the same curve.
+ */
+namespace VectorBinary
+{
+    const char MAGIC[] = "P2DV";
+    const int MAGIC_SIZE = 4;
+    const quint16 VERSION = 1;
+
+    const qreal COORD_SCALE = 64.0;
+    const qreal PRESSURE_SCALE = 4096.0;
+
+    inline qint64 quantize(qreal value, qreal scale)
+    {
+        return static_cast<qint64>(std::llround(value * scale));
+    }
+
+    inline void writeVarUInt(QDataStream& stream, quint64 value)
+    {
+        while (value >= 0x80)
+        {
+            stream << static_cast<quint8>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        stream << static_cast<quint8>(value);
+    }
+
+    inline quint64 readVarUInt(QDataStream& stream)
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            quint8 byte = 0;
+            stream >> byte;
+            value |= static_cast<quint64>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0 || stream.status() != QDataStream::Ok)
+                break;
+        }
+        return value;
+    }
+
+    inline void writeVarInt(QDataStream& stream, qint64 value)
+    {
+        // zigzag so that small negative deltas stay small
+        writeVarUInt(stream, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+    }
+
+    inline qint64 readVarInt(QDataStream& stream)
+    {
+        quint64 value = readVarUInt(stream);
+        return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+    }
+
+    /** Writes @p point as a quantized delta from @p previous, which is then advanced to the stored point. */
+    inline void writePoint(QDataStream& stream, const QPointF& point, qint64 previous[2])
+    {
+        const qint64 x = quantize(point.x(), COORD_SCALE);
+        const qint64 y = quantize(point.y(), COORD_SCALE);
+        writeVarInt(stream, x - previous[0]);
+        writeVarInt(stream, y - previous[1]);
+        previous[0] = x;
+        previous[1] = y;
+    }
+
+    inline QPointF readPoint(QDataStream& stream, qint64 previous[2])
+    {
+        previous[0] += readVarInt(stream);
+        previous[1] += readVarInt(stream);
+        return QPointF(previous[0] / COORD_SCALE, previous[1] / COORD_SCALE);
+    }
+}
+
+#endif // VECTORBINARY_H
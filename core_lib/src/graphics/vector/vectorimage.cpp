@@ -17,13 +17,18 @@ GNU General Public License for more details.
 #include "vectorimage.h"
 
 #include <cmath>
+#include <cstring>
 #include <QImage>
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QXmlStreamWriter>
+#include <QXmlStreamReader>
+#include <QDataStream>
 #include "object.h"
 #include "util.h"
+#include "vectorbinary.h"
+#include "tracer.h"
 
 
 VectorImage::VectorImage()
@@ -43,6 +48,24 @@ VectorImage::~VectorImage()
 {
 }
 
+quint64 VectorImage::totalMemoryUsage() const
+{
+    // Every vertex has two control points, a pressure and a selection flag
+    const quint64 vertexSize = 3 * sizeof(QPointF) + sizeof(float) + sizeof(bool);
+    const quint64 pathElementSize = sizeof(QPainterPath::Element);
+
+    quint64 bytes = mGetStrokedPath.elementCount() * pathElementSize;
+    for (const BezierCurve& curve : mCurves)
+    {
+        bytes += sizeof(BezierCurve) + (curve.getVertexSize() + 1) * vertexSize;
+    }
+    for (const BezierArea& area : mArea)
+    {
+        bytes += sizeof(BezierArea) + area.mVertex.size() * sizeof(VertexRef) + area.mPath.elementCount() * pathElementSize;
+    }
+    return bytes;
+}
+
 VectorImage& VectorImage::operator=(const VectorImage& a) {
 
     if (this == &a)
@@ -72,6 +95,7 @@ VectorImage* VectorImage::clone() const
  */
 bool VectorImage::read(QString filePath)
 {
+    TRACE_SCOPE("frames", "VectorImage::read");
     QFileInfo fileInfo(filePath);
     if (fileInfo.isDir())
     {
@@ -84,19 +108,43 @@ bool VectorImage::read(QString filePath)
         return false;
     }
 
-    QDomDocument doc;
-    if (!doc.setContent(&file)) return false; // this is not a XML file
-    QDomDocumentType type = doc.doctype();
-    if (type.name() != "PencilVectorImage") return false; // this is not a Pencil document
+    if (file.peek(VectorBinary::MAGIC_SIZE) == QByteArray(VectorBinary::MAGIC, VectorBinary::MAGIC_SIZE))
+    {
+        QDataStream stream(&file);
+        if (!loadBinary(stream)) return false;
 
-    QDomElement element = doc.documentElement();
-    if (element.tagName() == "image")
+        setFileName(filePath);
+        setModified(false);
+        return true;
+    }
+
+    // Pull-parse the file instead of building a DOM tree, vector keys are read
+    // for every frame on project load and the tree is thrown away right after.
+    QXmlStreamReader xmlStream(&file);
+    bool isPencilDocument = false;
+    while (!xmlStream.atEnd())
     {
-        if (element.attribute("type") == "vector")
+        QXmlStreamReader::TokenType token = xmlStream.readNext();
+        if (token == QXmlStreamReader::DTD)
+        {
+            isPencilDocument = (xmlStream.dtdName() == QLatin1String("PencilVectorImage"));
+        }
+        else if (token == QXmlStreamReader::StartElement)
         {
-            loadDomElement(element);
+            break;
         }
     }
+    if (xmlStream.hasError()) return false; // this is not a XML file
+    if (!isPencilDocument) return false; // this is not a Pencil document
+
+    if (xmlStream.name() == QLatin1String("image"))
+    {
+        if (xmlStream.attributes().value("type") == QLatin1String("vector"))
+        {
+            loadXmlStream(xmlStream);
+        }
+    }
+    if (xmlStream.hasError()) return false;
 
     setFileName(filePath);
     setModified(false);
@@ -106,11 +154,13 @@ bool VectorImage::read(QString filePath)
 /**
  * @brief VectorImage::write
  * @param filePath: QString
- * @param format: QString of the file format
+ * @param format: QString of the file format, "VEC" for xml or "VECB" for the compact binary encoding,
+ *                whose files start with the "P2DV" magic of VectorBinary
  * @return Status
  */
-Status VectorImage::write(QString filePath, QString format)
+Status VectorImage::write(QString filePath, QString format) const
 {
+    TRACE_SCOPE("frames", "VectorImage::write");
     DebugDetails debugInfo;
     debugInfo << "VectorImage::write";
     debugInfo << QString("filePath = ").append(filePath);
@@ -125,6 +175,18 @@ Status VectorImage::write(QString filePath, QString format)
         return Status(Status::FAIL, debugInfo);
     }
 
+    if (format == "VECB")
+    {
+        QDataStream stream(&file);
+        writeBinary(stream);
+        if (stream.status() != QDataStream::Ok)
+        {
+            debugInfo << "- binary stream write failed";
+            return Status(Status::FAIL, debugInfo);
+        }
+        return Status::OK;
+    }
+
     if (format != "VEC")
     {
         debugInfo << "Unrecognized format";
@@ -149,7 +211,6 @@ Status VectorImage::write(QString filePath, QString format)
     xmlStream.writeEndElement(); // Close image element
     xmlStream.writeEndDocument();
 
-    setFileName(filePath);
     return Status::OK;
 }
 
@@ -158,7 +219,7 @@ Status VectorImage::write(QString filePath, QString format)
  * @param xmlStream: QXmlStreamWriter&
  * @return Status
  */
-Status VectorImage::createDomElement(QXmlStreamWriter& xmlStream)
+Status VectorImage::createDomElement(QXmlStreamWriter& xmlStream) const
 {
     DebugDetails debugInfo;
     debugInfo << "VectorImage::createDomElement";
@@ -216,6 +277,105 @@ void VectorImage::loadDomElement(QDomElement element)
     clean();
 }
 
+/**
+ * @brief VectorImage::loadXmlStream
+ * @param xmlStream: QXmlStreamReader positioned on the <image> start element,
+ *        it is left on the matching end element.
+ */
+void VectorImage::loadXmlStream(QXmlStreamReader& xmlStream)
+{
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("curve"))
+        {
+            BezierCurve newCurve;
+            newCurve.loadXmlStream(xmlStream);
+            mCurves.append(newCurve);
+        }
+        else if (xmlStream.name() == QLatin1String("area"))
+        {
+            BezierArea newArea;
+            newArea.loadXmlStream(xmlStream);
+            addArea(newArea);
+        }
+        else
+        {
+            xmlStream.skipCurrentElement();
+        }
+    }
+    clean();
+}
+
+/**
+ * @brief VectorImage::writeBinary
+ * Writes the image in the compact binary vector format, see vectorbinary.h.
+ * @param stream: QDataStream&
+ */
+void VectorImage::writeBinary(QDataStream& stream) const
+{
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream.writeRawData(VectorBinary::MAGIC, VectorBinary::MAGIC_SIZE);
+    stream << VectorBinary::VERSION;
+
+    VectorBinary::writeVarUInt(stream, static_cast<quint64>(mCurves.size()));
+    for (const BezierCurve& curve : mCurves)
+    {
+        curve.writeBinary(stream);
+    }
+    VectorBinary::writeVarUInt(stream, static_cast<quint64>(mArea.size()));
+    for (const BezierArea& area : mArea)
+    {
+        area.writeBinary(stream);
+    }
+}
+
+/**
+ * @brief VectorImage::loadBinary
+ * @param stream: QDataStream& positioned at the start of a binary vector image
+ * @return False if the stream is not a supported binary vector image or is truncated
+ */
+bool VectorImage::loadBinary(QDataStream& stream)
+{
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    char magic[VectorBinary::MAGIC_SIZE];
+    if (stream.readRawData(magic, VectorBinary::MAGIC_SIZE) != VectorBinary::MAGIC_SIZE ||
+        memcmp(magic, VectorBinary::MAGIC, VectorBinary::MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+
+    quint16 version = 0;
+    stream >> version;
+    if (version > VectorBinary::VERSION)
+    {
+        qDebug() << "VectorImage - Unsupported binary vector version" << version;
+        return false;
+    }
+
+    const quint64 curveCount = VectorBinary::readVarUInt(stream);
+    for (quint64 i = 0; i < curveCount && stream.status() == QDataStream::Ok; i++)
+    {
+        BezierCurve newCurve;
+        newCurve.loadBinary(stream);
+        mCurves.append(newCurve);
+    }
+    const quint64 areaCount = VectorBinary::readVarUInt(stream);
+    for (quint64 i = 0; i < areaCount && stream.status() == QDataStream::Ok; i++)
+    {
+        BezierArea newArea;
+        newArea.loadBinary(stream);
+        addArea(newArea);
+    }
+    if (stream.status() != QDataStream::Ok) return false;
+
+    clean();
+    return true;
+}
+
 BezierCurve& VectorImage::curve(int i)
 {
     return mCurves[i];
@@ -1235,7 +1395,7 @@ void VectorImage::paintImage(QPainter& painter,
     }
 
     // ---- draw curves ----
-    for (BezierCurve curve : mCurves)
+    for (BezierCurve& curve : mCurves)
     {
         curve.drawPath(painter, object, mSelectionTransformation, simplified, showThinCurves);
         painter.setClipping(false);
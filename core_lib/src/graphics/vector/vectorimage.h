@@ -27,6 +27,8 @@ GNU General Public License for more details.
 class Object;
 class QPainter;
 class QImage;
+class QXmlStreamReader;
+class QDataStream;
 
 class VectorImage : public KeyFrame
 {
@@ -37,12 +39,18 @@ public:
     VectorImage& operator=(const VectorImage& a);
 
     VectorImage* clone() const override;
+    /** Vector images stay in memory, so this is only reported and never counts against the frame pool */
+    quint64 totalMemoryUsage() const override;
 
     bool read(QString filePath);
-    Status write(QString filePath, QString format);
+    /** Doesn't change the image, so keyframes can be written from worker threads */
+    Status write(QString filePath, QString format) const;
 
-    Status createDomElement(QXmlStreamWriter& doc);
+    Status createDomElement(QXmlStreamWriter& doc) const;
     void loadDomElement(QDomElement element);
+    void loadXmlStream(QXmlStreamReader& xmlStream);
+    void writeBinary(QDataStream& stream) const;
+    bool loadBinary(QDataStream& stream);
 
     BezierCurve& curve(int i);
 
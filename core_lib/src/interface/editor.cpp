@@ -31,6 +31,7 @@ GNU General Public License for more details.
 #include "layervector.h"
 #include "layercamera.h"
 #include "undoredocommand.h"
+#include "memoryreport.h"
 
 #include "movetool.h"
 
@@ -56,6 +57,8 @@ Editor::Editor(QObject* parent) : QObject(parent)
 Editor::~Editor()
 {
     // a lot more probably needs to be cleaned here...
+    mPreloadPool.clear();
+    mPreloadPool.waitForDone();
     clearTemporary();
 }
 
@@ -102,6 +105,41 @@ bool Editor::init()
     return true;
 }
 
+MemoryReport Editor::memoryReport() const
+{
+    MemoryReport report;
+
+    if (mObject)
+    {
+        for (int i = 0; i < mObject->getLayerCount(); i++)
+        {
+            Layer* layer = mObject->getLayer(i);
+            if (layer->type() != Layer::BITMAP && layer->type() != Layer::VECTOR) { continue; }
+
+            const MemoryReport::Category category = (layer->type() == Layer::BITMAP) ? MemoryReport::BITMAP_KEYFRAMES
+                                                                                    : MemoryReport::VECTOR_KEYFRAMES;
+            layer->foreachKeyFrame([&](KeyFrame* key)
+            {
+                if (key->isLoaded()) {
+                    report.add(category, key->totalMemoryUsage());
+                }
+            });
+        }
+        report.setFramePool(mObject->activeFramePoolUsedMemory(), mObject->activeFramePoolBudget());
+    }
+
+    report.add(MemoryReport::UNDO_STACK, undoRedo()->memoryUsage(), undoRedo()->entryCount());
+
+    if (mScribbleArea) {
+        mScribbleArea->addMemoryUsage(report);
+    }
+
+    report.add(MemoryReport::AUDIO, playback()->soundMemoryUsage(), 0);
+    report.add(MemoryReport::AUDIO, sound()->waveformMemoryUsage(), 0);
+
+    return report;
+}
+
 int Editor::currentFrame() const
 {
     return mFrame;
@@ -140,14 +178,24 @@ void Editor::settingUpdated(SETTING setting)
         mAutosaveNumber = mPreferenceManager->getInt(SETTING::AUTO_SAVE_NUMBER);
         break;
     case SETTING::ONION_TYPE:
-        mScribbleArea->onOnionSkinTypeChanged();
+        if (mScribbleArea) {
+            mScribbleArea->onOnionSkinTypeChanged();
+        }
         emit updateTimeLineCached();
         break;
     case SETTING::FRAME_POOL_SIZE:
         mObject->setActiveFramePoolSize(mPreferenceManager->getInt(SETTING::FRAME_POOL_SIZE));
         break;
+    case SETTING::BINARY_VECTOR_KEYFRAMES:
+        mObject->setBinaryVectorKeyFrames(mPreferenceManager->isOn(SETTING::BINARY_VECTOR_KEYFRAMES));
+        break;
+    case SETTING::FAST_BITMAP_KEYFRAMES:
+        mObject->setFastBitmapKeyFrames(mPreferenceManager->isOn(SETTING::FAST_BITMAP_KEYFRAMES));
+        break;
     case SETTING::LAYER_VISIBILITY:
-        mScribbleArea->setLayerVisibility(static_cast<LayerVisibility>(mPreferenceManager->getInt(SETTING::LAYER_VISIBILITY)));
+        if (mScribbleArea) {
+            mScribbleArea->setLayerVisibility(static_cast<LayerVisibility>(mPreferenceManager->getInt(SETTING::LAYER_VISIBILITY)));
+        }
         emit updateTimeLine();
         break;
     default:
@@ -219,7 +267,9 @@ void Editor::copyAndCut()
     }
 
     if (currentLayer->type() == Layer::BITMAP || currentLayer->type() == Layer::VECTOR) {
-        mScribbleArea->deleteSelection();
+        if (mScribbleArea) {
+            mScribbleArea->deleteSelection();
+        }
         deselectAll();
     }
 }
@@ -273,7 +323,9 @@ void Editor::pasteToCanvas(BitmapImage* bitmapImage, int frameNumber)
            bitmapImage->transform(selection, true);
        }
     }
-    mScribbleArea->handleDrawingOnEmptyFrame();
+    if (mScribbleArea) {
+        mScribbleArea->handleDrawingOnEmptyFrame();
+    }
     BitmapImage *canvasImage = static_cast<BitmapImage*>(currentLayer->getLastKeyFrameAtPosition(frameNumber));
 
     // Paste clipboard onto current shown image
@@ -292,7 +344,9 @@ void Editor::pasteToCanvas(VectorImage* vectorImage, int frameNumber)
     Q_ASSERT(currentLayer->type() == Layer::VECTOR);
 
     deselectAll();
-    mScribbleArea->handleDrawingOnEmptyFrame();
+    if (mScribbleArea) {
+        mScribbleArea->handleDrawingOnEmptyFrame();
+    }
     VectorImage* canvasImage = static_cast<VectorImage*>(currentLayer->getLastKeyFrameAtPosition(frameNumber));
     canvasImage->paste(*vectorImage);
     select()->setSelection(vectorImage->getSelectionRect());
@@ -351,7 +405,7 @@ void Editor::paste()
 
         backup(tr("Paste"));
 
-        clipboards()->setFromSystemClipboard(mScribbleArea->getCentralPoint(), currentLayer);
+        clipboards()->setFromSystemClipboard(mScribbleArea ? mScribbleArea->getCentralPoint() : QPointF(), currentLayer);
 
         BitmapImage clipboardImage = clipboards()->getBitmapClipboard();
         VectorImage clipboardVectorImage = clipboards()->getVectorClipboard();
@@ -375,7 +429,9 @@ void Editor::flipSelection(bool flipVertical)
     } else {
         backup(tr("Flip selection horizontally"));
     }
-    mScribbleArea->flipSelection(flipVertical);
+    if (mScribbleArea) {
+        mScribbleArea->flipSelection(flipVertical);
+    }
 }
 
 void Editor::repositionImage(QPoint transform, int frame)
@@ -408,7 +464,7 @@ void Editor::clipboardChanged()
 {
     Layer* layer = layers()->currentLayer();
 
-    clipboards()->setFromSystemClipboard(mScribbleArea->getCentralPoint(), layer);
+    clipboards()->setFromSystemClipboard(mScribbleArea ? mScribbleArea->getCentralPoint() : QPointF(), layer);
 
     bool canCopyState = canCopy();
     bool canPasteState = canPaste();
@@ -418,13 +474,15 @@ void Editor::clipboardChanged()
 }
 
 void Editor::setLayerVisibility(LayerVisibility visibility) {
-    mScribbleArea->setLayerVisibility(visibility);
+    if (mScribbleArea) {
+        mScribbleArea->setLayerVisibility(visibility);
+    }
     emit updateTimeLine();
 }
 
 LayerVisibility Editor::layerVisibility()
 {
-    return mScribbleArea->getLayerVisibility();
+    return mScribbleArea ? mScribbleArea->getLayerVisibility() : LayerVisibility::ALL;
 }
 
 qreal Editor::viewScaleInversed()
@@ -434,13 +492,17 @@ qreal Editor::viewScaleInversed()
 
 void Editor::increaseLayerVisibilityIndex()
 {
-    mScribbleArea->increaseLayerVisibilityIndex();
+    if (mScribbleArea) {
+        mScribbleArea->increaseLayerVisibilityIndex();
+    }
     emit updateTimeLine();
 }
 
 void Editor::decreaseLayerVisibilityIndex()
 {
-    mScribbleArea->decreaseLayerVisibilityIndex();
+    if (mScribbleArea) {
+        mScribbleArea->decreaseLayerVisibilityIndex();
+    }
     emit updateTimeLine();
 }
 
@@ -526,6 +588,7 @@ Status Editor::openObject(const QString& strFilePath, const std::function<void(i
     }
 
     setObject(object);
+    preloadFramesAround(currentFrame());
 
     progressChanged(progress + 1);
 
@@ -535,6 +598,59 @@ Status Editor::openObject(const QString& strFilePath, const std::function<void(i
     return Status::OK;
 }
 
+void Editor::preloadFramesAround(int frame)
+{
+    // Whatever is still queued belongs to the previous project
+    mPreloadPool.clear();
+
+    const int frameCount = mPreferenceManager->getInt(SETTING::FRAME_PRELOAD_COUNT);
+    if (frameCount <= 0) { return; }
+
+    const int beginFrame = qMax(frame - frameCount, 1);
+    const int endFrame = frame + frameCount;
+
+    for (int i = 0; i < mObject->getLayerCount(); i++)
+    {
+        Layer* layer = mObject->getLayer(i);
+        if (layer->type() != Layer::BITMAP || !layer->visible()) { continue; }
+
+        for (int k = beginFrame; k <= endFrame; ++k)
+        {
+            KeyFrame* key = layer->getKeyFrameAt(k);
+            if (key == nullptr || key->isLoaded() || key->fileName().isEmpty()) { continue; }
+
+            // Only the file path crosses threads, the keyframe itself is filled in on this thread
+            const int layerId = layer->id();
+            const QString filePath = key->fileName();
+            mPreloadPool.start([this, layerId, k, filePath]
+            {
+                const QImage image = BitmapImage::decodeFile(filePath);
+                QMetaObject::invokeMethod(this, [this, layerId, k, filePath, image]
+                {
+                    framePreloaded(layerId, k, filePath, image);
+                }, Qt::QueuedConnection);
+            });
+        }
+    }
+}
+
+void Editor::framePreloaded(int layerId, int position, const QString& filePath, const QImage& image)
+{
+    Layer* layer = mObject->findLayerById(layerId);
+    if (layer == nullptr || layer->type() != Layer::BITMAP) { return; }
+
+    // The keyframe may have been moved, drawn on or loaded by a scrub in the meantime
+    BitmapImage* key = static_cast<BitmapImage*>(layer->getKeyFrameAt(position));
+    if (key == nullptr || key->isLoaded() || key->fileName() != filePath) { return; }
+
+    // Never push the frames the user is looking at out of a full pool
+    const quint64 bytes = static_cast<quint64>(image.bytesPerLine()) * static_cast<quint64>(image.height());
+    if (mObject->activeFramePoolUsedMemory() + bytes > mObject->activeFramePoolBudget()) { return; }
+
+    key->loadFile(image);
+    mObject->addToActiveFrames(key);
+}
+
 Status Editor::setObject(Object* newObject)
 {
     Q_ASSERT(newObject);
@@ -569,6 +685,8 @@ void Editor::updateObject()
     if (mPreferenceManager)
     {
         mObject->setActiveFramePoolSize(mPreferenceManager->getInt(SETTING::FRAME_POOL_SIZE));
+        mObject->setBinaryVectorKeyFrames(mPreferenceManager->isOn(SETTING::BINARY_VECTOR_KEYFRAMES));
+        mObject->setFastBitmapKeyFrames(mPreferenceManager->isOn(SETTING::FAST_BITMAP_KEYFRAMES));
     }
 
     emit updateLayerCount();
@@ -583,7 +701,9 @@ Status Editor::importBitmapImage(const QString& filePath, const QTransform& impo
 
     if (!layer->visible())
     {
-        mScribbleArea->showLayerNotVisibleWarning();
+        if (mScribbleArea) {
+            mScribbleArea->showLayerNotVisibleWarning();
+        }
         return Status::SAFE;
     }
 
@@ -694,7 +814,7 @@ Status Editor::importImage(const QString& filePath, const ImportImageConfig impo
             break;
         }
         case ImportImageConfig::CenterOfView: {
-            QPointF centralPoint = mScribbleArea->getCentralPoint();
+            QPointF centralPoint = mScribbleArea ? mScribbleArea->getCentralPoint() : QPointF();
             transform = QTransform::fromTranslate(centralPoint.x(), centralPoint.y());
             break;
         }
@@ -841,7 +961,9 @@ void Editor::deselectAll() const
 
 void Editor::updateFrame()
 {
-    mScribbleArea->updateFrame();
+    if (mScribbleArea) {
+        mScribbleArea->updateFrame();
+    }
 }
 
 void Editor::setCurrentLayerIndex(int i)
@@ -908,7 +1030,9 @@ KeyFrame* Editor::addKeyFrame(const int layerNumber, int frameIndex)
 
     if (!layer->visible())
     {
-        mScribbleArea->showLayerNotVisibleWarning();
+        if (mScribbleArea) {
+            mScribbleArea->showLayerNotVisibleWarning();
+        }
         return nullptr;
     }
 
@@ -948,7 +1072,9 @@ void Editor::removeKey()
 
     if (!layer->visible())
     {
-        mScribbleArea->showLayerNotVisibleWarning();
+        if (mScribbleArea) {
+            mScribbleArea->showLayerNotVisibleWarning();
+        }
         return;
     }
 
@@ -992,7 +1118,9 @@ void Editor::switchVisibilityOfLayer(int layerNumber)
 {
     Layer* layer = mObject->getLayer(layerNumber);
     if (layer != nullptr) layer->switchVisibility();
-    mScribbleArea->onLayerChanged();
+    if (mScribbleArea) {
+        mScribbleArea->onLayerChanged();
+    }
 
     emit updateTimeLine();
 }
@@ -1011,7 +1139,9 @@ void Editor::swapLayers(int i, int j)
         layers()->setCurrentLayer(j - 1);
     }
     emit updateTimeLine();
-    mScribbleArea->onLayerChanged();
+    if (mScribbleArea) {
+        mScribbleArea->onLayerChanged();
+    }
 }
 
 bool Editor::canSwapLayers(int layerIndexLeft, int layerIndexRight) const
@@ -1029,7 +1159,9 @@ void Editor::prepareSave()
 
 void Editor::clearCurrentFrame()
 {
-    mScribbleArea->clearImage();
+    if (mScribbleArea) {
+        mScribbleArea->clearImage();
+    }
 }
 
 bool Editor::canCopy() const
@@ -21,6 +21,7 @@ GNU General Public License for more details.
 #include <functional>
 #include <memory>
 #include <QObject>
+#include <QThreadPool>
 #include "pencilerror.h"
 #include "pencildef.h"
 #include "importimageconfig.h"
@@ -40,6 +41,7 @@ Q_MOC_INCLUDE("undoredomanager.h")
 #endif
 
 class QClipboard;
+class QImage;
 class QTemporaryDir;
 class Object;
 class KeyFrame;
@@ -64,6 +66,7 @@ class TimeLine;
 class UndoRedoCommand;
 class ActiveFramePool;
 class Layer;
+class MemoryReport;
 
 enum class SETTING;
 
@@ -111,11 +114,15 @@ public:
     void updateObject();
     void prepareSave();
 
+    /** Left unset for command line exports, which have no canvas */
     void setScribbleArea(ScribbleArea* pScirbbleArea) { mScribbleArea = pScirbbleArea; }
     ScribbleArea* getScribbleArea() { return mScribbleArea; }
 
     int currentFrame() const;
     int fps();
+
+    /** Collects how much memory the project, the undo history, the caches and the audio hold right now */
+    MemoryReport memoryReport() const;
     void setFps(int fps);
 
     int  currentLayerIndex() const { return mCurrentLayerIndex; }
@@ -243,6 +250,10 @@ private:
     bool canCopyFrames(const Layer* layer) const;
     bool canCopyVectorImage(const VectorImage* vectorImage) const;
 
+    /** Decodes the bitmap keyframes near @p frame in the background, so that the first scrub after opening doesn't stall */
+    void preloadFramesAround(int frame);
+    void framePreloaded(int layerId, int position, const QString& filePath, const QImage& image);
+
     // the object to be edited by the editor
     std::unique_ptr<Object> mObject;
 
@@ -274,6 +285,8 @@ private:
 
     QList<QTemporaryDir*> mTemporaryDirs;
 
+    QThreadPool mPreloadPool;
+
     void updateAutoSaveCounter();
 };
 
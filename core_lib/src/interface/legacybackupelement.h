@@ -42,6 +42,7 @@ public:
 
     virtual int type() { return UNDEFINED; }
     virtual void restore(Editor*) { Q_ASSERT(false); }
+    virtual quint64 memoryUsage() const { return 0; }
 };
 
 class BackupLegacyBitmapElement : public LegacyBackupElement
@@ -57,6 +58,7 @@ public:
     BitmapImage bitmapImage;
     int type() override { return LegacyBackupElement::BITMAP_MODIF; }
     void restore(Editor*) override;
+    quint64 memoryUsage() const override { return bitmapImage.memoryUsage(); }
 };
 
 class BackupLegacyVectorElement : public LegacyBackupElement
@@ -72,6 +74,7 @@ public:
 
     int type() override { return LegacyBackupElement::VECTOR_MODIF; }
     void restore(Editor*) override;
+    quint64 memoryUsage() const override { return vectorImage.totalMemoryUsage(); }
 };
 
 class BackupLegacySoundElement : public LegacyBackupElement
@@ -36,6 +36,8 @@ GNU General Public License for more details.
 #include "vectorimage.h"
 #include "blitrect.h"
 #include "tile.h"
+#include "memoryreport.h"
+#include "tracer.h"
 
 #include "onionskinpainteroptions.h"
 
@@ -56,6 +58,8 @@ ScribbleArea::ScribbleArea(QWidget* parent) : QWidget(parent),
     // Qt::WA_StaticContents ensure that the widget contents are rooted to the top-left corner
     // and don't change when the widget is resized.
     setAttribute(Qt::WA_StaticContents);
+
+    mCanvasPainter.setRenderStats(&mRenderStats);
 }
 
 ScribbleArea::~ScribbleArea()
@@ -258,12 +262,30 @@ void ScribbleArea::invalidateOnionSkinsCacheAround(int frameNumber)
     }
 }
 
+void ScribbleArea::addMemoryUsage(MemoryReport& report) const
+{
+    report.add(MemoryReport::RENDER_CACHES, MemoryReport::pixmapBytes(mCanvas));
+    report.add(MemoryReport::RENDER_CACHES, mCanvasPainter.memoryUsage());
+    report.add(MemoryReport::RENDER_CACHES, mCameraPainter.memoryUsage());
+
+    for (const QPixmapCache::Key& key : mPixmapCacheKeys)
+    {
+        QPixmap pixmap;
+        if (QPixmapCache::find(key, &pixmap)) {
+            report.add(MemoryReport::RENDER_CACHES, MemoryReport::pixmapBytes(pixmap));
+        }
+    }
+
+    report.add(MemoryReport::TILES, mTiledBuffer.memoryUsage(), mTiledBuffer.tiles().size());
+}
+
 void ScribbleArea::invalidateAllCache()
 {
     if (currentTool()->isDrawingTool() && currentTool()->isActive()) { return; }
 
     QPixmapCache::clear();
     mPixmapCacheKeys.clear();
+    mCanvasPainter.clearOnionSkinCache();
     invalidatePainterCaches();
     mEditor->layers()->currentLayer()->clearDirtyFrames();
 
@@ -877,7 +899,10 @@ void ScribbleArea::handleDrawingOnEmptyFrame()
 
 void ScribbleArea::paintEvent(QPaintEvent* event)
 {
+    TRACE_SCOPE("paint", "ScribbleArea::paintEvent");
     int currentFrame = mEditor->currentFrame();
+    mRenderStats.beginPaint(currentFrame);
+
     if (!currentTool()->isActive())
     {
         // --- we retrieve the canvas from the cache; we create it if it doesn't exist
@@ -891,7 +916,9 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
         {
             auto cacheKeyIter = mPixmapCacheKeys.find(static_cast<unsigned>(frameNumber));
 
-            if (cacheKeyIter == mPixmapCacheKeys.end() || !QPixmapCache::find(cacheKeyIter.value(), &mCanvas))
+            const bool isCached = cacheKeyIter != mPixmapCacheKeys.end() && QPixmapCache::find(cacheKeyIter.value(), &mCanvas);
+            mRenderStats.countCache(RenderStats::FRAME_CACHE, isCached);
+            if (!isCached)
             {
                 drawCanvas(currentFrame, event->rect());
                 mPixmapCacheKeys[static_cast<unsigned>(currentFrame)] = QPixmapCache::insert(mCanvas);
@@ -905,12 +932,20 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
     }
     else
     {
-        prepCanvas(currentFrame);
-        prepCameraPainter(currentFrame);
-        prepOverlays(currentFrame);
-
-        mCanvasPainter.paintCached(event->rect());
-        mCameraPainter.paintCached(event->rect());
+        {
+            RenderStats::StageTimer timer(&mRenderStats, RenderStats::PREP);
+            prepCanvas(currentFrame);
+            prepCameraPainter(currentFrame);
+            prepOverlays(currentFrame);
+        }
+        {
+            RenderStats::StageTimer timer(&mRenderStats, RenderStats::LAYERS);
+            mCanvasPainter.paintCached(event->rect());
+        }
+        {
+            RenderStats::StageTimer timer(&mRenderStats, RenderStats::CAMERA_OVERLAY);
+            mCameraPainter.paintCached(event->rect());
+        }
     }
 
     if (currentTool()->type() == MOVE)
@@ -938,7 +973,10 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
     painter.setClipRect(event->rect());
     painter.drawPixmap(QPointF(), mCanvas);
 
-    currentTool()->paint(painter, event->rect());
+    {
+        RenderStats::StageTimer timer(&mRenderStats, RenderStats::TOOL_OVERLAY);
+        currentTool()->paint(painter, event->rect());
+    }
 
     if (!editor()->playback()->isPlaying())    // we don't need to display the following when the animation is playing
     {
@@ -948,6 +986,7 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
             VectorImage* vectorImage = currentVectorImage(layer);
             if (vectorImage != nullptr)
             {
+                RenderStats::StageTimer timer(&mRenderStats, RenderStats::TOOL_OVERLAY);
                 switch (currentTool()->type())
                 {
                 case SMUDGE:
@@ -1015,11 +1054,15 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
             }
         }
 
-        mOverlayPainter.paint(painter, rect());
+        {
+            RenderStats::StageTimer timer(&mRenderStats, RenderStats::CAMERA_OVERLAY);
+            mOverlayPainter.paint(painter, rect());
+        }
 
         // paints the selection outline
         if (mEditor->select()->somethingSelected())
         {
+            RenderStats::StageTimer timer(&mRenderStats, RenderStats::SELECTION);
             paintSelectionVisuals(painter);
         }
     }
@@ -1033,6 +1076,7 @@ void ScribbleArea::paintEvent(QPaintEvent* event)
 #endif
 
     event->accept();
+    mRenderStats.endPaint();
 }
 
 void ScribbleArea::paintSelectionVisuals(QPainter &painter)
@@ -1136,10 +1180,17 @@ void ScribbleArea::prepCanvas(int frame)
 
 void ScribbleArea::drawCanvas(int frame, QRect rect)
 {
-    prepCanvas(frame);
-    prepCameraPainter(frame);
-    prepOverlays(frame);
-    mCanvasPainter.paint(rect);
+    {
+        RenderStats::StageTimer timer(&mRenderStats, RenderStats::PREP);
+        prepCanvas(frame);
+        prepCameraPainter(frame);
+        prepOverlays(frame);
+    }
+    {
+        RenderStats::StageTimer timer(&mRenderStats, RenderStats::LAYERS);
+        mCanvasPainter.paint(rect);
+    }
+    RenderStats::StageTimer timer(&mRenderStats, RenderStats::CAMERA_OVERLAY);
     mCameraPainter.paint(rect);
 }
 
@@ -37,6 +37,7 @@ GNU General Public License for more details.
 #include "preferencemanager.h"
 #include "selectionpainter.h"
 #include "camerapainter.h"
+#include "renderstats.h"
 #include "tiledbuffer.h"
 
 class Layer;
@@ -45,6 +46,7 @@ class BaseTool;
 class PointerEvent;
 class BitmapImage;
 class VectorImage;
+class MemoryReport;
 
 
 class ScribbleArea : public QWidget
@@ -76,6 +78,12 @@ public:
 
     QPointF getCentralPoint();
 
+    /** Adds the memory held by the canvas caches and the stroke tiles to @p report */
+    void addMemoryUsage(MemoryReport& report) const;
+
+    /** How long the recent canvas paints took by stage, and how often the render caches were hit */
+    RenderStats& renderStats() { return mRenderStats; }
+
     /** Update frame.
      * calls update() behind the scene and update cache if necessary */
     void updateFrame();
@@ -257,6 +265,8 @@ private:
     // Pixmap Cache keys
     QMap<unsigned int, QPixmapCache::Key> mPixmapCacheKeys;
 
+    RenderStats mRenderStats;
+
     // debug
     QLoggingCategory mLog{ "ScribbleArea" };
 };
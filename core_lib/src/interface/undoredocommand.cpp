@@ -55,6 +55,11 @@ KeyFrameRemoveCommand::~KeyFrameRemoveCommand()
     delete undoKeyFrame;
 }
 
+quint64 KeyFrameRemoveCommand::memoryUsage() const
+{
+    return undoKeyFrame ? undoKeyFrame->totalMemoryUsage() : 0;
+}
+
 void KeyFrameRemoveCommand::undo()
 {
     Layer* layer = editor()->layers()->findLayerById(undoLayerId);
@@ -223,6 +228,11 @@ BitmapReplaceCommand::BitmapReplaceCommand(const BitmapImage* undoBitmap,
     setText(description);
 }
 
+quint64 BitmapReplaceCommand::memoryUsage() const
+{
+    return undoBitmap.memoryUsage() + redoBitmap.memoryUsage();
+}
+
 void BitmapReplaceCommand::undo()
 {
     Layer* layer = editor()->layers()->findLayerById(undoLayerId);
@@ -254,6 +264,76 @@ void BitmapReplaceCommand::redo()
     editor()->scrubTo(redoBitmap.pos());
 }
 
+BitmapsReplaceCommand::BitmapsReplaceCommand(const std::vector<std::unique_ptr<KeyFrame>>& backupBitmaps,
+                             const int layerId,
+                             const QString& description,
+                             Editor *editor,
+                             QUndoCommand *parent) : UndoRedoCommand(editor, parent)
+{
+    this->layerId = layerId;
+
+    LayerBitmap* layer = static_cast<LayerBitmap*>(editor->layers()->findLayerById(layerId));
+    for (const std::unique_ptr<KeyFrame>& backup : backupBitmaps)
+    {
+        const BitmapImage* redoBitmap = layer ? layer->getBitmapImageAtFrame(backup->pos()) : nullptr;
+        if (redoBitmap == nullptr) { continue; }
+
+        undoBitmaps.append(*static_cast<const BitmapImage*>(backup.get()));
+        redoBitmaps.append(*redoBitmap);
+    }
+
+    setText(description);
+}
+
+quint64 BitmapsReplaceCommand::memoryUsage() const
+{
+    quint64 bytes = 0;
+    for (const BitmapImage& bitmap : undoBitmaps) { bytes += bitmap.memoryUsage(); }
+    for (const BitmapImage& bitmap : redoBitmaps) { bytes += bitmap.memoryUsage(); }
+    return bytes;
+}
+
+void BitmapsReplaceCommand::undo()
+{
+    Layer* layer = editor()->layers()->findLayerById(layerId);
+    if (!layer) {
+        return setObsolete(true);
+    }
+
+    UndoRedoCommand::undo();
+
+    for (const BitmapImage& bitmap : undoBitmaps)
+    {
+        static_cast<LayerBitmap*>(layer)->replaceKeyFrame(&bitmap);
+    }
+    if (!undoBitmaps.isEmpty())
+    {
+        editor()->scrubTo(undoBitmaps.first().pos());
+    }
+}
+
+void BitmapsReplaceCommand::redo()
+{
+    Layer* layer = editor()->layers()->findLayerById(layerId);
+    if (!layer) {
+        return setObsolete(true);
+    }
+
+    UndoRedoCommand::redo();
+
+    // Ignore automatic redo when added to undo stack
+    if (isFirstRedo()) { setFirstRedo(false); return; }
+
+    for (const BitmapImage& bitmap : redoBitmaps)
+    {
+        static_cast<LayerBitmap*>(layer)->replaceKeyFrame(&bitmap);
+    }
+    if (!redoBitmaps.isEmpty())
+    {
+        editor()->scrubTo(redoBitmaps.first().pos());
+    }
+}
+
 VectorReplaceCommand::VectorReplaceCommand(const VectorImage* undoVector,
                                    const int undoLayerId,
                                    const QString& description,
@@ -271,6 +351,11 @@ VectorReplaceCommand::VectorReplaceCommand(const VectorImage* undoVector,
     setText(description);
 }
 
+quint64 VectorReplaceCommand::memoryUsage() const
+{
+    return undoVector.totalMemoryUsage() + redoVector.totalMemoryUsage();
+}
+
 void VectorReplaceCommand::undo()
 {
     Layer* layer = editor()->layers()->findLayerById(undoLayerId);
@@ -19,6 +19,7 @@ GNU General Public License for more details.
 #ifndef UNDOREDOCOMMAND_H
 #define UNDOREDOCOMMAND_H
 
+#include <memory>
 #include <QUndoCommand>
 #include <QRectF>
 
@@ -42,6 +43,9 @@ public:
     explicit UndoRedoCommand(Editor* editor, QUndoCommand* parent = nullptr);
     ~UndoRedoCommand() = default;
 
+    /** Bytes held by the command to be able to undo and redo */
+    virtual quint64 memoryUsage() const { return 0; }
+
 protected:
     Editor* editor() const { return mEditor; }
 
@@ -66,6 +70,7 @@ public:
 
     void undo() override;
     void redo() override;
+    quint64 memoryUsage() const override;
 
 private:
 
@@ -131,6 +136,7 @@ public:
 
     void undo() override;
     void redo() override;
+    quint64 memoryUsage() const override;
 
 private:
     int undoLayerId = 0;
@@ -140,6 +146,28 @@ private:
     BitmapImage redoBitmap;
 };
 
+/** Replaces several bitmap keyframes of a layer in a single step, e.g. after filling a range of frames */
+class BitmapsReplaceCommand : public UndoRedoCommand
+{
+
+public:
+    BitmapsReplaceCommand(const std::vector<std::unique_ptr<KeyFrame>>& backupBitmaps,
+                  const int layerId,
+                  const QString& description,
+                  Editor* editor,
+                  QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+    quint64 memoryUsage() const override;
+
+private:
+    int layerId = 0;
+
+    QList<BitmapImage> undoBitmaps;
+    QList<BitmapImage> redoBitmaps;
+};
+
 class VectorReplaceCommand : public UndoRedoCommand
 {
 public:
@@ -151,6 +179,7 @@ public:
 
     void undo() override;
     void redo() override;
+    quint64 memoryUsage() const override;
 
 private:
     int undoLayerId = 0;
@@ -17,6 +17,8 @@ GNU General Public License for more details.
 #ifndef CLIPBOARDMANAGER_H
 #define CLIPBOARDMANAGER_H
 
+#include <map>
+
 #include "basemanager.h"
 
 #include "bitmapimage.h"
@@ -25,8 +25,10 @@ GNU General Public License for more details.
 #include "editor.h"
 #include "layersound.h"
 #include "layermanager.h"
-#include "soundclip.h"
+#include "soundmixdown.h"
+#include "soundmixer.h"
 #include "toolmanager.h"
+#include "tracer.h"
 
 
 PlaybackManager::PlaybackManager(Editor* editor) : BaseManager(editor, __FUNCTION__)
@@ -48,7 +50,9 @@ bool PlaybackManager::init()
 
     mScrubTimer = new QTimer(this);
     mScrubTimer->setTimerType(Qt::PreciseTimer);
-    mSoundclipsToPLay.clear();
+    mScrubTimer->setSingleShot(true);
+
+    mSoundMixer = new SoundMixer(this);
 
     QSettings settings (PENCIL2D, PENCIL2D);
     mFps = settings.value(SETTING_FPS).toInt();
@@ -59,6 +63,7 @@ bool PlaybackManager::init()
     mElapsedTimer = new QElapsedTimer;
     connect(mTimer, &QTimer::timeout, this, &PlaybackManager::timerTick);
     connect(mFlipTimer, &QTimer::timeout, this, &PlaybackManager::flipTimerTick);
+    connect(mScrubTimer, &QTimer::timeout, this, &PlaybackManager::stopScrubPlayback);
     return true;
 }
 
@@ -75,6 +80,9 @@ Status PlaybackManager::load(Object* o)
     updateStartFrame();
     updateEndFrame();
 
+    // Start decoding the sound clips now, so they are ready by the time playback starts
+    prepareSounds();
+
     return Status::OK;
 }
 
@@ -107,18 +115,18 @@ void PlaybackManager::play()
         frame = editor()->currentFrame();
     }
 
-    mListOfActiveSoundFrames.clear();
-    // Check for any sounds we should start playing part-way through.
-    mCheckForSoundsHalfway = true;
+    mScrubTimer->stop();
+    prepareSounds();
     playSounds(frame);
 
-    mTimer->setInterval(static_cast<int>(1000.f / mFps));
+    // The frame to show is computed from the clock on every tick, so ticking
+    // twice per frame only bounds the jitter, it doesn't affect the speed.
+    mTimer->setInterval(qMax(1, 500 / mFps));
+    mDroppedFrames = 0;
+    mLateFrames = 0;
+    restartClock(frame);
     mTimer->start();
 
-    // for error correction, please ref skipFrame()
-    mPlayingFrameCounter = 1;
-    mElapsedTimer->start();
-
     emit playStateChanged(true);
 }
 
@@ -197,30 +205,17 @@ void PlaybackManager::playFlipInBetween()
 
 void PlaybackManager::playScrub(int frame)
 {
-    if (!mSoundScrub || !mSoundclipsToPLay.isEmpty()) {return; }
+    if (!mSoundScrub || !mIsPlaySound || isPlaying()) { return; }
 
-    auto layerMan = editor()->layers();
-    for (int i = 0; i < layerMan->count(); i++)
-    {
-        Layer* layer = layerMan->getLayer(i);
-        if (layer->type() == Layer::SOUND && layer->visible())
-        {
-            KeyFrame* key = layer->getKeyFrameWhichCovers(frame);
-            if (key != nullptr)
-            {
-                SoundClip* clip = static_cast<SoundClip*>(key);
-                mSoundclipsToPLay.append(clip);
-            }
-        }
-    }
+    prepareSounds();
 
-    if (mSoundclipsToPLay.isEmpty()) { return; }
+    // Render only a short window of the mix from the scrubbed frame,
+    // scrubbing again before it ends just moves the window.
+    const qint64 sampleCount = static_cast<qint64>(SoundMixdown::SAMPLE_RATE) * mMsecSoundScrub / 1000;
+    mSoundMixer->start(SoundMixdown::frameToSample(frame, mFps), sampleCount);
 
-    mScrubTimer->singleShot(mMsecSoundScrub, this, &PlaybackManager::stopScrubPlayback);
-    for (int i = 0; i < mSoundclipsToPLay.count(); i++)
-    {
-        mSoundclipsToPLay.at(i)->playFromPosition(frame, mFps);
-    }
+    // Keep the device open a little longer than the window, so its tail isn't cut off
+    mScrubTimer->start(mMsecSoundScrub * 2);
 }
 
 void PlaybackManager::setFps(int fps)
@@ -232,6 +227,17 @@ void PlaybackManager::setFps(int fps)
         settings.setValue(SETTING_FPS, fps);
         emit fpsChanged(mFps);
 
+        if (mTimer->isActive())
+        {
+            // Continue at the new rate from the frame being shown
+            mTimer->setInterval(qMax(1, 500 / mFps));
+            restartClock(editor()->currentFrame());
+
+            // Clips start on other samples at the new rate
+            prepareSounds();
+            playSounds(editor()->currentFrame());
+        }
+
         // Update key-frame lengths of sound layers,
         // since the length depends on fps.
         for (int i = 0; i < object()->getLayerCount(); ++i)
@@ -246,156 +252,104 @@ void PlaybackManager::setFps(int fps)
     }
 }
 
-void PlaybackManager::playSounds(int frame)
+/**
+ * @brief PlaybackManager::prepareSounds()
+ * Hands the clips of all visible sound layers to the mixer, which places them
+ * by the sample their key frame starts on and streams them from a single output,
+ * so any number of overlapping clips stay in sync with each other.
+ */
+void PlaybackManager::prepareSounds()
 {
-    // If sound is turned off, don't play anything.
-    if (!mIsPlaySound)
-    {
-        return;
-    }
+    mSoundMixer->clearClips();
 
-    std::vector< LayerSound* > kSoundLayers;
     for (int i = 0; i < object()->getLayerCount(); ++i)
     {
         Layer* layer = object()->getLayer(i);
-        if (layer->type() == Layer::SOUND)
-        {
-            kSoundLayers.push_back(static_cast<LayerSound*>(layer));
-        }
-    }
-
-    for (LayerSound* layer : kSoundLayers)
-    {
-        KeyFrame* key = layer->getLastKeyFrameAtPosition(frame);
-
-        if (!layer->visible())
+        if (layer->type() != Layer::SOUND || !layer->visible())
         {
             continue;
         }
 
-        if (key != nullptr)
-        {
-            // add keyframe position to list
-            if (key->pos() + key->length() >= frame)
-            {
-                if (!mListOfActiveSoundFrames.contains(key->pos()))
-                {
-                    mListOfActiveSoundFrames.append(key->pos());
-                }
-            }
-        }
-
-        if (mCheckForSoundsHalfway)
-        {
-            // Check for sounds which we should start playing from part-way through.
-            for (int i = 0; i < mListOfActiveSoundFrames.count(); i++)
-            {
-                int listPosition = mListOfActiveSoundFrames.at(i);
-                if (layer->keyExistsWhichCovers(listPosition))
-                {
-                    key = layer->getKeyFrameWhichCovers(listPosition);
-                    SoundClip* clip = static_cast<SoundClip*>(key);
-                    clip->playFromPosition(frame, mFps);
-                }
-            }
-        }
-        else if (layer->keyExists(frame))
-        {
-            key = layer->getKeyFrameAt(frame);
-            SoundClip* clip = static_cast<SoundClip*>(key);
-
-            clip->play();
-
-            // save the position of our active sound frame
-            mActiveSoundFrame = frame;
-        }
-
-        if (frame >= mEndFrame)
+        layer->foreachKeyFrame([this](KeyFrame* key)
         {
-            if (layer->keyExists(mActiveSoundFrame))
-            {
-                key = layer->getKeyFrameWhichCovers(mActiveSoundFrame);
-                SoundClip* clip = static_cast<SoundClip*>(key);
-                clip->stop();
-
-                // make sure list is cleared on end
-                if (!mListOfActiveSoundFrames.isEmpty())
-                    mListOfActiveSoundFrames.clear();
-            }
-        }
+            mSoundMixer->addClip(key->fileName(), SoundMixdown::frameToSample(key->pos(), mFps));
+        });
     }
+    mSoundMixer->releaseUnusedClips();
+}
 
-    // Set flag to false, since this check should only be done when
-    // starting play-back, or when looping.
-    mCheckForSoundsHalfway = false;
+void PlaybackManager::playSounds(int frame)
+{
+    // If sound is turned off, don't play anything.
+    if (!mIsPlaySound)
+    {
+        return;
+    }
+    mSoundMixer->start(SoundMixdown::frameToSample(frame, mFps));
 }
 
 /**
- * @brief PlaybackManager::skipFrame()
- * Small errors accumulate while playing animation
- * If the error is greater than a frame interval, skip a frame
+ * @brief PlaybackManager::restartClock()
+ * Playback is driven by a monotonic clock: the frame shown on each tick is the frame
+ * that is due according to the time elapsed since @p frame was shown, so slow frames
+ * are dropped instead of stretching playback and drifting away from the sound.
  */
-bool PlaybackManager::skipFrame()
+void PlaybackManager::restartClock(int frame)
 {
-    // uncomment these debug outputs to see what happens
-    //float expectedTime = (mPlayingFrameCounter) * (1000.f / mFps);
-    //qDebug("Expected:  %.2f ms", expectedTime);
-    //qDebug("Actual:    %d   ms", mElapsedTimer->elapsed());
+    mClockStartFrame = frame;
+    mLastPlayedFrame = frame;
+    mElapsedTimer->start();
+}
 
-    int t = qRound((mPlayingFrameCounter - 1) * (1000.f / mFps));
-    if (mElapsedTimer->elapsed() < t)
-    {
-        qDebug() << "skip";
-        return true;
-    }
+int PlaybackManager::frameAtClock() const
+{
+    return mClockStartFrame + static_cast<int>(mElapsedTimer->nsecsElapsed() * mFps / 1000000000);
+}
 
-    ++mPlayingFrameCounter;
-    return false;
+quint64 PlaybackManager::soundMemoryUsage() const
+{
+    return mSoundMixer ? mSoundMixer->memoryUsage() : 0;
 }
 
 void PlaybackManager::stopSounds()
 {
-    std::vector<LayerSound*> kSoundLayers;
-
-    for (int i = 0; i < object()->getLayerCount(); ++i)
-    {
-        Layer* layer = object()->getLayer(i);
-        if (layer->type() == Layer::SOUND)
-        {
-            kSoundLayers.push_back(static_cast<LayerSound*>(layer));
-        }
-    }
-
-    for (LayerSound* layer : kSoundLayers)
-    {
-        layer->foreachKeyFrame([](KeyFrame* key)
-        {
-            SoundClip* clip = static_cast<SoundClip*>(key);
-            clip->stop();
-        });
-    }
+    mScrubTimer->stop();
+    mSoundMixer->stop();
 }
 
 void PlaybackManager::stopScrubPlayback()
 {
-    for (int i = 0; i < mSoundclipsToPLay.count(); i++)
+    if (!isPlaying())
     {
-        mSoundclipsToPLay.at(i)->pause();
+        mSoundMixer->stop();
     }
-    mSoundclipsToPLay.clear();
 }
 
 void PlaybackManager::timerTick()
 {
+    TRACE_SCOPE("playback", "PlaybackManager::timerTick");
     int currentFrame = editor()->currentFrame();
+    if (currentFrame != mLastPlayedFrame)
+    {
+        // The playhead was moved elsewhere, carry on from there
+        restartClock(currentFrame);
+        playSounds(currentFrame);
+    }
+
+    const int targetFrame = frameAtClock();
+    if (targetFrame <= currentFrame)
+    {
+        return; // the current frame is still due
+    }
 
     // reach the end
-    if (currentFrame >= mEndFrame)
+    if (targetFrame > mEndFrame || currentFrame >= mEndFrame)
     {
         if (mIsLooping)
         {
             editor()->scrubTo(mStartFrame);
-            mCheckForSoundsHalfway = true;
+            restartClock(mStartFrame);
+            playSounds(mStartFrame);
         }
         else
         {
@@ -404,18 +358,21 @@ void PlaybackManager::timerTick()
         return;
     }
 
-    if (skipFrame())
-        return;
+    if (targetFrame > currentFrame + 1)
+    {
+        // Rendering fell behind, skip straight to the frame that is due now
+        mLateFrames++;
+        mDroppedFrames += targetFrame - currentFrame - 1;
+    }
 
     // keep going
-    editor()->scrubForward();
-
-    int newFrame = editor()->currentFrame();
-    playSounds(newFrame);
+    editor()->scrubTo(targetFrame);
+    mLastPlayedFrame = targetFrame;
 }
 
 void PlaybackManager::flipTimerTick()
 {
+    TRACE_SCOPE("playback", "PlaybackManager::flipTimerTick");
     if (mFlipList.count() < 2 || editor()->currentFrame() != mFlipList[0])
     {
         mFlipTimer->stop();
@@ -481,9 +438,11 @@ void PlaybackManager::enableSound(bool b)
     if (!mIsPlaySound)
     {
         stopSounds();
-
-        // If, during playback, the sound is turned on again,
-        // check for sounds partway through.
-        mCheckForSoundsHalfway = true;
+    }
+    else if (mTimer->isActive())
+    {
+        // Sound was turned on again during playback
+        prepareSounds();
+        playSounds(editor()->currentFrame());
     }
 }
@@ -23,7 +23,7 @@ GNU General Public License for more details.
 
 class QTimer;
 class QElapsedTimer;
-class SoundClip;
+class SoundMixer;
 
 
 class PlaybackManager : public BaseManager
@@ -39,7 +39,6 @@ public:
 
     bool isPlaying();
     bool isLooping() { return mIsLooping; }
-    void setCheckForSoundsHalfway(bool newCheck) { mCheckForSoundsHalfway = newCheck; }
 
     void play();
     void stop();
@@ -68,6 +67,16 @@ public:
 
     void stopSounds();
 
+    /** Frames skipped since playback started, because rendering fell behind the clock */
+    int droppedFrameCount() const { return mDroppedFrames; }
+    /** Ticks since playback started that arrived after their frame was already due */
+    int lateFrameCount() const { return mLateFrames; }
+
+    /** Bytes held by the sound decoded for playback */
+    quint64 soundMemoryUsage() const;
+    /** Decodes and mixes the sound clips while playing, its samples are also used for the waveforms */
+    SoundMixer* soundMixer() const { return mSoundMixer; }
+
 private slots:
     void stopScrubPlayback();
 
@@ -80,8 +89,11 @@ signals:
 private:
     void timerTick();
     void flipTimerTick();
+    void prepareSounds();
     void playSounds(int frame);
-    bool skipFrame();
+
+    void restartClock(int frame);
+    int frameAtClock() const;
 
     int mStartFrame = 1;
     int mEndFrame = 60;
@@ -95,7 +107,6 @@ private:
     bool mIsRangedPlayback = false;
     int mMarkInFrame = 1;
     int mMarkOutFrame = 10;
-    int mActiveSoundFrame = 0;
 
     int mFps = 12;
 
@@ -109,11 +120,12 @@ private:
     QTimer* mFlipTimer = nullptr;
     QTimer* mScrubTimer = nullptr;
     QElapsedTimer* mElapsedTimer = nullptr;
-    int mPlayingFrameCounter = 0; // how many frames has passed after pressing play
+    int mClockStartFrame = 1; // frame shown when the playback clock was (re)started
+    int mLastPlayedFrame = 1;
+    int mDroppedFrames = 0;
+    int mLateFrames = 0;
 
-    bool mCheckForSoundsHalfway = false;
-    QVector<int> mListOfActiveSoundFrames;
-    QVector<SoundClip*> mSoundclipsToPLay;
+    SoundMixer* mSoundMixer = nullptr;
     QVector<int> mFlipList;
 };
 
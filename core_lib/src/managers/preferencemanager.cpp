@@ -92,6 +92,7 @@ void PreferenceManager::loadPrefs()
 
     set(SETTING::LAYOUT_LOCK,              settings.value(SETTING_LAYOUT_LOCK,            false).toBool());
     set(SETTING::FRAME_POOL_SIZE,          settings.value(SETTING_FRAME_POOL_SIZE,        1024).toInt());
+    set(SETTING::FRAME_PRELOAD_COUNT,      settings.value(SETTING_FRAME_PRELOAD_COUNT,    12).toInt());
     set(SETTING::NEW_UNDO_REDO_SYSTEM_ON,  settings.value(SETTING_NEW_UNDO_REDO_ON,       false).toBool());
     set(SETTING::UNDO_REDO_MAX_STEPS,      settings.value(SETTING_UNDO_REDO_MAX_STEPS,    100).toInt());
 
@@ -109,6 +110,8 @@ void PreferenceManager::loadPrefs()
     set(SETTING::LOAD_MOST_RECENT,         settings.value(SETTING_LOAD_MOST_RECENT,       false).toBool());
     set(SETTING::LOAD_DEFAULT_PRESET,      settings.value(SETTING_LOAD_DEFAULT_PRESET,    true).toBool());
     set(SETTING::DEFAULT_PRESET,           settings.value(SETTING_DEFAULT_PRESET,         0).toInt());
+    set(SETTING::BINARY_VECTOR_KEYFRAMES,  settings.value(SETTING_BINARY_VECTOR_KEYFRAMES,false).toBool());
+    set(SETTING::FAST_BITMAP_KEYFRAMES,    settings.value(SETTING_FAST_BITMAP_KEYFRAMES,  false).toBool());
 
     // Timeline
     set(SETTING::SHORT_SCRUB,              settings.value(SETTING_SHORT_SCRUB,            false ).toBool());
@@ -318,6 +321,9 @@ void PreferenceManager::set(SETTING option, int value)
     case SETTING::FRAME_POOL_SIZE:
         settings.setValue(SETTING_FRAME_POOL_SIZE, value);
         break;
+    case SETTING::FRAME_PRELOAD_COUNT:
+        settings.setValue(SETTING_FRAME_PRELOAD_COUNT, value);
+        break;
     case SETTING::UNDO_REDO_MAX_STEPS:
         settings.setValue(SETTING_UNDO_REDO_MAX_STEPS, value);
         break;
@@ -443,6 +449,12 @@ void PreferenceManager::set(SETTING option, bool value)
     case SETTING::AUTO_SAVE_BY_TIME:
         settings.setValue(SETTING_AUTO_SAVE_BY_TIME, value);
         break;
+    case SETTING::BINARY_VECTOR_KEYFRAMES:
+        settings.setValue(SETTING_BINARY_VECTOR_KEYFRAMES, value);
+        break;
+    case SETTING::FAST_BITMAP_KEYFRAMES:
+        settings.setValue(SETTING_FAST_BITMAP_KEYFRAMES, value);
+        break;
     case SETTING::SHORT_SCRUB:
         settings.setValue(SETTING_SHORT_SCRUB, value);
         break;
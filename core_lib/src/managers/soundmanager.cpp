@@ -23,8 +23,11 @@ GNU General Public License for more details.
 #include "object.h"
 #include "layersound.h"
 #include "soundclip.h"
+#include "soundmixer.h"
 #include "soundplayer.h"
+#include "soundwaveform.h"
 #include "layermanager.h"
+#include "playbackmanager.h"
 
 SoundManager::SoundManager(Editor* editor) : BaseManager(editor, __FUNCTION__)
 {
@@ -32,15 +35,23 @@ SoundManager::SoundManager(Editor* editor) : BaseManager(editor, __FUNCTION__)
 
 SoundManager::~SoundManager()
 {
+    mWaveformPool.clear();
+    mWaveformPool.waitForDone();
 }
 
 bool SoundManager::init()
 {
+    connect(editor()->playback()->soundMixer(), &SoundMixer::decoded, this, &SoundManager::onSoundDecoded);
     return true;
 }
 
 Status SoundManager::load(Object* obj)
 {
+    mWaveforms.clear();
+    mPendingWaveforms.clear();
+    mDecodingWaveforms.clear();
+    mWaveformGeneration++;
+
     int count = obj->getLayerCount();
     for (int i = 0; i < count; ++i)
     {
@@ -58,6 +69,7 @@ Status SoundManager::load(Object* obj)
             Q_ASSERT(clip);
 
             createMediaPlayer(clip);
+            analyzeWaveform(clip->fileName());
         });
     }
     return Status::OK;
@@ -97,6 +109,7 @@ Status SoundManager::loadSound(SoundClip* soundClip, QString strSoundFile)
         delete soundClip;
         return st;
     }
+    analyzeWaveform(soundClip->fileName());
 
     editor()->layers()->notifyAnimationLengthChanged();
 
@@ -163,3 +176,104 @@ Status SoundManager::createMediaPlayer(SoundClip* clip)
 
     return Status::OK;
 }
+
+quint64 SoundManager::waveformMemoryUsage() const
+{
+    quint64 bytes = 0;
+    for (const auto& waveform : mWaveforms)
+    {
+        if (waveform) {
+            bytes += waveform->memoryUsage();
+        }
+    }
+    return bytes;
+}
+
+const SoundWaveform* SoundManager::waveform(const QString& soundFile)
+{
+    auto it = mWaveforms.find(soundFile);
+    if (it != mWaveforms.end())
+    {
+        return it->get();
+    }
+    analyzeWaveform(soundFile);
+    return nullptr;
+}
+
+/**
+ * Reads the peaks of a sound file on a worker thread, so long clips don't block the timeline.
+ * The peaks are kept next to the sound file and saved with the project, so each file is only
+ * analysed once, the next time they are read back as long as the sound file didn't change.
+ * Sound files outside of the project's data folder get their peaks in the cache folder instead,
+ * and if the peaks can't be written they're simply analysed again next time.
+ *
+ * When there are no peaks yet, the file is decoded by the sound mixer, which keeps the samples
+ * for playback, and the peaks are built from them in onSoundDecoded().
+ */
+void SoundManager::analyzeWaveform(const QString& soundFile)
+{
+    if (soundFile.isEmpty() || mWaveforms.contains(soundFile) || mPendingWaveforms.contains(soundFile))
+    {
+        return;
+    }
+    mPendingWaveforms.insert(soundFile);
+
+    const int generation = mWaveformGeneration;
+    const QString peakFile = SoundWaveform::peakFileName(soundFile, editor()->object()->dataDir());
+    mWaveformPool.start([this, soundFile, peakFile, generation]
+    {
+        auto waveform = std::make_shared<SoundWaveform>();
+        if (waveform->load(peakFile, QFileInfo(soundFile)).ok())
+        {
+            QMetaObject::invokeMethod(this, [this, soundFile, waveform, generation]
+            {
+                waveformAnalyzed(soundFile, waveform, generation);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        QMetaObject::invokeMethod(this, [this, soundFile, generation]
+        {
+            if (generation != mWaveformGeneration) { return; }
+            mDecodingWaveforms.insert(soundFile);
+            editor()->playback()->soundMixer()->decode(soundFile);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SoundManager::onSoundDecoded(const QString& soundFile, const QVector<float>& samples)
+{
+    // The mixer also decodes for playback, only the files waiting for their peaks are analysed
+    if (!mDecodingWaveforms.remove(soundFile))
+    {
+        return;
+    }
+
+    const int generation = mWaveformGeneration;
+    const QString peakFile = SoundWaveform::peakFileName(soundFile, editor()->object()->dataDir());
+    mWaveformPool.start([this, soundFile, samples, peakFile, generation]
+    {
+        auto waveform = std::make_shared<SoundWaveform>();
+        if (!samples.isEmpty())
+        {
+            waveform->build(samples);
+            waveform->save(peakFile, QFileInfo(soundFile));
+        }
+
+        QMetaObject::invokeMethod(this, [this, soundFile, waveform, generation]
+        {
+            waveformAnalyzed(soundFile, waveform, generation);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SoundManager::waveformAnalyzed(const QString& soundFile, const std::shared_ptr<const SoundWaveform>& waveform, int generation)
+{
+    if (generation != mWaveformGeneration)
+    {
+        return; // analysed for the project that was open before
+    }
+    mPendingWaveforms.remove(soundFile);
+    mWaveforms.insert(soundFile, waveform);
+    emit waveformReady(soundFile);
+}
@@ -19,11 +19,17 @@ GNU General Public License for more details.
 #define SOUNDMANAGER_H
 
 #include <cstdint>
+#include <memory>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
 #include "basemanager.h"
 
 class Layer;
 class SoundClip;
 class SoundPlayer;
+class SoundWaveform;
 
 
 class SoundManager : public BaseManager
@@ -43,13 +49,28 @@ public:
 
     int soundClipCount() const;
 
+    /** Peaks of @p soundFile, or nullptr while they are still being analysed in the background */
+    const SoundWaveform* waveform(const QString& soundFile);
+    /** Bytes held by the waveform peaks analysed so far */
+    quint64 waveformMemoryUsage() const;
+
 signals:
     void soundClipDurationChanged();
+    void waveformReady(const QString& soundFile);
 
 private:
     void onDurationChanged(SoundPlayer* player, int64_t duration);
 
     Status createMediaPlayer(SoundClip*);
+    void analyzeWaveform(const QString& soundFile);
+    void onSoundDecoded(const QString& soundFile, const QVector<float>& samples);
+    void waveformAnalyzed(const QString& soundFile, const std::shared_ptr<const SoundWaveform>& waveform, int generation);
+
+    QHash<QString, std::shared_ptr<const SoundWaveform>> mWaveforms;
+    QSet<QString> mPendingWaveforms;
+    QSet<QString> mDecodingWaveforms; //< pending waveforms waiting for the sound mixer to decode their file
+    int mWaveformGeneration = 0; //< bumped on load, so peaks analysed for the previous project are dropped
+    QThreadPool mWaveformPool;
 };
 
 #endif // SOUNDMANAGER_H
@@ -125,6 +125,10 @@ void UndoRedoManager::record(SAVESTATE_ID saveStateId, const QString& descriptio
             moveKeyFrames(*saveState, description);
             break;
         }
+        case UndoRedoRecordType::KEYFRAMES_MODIFY: {
+            replaceKeyFrames(*saveState, description);
+            break;
+        }
         default: {
             QString reason("Unhandled case for: ");
             reason.append(description);
@@ -204,6 +208,20 @@ void UndoRedoManager::replaceKeyFrame(const UndoSaveState& undoState, const QStr
     }
 }
 
+void UndoRedoManager::replaceKeyFrames(const UndoSaveState& undoState, const QString& description)
+{
+    if (undoState.keyframes.empty()) { return; }
+
+    if (undoState.layerType == Layer::BITMAP) {
+        pushCommand(new BitmapsReplaceCommand(undoState.keyframes,
+                                              undoState.layerId,
+                                              description,
+                                              editor()));
+    } else {
+        // Implement other cases
+    }
+}
+
 void UndoRedoManager::moveKeyFrames(const UndoSaveState& undoState, const QString& description)
 {
     const MoveFramesSaveState& state = undoState.userState.moveFramesState;
@@ -277,6 +295,12 @@ void UndoRedoManager::addUserState(SAVESTATE_ID saveStateId, const UserSaveState
     mSaveStates[saveStateId]->userState = userState;
 }
 
+void UndoRedoManager::addKeyFrameState(SAVESTATE_ID saveStateId, const KeyFrame* keyframe)
+{
+    if (!mSaveStates.contains(saveStateId) || keyframe == nullptr) { return; }
+    mSaveStates[saveStateId]->keyframes.emplace_back(keyframe->clone());
+}
+
 void UndoRedoManager::initCommonKeyFrameState(UndoSaveState* undoSaveState) const
 {
     const Layer* layer = editor()->layers()->currentLayer();
@@ -409,6 +433,28 @@ void UndoRedoManager::clearStack()
     }
 }
 
+quint64 UndoRedoManager::memoryUsage() const
+{
+    quint64 bytes = 0;
+    for (int i = 0; i < mUndoStack.count(); i++)
+    {
+        const UndoRedoCommand* command = dynamic_cast<const UndoRedoCommand*>(mUndoStack.command(i));
+        if (command) {
+            bytes += command->memoryUsage();
+        }
+    }
+    for (const LegacyBackupElement* element : mLegacyBackupList)
+    {
+        bytes += element->memoryUsage();
+    }
+    return bytes;
+}
+
+int UndoRedoManager::entryCount() const
+{
+    return mUndoStack.count() + mLegacyBackupList.count();
+}
+
 // Legacy backup system
 
 void UndoRedoManager::legacyBackup(const QString& undoText)
@@ -47,6 +47,7 @@ enum class UndoRedoRecordType {
     KEYFRAME_REMOVE, // Removing a keyframe
     KEYFRAME_ADD, // Adding a keyframe
     KEYFRAME_MOVE,
+    KEYFRAMES_MODIFY, // Modifying several keyframes of a layer at once
     // SCRUB_LAYER, // Scrubbing layer
     // SCRUB_KEYFRAME, // Scrubbing keyframe
     INVALID
@@ -110,6 +111,7 @@ struct UndoSaveState {
     int currentFrameIndex = 0;
     Layer::LAYER_TYPE layerType = Layer::UNDEFINED;
     std::unique_ptr<KeyFrame> keyframe;
+    std::vector<std::unique_ptr<KeyFrame>> keyframes; // KEYFRAMES_MODIFY only
     SelectionSaveState selectionState = {};
 
     UserSaveState userState = {};
@@ -150,6 +152,13 @@ public:
      */
     void addUserState(SAVESTATE_ID SaveStateId, const UserSaveState& userState);
 
+    /** Adds a copy of @p keyframe, taken before it's modified, to a KEYFRAMES_MODIFY save state
+     *  If no record is found matching the id, nothing happens.
+     *  @param SaveStateId The id used to fetch the saveState
+     *  @param keyframe The keyframe about to be modified
+     */
+    void addKeyFrameState(SAVESTATE_ID SaveStateId, const KeyFrame* keyframe);
+
     QAction* createUndoAction(QObject* parent, const QIcon& icon);
     QAction* createRedoAction(QObject* parent, const QIcon& icon);
 
@@ -159,6 +168,11 @@ public:
     /** Clears the undo stack */
     void clearStack();
 
+    /** Bytes held by the undo history of both undo systems */
+    quint64 memoryUsage() const;
+    /** Number of entries in the undo history */
+    int entryCount() const;
+
     // Developer note:
     // Our legacy undo/redo system is not meant to be build upon anymore.
     // The implementation should however be kept until the new undo/redo system takes over.
@@ -190,6 +204,7 @@ private:
     void replaceKeyFrame(const UndoSaveState& undoState, const QString& description);
     void replaceBitmap(const UndoSaveState& undoState, const QString& description);
     void replaceVector(const UndoSaveState& undoState, const QString& description);
+    void replaceKeyFrames(const UndoSaveState& undoState, const QString& description);
 
     void addKeyFrame(const UndoSaveState& undoState, const QString& description);
     void removeKeyFrame(const UndoSaveState& undoState, const QString& description);
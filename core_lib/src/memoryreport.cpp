@@ -0,0 +1,102 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "memoryreport.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QPixmap>
+
+void MemoryReport::add(Category category, quint64 bytes, int items)
+{
+    Q_ASSERT(category >= 0 && category < CATEGORY_COUNT);
+    mBytes[category] += bytes;
+    mItems[category] += items;
+}
+
+quint64 MemoryReport::totalBytes() const
+{
+    quint64 total = 0;
+    for (quint64 bytes : mBytes)
+    {
+        total += bytes;
+    }
+    return total;
+}
+
+void MemoryReport::setFramePool(quint64 usedBytes, quint64 budgetBytes)
+{
+    mFramePoolUsed = usedBytes;
+    mFramePoolBudget = budgetBytes;
+}
+
+QString MemoryReport::categoryName(Category category)
+{
+    switch (category)
+    {
+    case BITMAP_KEYFRAMES: return tr("Bitmap keyframes");
+    case VECTOR_KEYFRAMES: return tr("Vector keyframes");
+    case UNDO_STACK: return tr("Undo history");
+    case RENDER_CACHES: return tr("Render caches");
+    case TILES: return tr("Stroke tiles");
+    case AUDIO: return tr("Audio");
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+QString MemoryReport::categoryId(Category category)
+{
+    switch (category)
+    {
+    case BITMAP_KEYFRAMES: return "bitmap_keyframes";
+    case VECTOR_KEYFRAMES: return "vector_keyframes";
+    case UNDO_STACK: return "undo_stack";
+    case RENDER_CACHES: return "render_caches";
+    case TILES: return "tiles";
+    case AUDIO: return "audio";
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+quint64 MemoryReport::pixmapBytes(const QPixmap& pixmap)
+{
+    if (pixmap.isNull()) { return 0; }
+    return static_cast<quint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+QJsonObject MemoryReport::toJson() const
+{
+    QJsonArray categories;
+    for (int i = 0; i < CATEGORY_COUNT; i++)
+    {
+        QJsonObject category;
+        category["id"] = categoryId(static_cast<Category>(i));
+        category["bytes"] = static_cast<qint64>(mBytes[i]);
+        category["items"] = mItems[i];
+        categories.append(category);
+    }
+
+    QJsonObject framePool;
+    framePool["used_bytes"] = static_cast<qint64>(mFramePoolUsed);
+    framePool["budget_bytes"] = static_cast<qint64>(mFramePoolBudget);
+
+    QJsonObject json;
+    json["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["total_bytes"] = static_cast<qint64>(totalBytes());
+    json["categories"] = categories;
+    json["frame_pool"] = framePool;
+    return json;
+}
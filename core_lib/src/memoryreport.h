@@ -0,0 +1,74 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <QCoreApplication>
+#include <QJsonObject>
+
+class QPixmap;
+
+/**
+ * A snapshot of how much memory the editor holds, by kind of data.
+ *
+ * The numbers are estimates of the pixel and sample buffers and other bulk data,
+ * not of every allocation. Images shared between several owners,
+ * e.g. a keyframe and the undo entry made right after it, may be counted by both.
+ */
+class MemoryReport
+{
+    Q_DECLARE_TR_FUNCTIONS(MemoryReport)
+public:
+    enum Category
+    {
+        BITMAP_KEYFRAMES,
+        VECTOR_KEYFRAMES,
+        UNDO_STACK,
+        RENDER_CACHES,
+        TILES,
+        AUDIO,
+        CATEGORY_COUNT
+    };
+
+    void add(Category category, quint64 bytes, int items = 1);
+
+    quint64 bytes(Category category) const { return mBytes[category]; }
+    int items(Category category) const { return mItems[category]; }
+    quint64 totalBytes() const;
+
+    /** The frame pool keeps the bitmap keyframes around the current frame loaded, within its budget */
+    void setFramePool(quint64 usedBytes, quint64 budgetBytes);
+    quint64 framePoolUsedBytes() const { return mFramePoolUsed; }
+    quint64 framePoolBudgetBytes() const { return mFramePoolBudget; }
+
+    /** A name for display */
+    static QString categoryName(Category category);
+    /** A stable name for machine readable output */
+    static QString categoryId(Category category);
+
+    static quint64 pixmapBytes(const QPixmap& pixmap);
+
+    QJsonObject toJson() const;
+
+private:
+    quint64 mBytes[CATEGORY_COUNT] = {};
+    int mItems[CATEGORY_COUNT] = {};
+    quint64 mFramePoolUsed = 0;
+    quint64 mFramePoolBudget = 0;
+};
+
+#endif // MEMORYREPORT_H
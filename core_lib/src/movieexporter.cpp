@@ -20,6 +20,7 @@ GNU General Public License for more details.
 #include <vector>
 #include <cstdint>
 #include <QDir>
+#include <QHash>
 #include <QDebug>
 #include <QProcess>
 #include <QApplication>
@@ -33,7 +34,10 @@ GNU General Public License for more details.
 #include "layercamera.h"
 #include "layersound.h"
 #include "soundclip.h"
+#include "soundmixdown.h"
+#include "gifencoder.h"
 #include "util.h"
+#include "tracer.h"
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
 using Qt::SplitBehaviorFlags;
@@ -81,15 +85,19 @@ Status MovieExporter::run(const Object* obj,
                           std::function<void(float)> minorProgress,
                           std::function<void(QString)> progressMessage)
 {
+    TRACE_SCOPE("export", "MovieExporter::run");
     majorProgress(0.f, 0.03f);
     minorProgress(0.f);
     progressMessage(tr("Checking environment..."));
 
     clock_t t1 = clock();
 
+    // GIFs are encoded in process, only movies need ffmpeg
+    const bool isGif = desc.strFileName.endsWith("gif", Qt::CaseInsensitive);
+
     QString ffmpegPath = ffmpegLocation();
     qDebug() << ffmpegPath;
-    if (!QFile::exists(ffmpegPath))
+    if (!isGif && !QFile::exists(ffmpegPath))
     {
 #ifdef _WIN32
         qCritical() << "Please place ffmpeg.exe in " << ffmpegPath << " directory";
@@ -114,12 +122,12 @@ Status MovieExporter::run(const Object* obj,
     mTempWorkDir = mTempDir.path();
 
     minorProgress(0.f);
-    if (desc.strFileName.endsWith("gif", Qt::CaseInsensitive))
+    if (isGif)
     {
         majorProgress(0.03f, 1.f);
         progressMessage(tr("Generating GIF..."));
         minorProgress(0.f);
-        STATUS_CHECK(generateGif(obj, ffmpegPath, desc.strFileName, minorProgress))
+        STATUS_CHECK(generateGif(obj, desc.strFileName, minorProgress))
     }
     else
     {
@@ -148,6 +156,10 @@ QString MovieExporter::error()
 }
 
 /** Combines all audio tracks in obj into a single file.
+ *
+ *  Every clip is decoded once and mixed in process at a sample accurate
+ *  offset, the mixdown is then written as the wav file the video pass reads.
+ *  FFmpeg is only used to decode clips that are not plain wav files.
  *
  *  @param[in] obj
  *  @param[in] ffmpegPath
@@ -163,7 +175,7 @@ Status MovieExporter::assembleAudio(const Object* obj,
                                     QString ffmpegPath,
                                     std::function<void(float)> progress)
 {
-    // Quicktime assemble call
+    TRACE_SCOPE("export", "MovieExporter::assembleAudio");
     const int startFrame = mDesc.startFrame;
     const int endFrame = mDesc.endFrame;
     const int fps = mDesc.fps;
@@ -194,58 +206,48 @@ Status MovieExporter::assembleAudio(const Object* obj,
 
     if (allSoundClips.empty()) return Status::SAFE;
 
-    int clipCount = 0;
+    // The mix covers the exported range only, from the start of startFrame to the end of endFrame
+    const qint64 firstSample = SoundMixdown::frameToSample(startFrame, fps);
+    const qint64 lastSample = qCeil(static_cast<double>(SoundMixdown::SAMPLE_RATE) * endFrame / fps);
+    SoundMixdown mixdown(lastSample - firstSample);
 
-    QString filterComplex, amergeInput, panChannelLayout;
-    QStringList args;
+    // Clips sharing a source file are decoded only once
+    QHash<QString, QVector<float>> decodedFiles;
 
-    int wholeLen = qCeil(endFrame * 44100.0 / fps);
-    for (auto clip : allSoundClips)
+    int clipCount = 0;
+    for (SoundClip* clip : allSoundClips)
     {
         if (mCanceled)
         {
             return Status::CANCELED;
         }
 
-        // Add sound file as input
-        args << "-i" << clip->fileName();
+        auto it = decodedFiles.find(clip->fileName());
+        if (it == decodedFiles.end())
+        {
+            QVector<float> samples;
+            Status st = SoundMixdown::decode(clip->fileName(), ffmpegPath, samples);
+            if (!st.ok())
+            {
+                DebugDetails dd;
+                dd << "MovieExporter::assembleAudio";
+                dd << QString("Error: Failed to decode sound clip %1").arg(clip->fileName());
+                dd.collect(st.details());
+                Status status(Status::FAIL, dd);
+                status.setTitle(tr("Something went wrong"));
+                status.setDescription(tr("Couldn't decode the sound clip %1.").arg(clip->soundClipName()));
+                return status;
+            }
+            it = decodedFiles.insert(clip->fileName(), samples);
+        }
 
-        // Offset the sound to its correct position
-        // See https://superuser.com/questions/716320/ffmpeg-placing-audio-at-specific-location
-        filterComplex += QString("[%1:a:0] aformat=sample_fmts=fltp:sample_rates=44100:channel_layouts=mono,volume=1,adelay=%2S|%2S,apad=whole_len=%3[ad%1];")
-                    .arg(clipCount).arg(qRound(44100.0 * (clip->pos() - 1) / fps)).arg(wholeLen);
-        amergeInput += QString("[ad%1]").arg(clipCount);
-        panChannelLayout += QString("c%1+").arg(clipCount);
+        mixdown.mix(it.value(), SoundMixdown::frameToSample(clip->pos(), fps) - firstSample);
 
         clipCount++;
+        progress(clipCount / static_cast<float>(allSoundClips.size()));
     }
-    // Remove final '+'
-    panChannelLayout.chop(1);
-    // Output arguments
-    // Mix audio
-    args << "-filter_complex";
-    if (clipCount == 1)
-    {
-        // If there is only one sound clip there is no need to use amerge
-        // Prior to ffmpeg 3.2, amerge does not support inputs=1
-        filterComplex.chop(1); // Remove final semicolon since there are no more filters added after
-        args << filterComplex << "-map" << amergeInput;
-    }
-    else {
-        args << QString("%1%2 amerge=inputs=%3, pan=mono|c0=%4 [out]")
-                .arg(filterComplex).arg(amergeInput).arg(clipCount).arg(panChannelLayout);
-        args << "-map" << "[out]";
-    }
-    // Convert audio file: 44100Hz sampling rate, stereo, signed 16 bit little endian
-    // Supported audio file types: wav, mp3, ogg... ( all file types supported by ffmpeg )
-    args << "-ar" << "44100" << "-acodec" << "pcm_s16le" << "-ac" << "2" << "-y";
-    // Trim audio
-    args << "-ss" << QString::number((startFrame - 1) / static_cast<double>(fps));
-    args << "-to" << QString::number(endFrame / static_cast<double>(fps));
-    // Output path
-    args << tempAudioPath;
-
-    STATUS_CHECK(MovieExporter::executeFFmpeg(ffmpegPath, args, [&progress, this] (int frame) { progress(frame / static_cast<float>(mDesc.endFrame - mDesc.startFrame)); return !mCanceled; }))
+
+    STATUS_CHECK(mixdown.writeWav(tempAudioPath))
     qDebug() << "audio file: " + tempAudioPath;
 
     return Status::OK;
@@ -273,6 +275,7 @@ Status MovieExporter::generateMovie(
         QString strOutputFile,
         std::function<void(float)> progress)
 {
+    TRACE_SCOPE("export", "MovieExporter::generateMovie");
     if (mCanceled)
     {
         return Status::CANCELED;
@@ -321,6 +324,12 @@ Status MovieExporter::generateMovie(
      */
     int frameWindow = static_cast<int>(1e9 / (camSize.width() * camSize.height() * 4.0));
 
+    /* Held drawings are only rendered once, frames with the same signature
+     * as the previous one send the last rendered image again.
+     */
+    QImage imageToExport;
+    FrameSignature lastSignature;
+
     // Build FFmpeg command
 
     //int exportFps = mDesc.videoFps;
@@ -374,15 +383,20 @@ Status MovieExporter::generateMovie(
 
         if((currentFrame - frameStart <= framesProcessed + frameWindow || failCounter > 10) && currentFrame <= frameEnd)
         {
-            QImage imageToExport = imageToExportBase.copy();
-            QPainter painter(&imageToExport);
-
             QTransform view = cameraLayer->getViewAtFrame(currentFrame);
-            painter.setWorldTransform(view * centralizeCamera);
-            painter.setWindow(QRect(0, 0, camSize.width(), camSize.height()));
-
-            obj->paintImage(painter, currentFrame, false, true);
-            painter.end();
+            FrameSignature signature = obj->frameSignature(currentFrame, view);
+            if (imageToExport.isNull() || signature != lastSignature)
+            {
+                TRACE_SCOPE("export", "MovieExporter::renderFrame");
+                imageToExport = imageToExportBase.copy();
+                QPainter painter(&imageToExport);
+                painter.setWorldTransform(view * centralizeCamera);
+                painter.setWindow(QRect(0, 0, camSize.width(), camSize.height()));
+
+                obj->paintImage(painter, currentFrame, false, true);
+                painter.end();
+                lastSignature = signature;
+            }
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
             int bytesWritten = ffmpeg.write(reinterpret_cast<const char*>(imageToExport.constBits()), imageToExport.sizeInBytes());
@@ -404,10 +418,14 @@ Status MovieExporter::generateMovie(
     return Status::OK;
 }
 
-/** Exports obj to a gif image at strOut using FFmpeg.
+/** Exports obj to a gif image at strOut.
+ *
+ *  The palette is built from a sample of the exported frames first, then
+ *  frames are rendered and streamed one at a time into a GifEncoder, which
+ *  only stores what changed since the previous frame. Memory use does not
+ *  depend on the length of the animation.
  *
  *  @param[in]  obj An Object containing the animation to export.
- *  @param[in]  ffmpegPath The path to the FFmpeg binary.
  *  @param[in]  strOut The output path. Should end with .gif.
  *  @param[out] progress A function that takes one float argument
  *              (the percentage of the gif generation complete) and
@@ -418,10 +436,10 @@ Status MovieExporter::generateMovie(
  */
 Status MovieExporter::generateGif(
         const Object* obj,
-        QString ffmpegPath,
         QString strOut,
         std::function<void(float)> progress)
 {
+    TRACE_SCOPE("export", "MovieExporter::generateGif");
 
     if (mCanceled)
     {
@@ -433,91 +451,86 @@ Status MovieExporter::generateGif(
     int frameStart = mDesc.startFrame;
     int frameEnd = mDesc.endFrame;
     const QSize exportSize = mDesc.exportSize;
-    bool transparency = false;
     QString strCameraName = mDesc.strCameraName;
     bool loop = mDesc.loop;
-    int bytesWritten;
 
     auto cameraLayer = static_cast<LayerCamera*>(obj->findLayerByName(strCameraName, Layer::CAMERA));
     if (cameraLayer == nullptr)
     {
         cameraLayer = obj->getLayersByType< LayerCamera >().front();
     }
-    int currentFrame = frameStart;
 
     /* We create an image with the correct dimensions and background
      * color here and then copy this and draw over top of it to
      * generate each frame. This is faster than having to generate
      * a new background image for each frame.
      */
-    QImage imageToExportBase(exportSize, QImage::Format_ARGB32_Premultiplied);
-    QColor bgColor = Qt::white;
-    if (transparency)
-    {
-        bgColor.setAlpha(0);
-    }
-    imageToExportBase.fill(bgColor);
+    QImage imageToExportBase(exportSize, QImage::Format_RGB32);
+    imageToExportBase.fill(Qt::white);
 
     QSize camSize = cameraLayer->getViewSize();
     QTransform centralizeCamera;
     centralizeCamera.translate(camSize.width() / 2, camSize.height() / 2);
 
-    // Build FFmpeg command
-
-    QStringList args = {"-f", "rawvideo", "-pixel_format", "bgra"};
-    args << "-video_size" << QString("%1x%2").arg(exportSize.width()).arg(exportSize.height());
-    args << "-framerate" << QString::number(mDesc.fps);
-
-    args << "-i" << "-";
+    auto renderFrame = [&](int frame, const QTransform& view)
+    {
+        TRACE_SCOPE("export", "MovieExporter::renderFrame");
+        QImage imageToExport = imageToExportBase.copy();
+        QPainter painter(&imageToExport);
+        painter.setWorldTransform(view * centralizeCamera);
+        painter.setWindow(QRect(0, 0, camSize.width(), camSize.height()));
 
-    args << "-y";
+        obj->paintImage(painter, frame, false, true);
+        return imageToExport;
+    };
 
-    args << "-filter_complex" << "[0:v]palettegen [p]; [0:v][p] paletteuse";
+    // Sample a few frames for the palette, scaled down to keep the first pass cheap
+    const int frameCount = frameEnd - frameStart + 1;
+    const int sampleCount = qMin(frameCount, 16);
+    QVector<QImage> samples;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        const int frame = frameStart + i * frameCount / sampleCount;
+        QImage sample = renderFrame(frame, cameraLayer->getViewAtFrame(frame));
+        if (sample.width() > 480)
+        {
+            sample = sample.scaledToWidth(480, Qt::FastTransformation);
+        }
+        samples.append(sample);
+    }
 
-    args << "-loop" << (loop ? "0" : "-1");
-    args << strOut;
+    GifEncoder encoder;
+    STATUS_CHECK(encoder.open(strOut, exportSize, GifEncoder::buildPalette(samples), loop))
+    samples.clear();
 
-    // Run FFmpeg command
+    QImage imageToExport;
+    FrameSignature lastSignature;
 
-    Status status = executeFFMpegPipe(ffmpegPath, args, progress, [&](QProcess& ffmpeg, int framesProcessed)
+    for (int currentFrame = frameStart; currentFrame <= frameEnd; currentFrame++)
     {
-        /* The GIF FFmpeg command requires the entires stream to be
-         * written before FFmpeg can encode the GIF. This is because
-         * the generated pallete is based off of the colors in all
-         * frames. The only way to avoid this would be to generate
-         * all the frames twice and run two separate commands, which
-         * would likely have unacceptable speed costs.
-         */
-
-        Q_UNUSED(framesProcessed);
-        if(currentFrame > frameEnd)
+        if (mCanceled)
         {
-            ffmpeg.closeWriteChannel();
-            return false;
+            encoder.cancel();
+            return Status::CANCELED;
         }
 
-        QImage imageToExport = imageToExportBase.copy();
-        QPainter painter(&imageToExport);
-
         QTransform view = cameraLayer->getViewAtFrame(currentFrame);
-        painter.setWorldTransform(view * centralizeCamera);
-        painter.setWindow(QRect(0, 0, camSize.width(), camSize.height()));
-
-        obj->paintImage(painter, currentFrame, false, true);
+        FrameSignature signature = obj->frameSignature(currentFrame, view);
+        if (imageToExport.isNull() || signature != lastSignature)
+        {
+            imageToExport = renderFrame(currentFrame, view);
+            lastSignature = signature;
+        }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-        bytesWritten = ffmpeg.write(reinterpret_cast<const char*>(imageToExport.constBits()), imageToExport.sizeInBytes());
-        Q_ASSERT(bytesWritten == imageToExport.sizeInBytes());
-#else
-        bytesWritten = ffmpeg.write(reinterpret_cast<const char*>(imageToExport.constBits()), imageToExport.byteCount());
-        Q_ASSERT(bytesWritten == imageToExport.byteCount());
-#endif
+        // GIF delays are in centiseconds, accumulate them so the timing does not drift
+        const int index = currentFrame - frameStart;
+        const int delay = qRound(100.0 * (index + 1) / mDesc.fps) - qRound(100.0 * index / mDesc.fps);
+        STATUS_CHECK(encoder.addFrame(imageToExport, delay))
 
-        currentFrame++;
+        progress((index + 1) / static_cast<float>(frameCount));
+    }
 
-        return true;
-    });
-    STATUS_CHECK(status);
+    STATUS_CHECK(encoder.close())
 
     return Status::OK;
 }
@@ -63,7 +63,7 @@ public:
 private:
     Status assembleAudio(const Object* obj, QString ffmpegPath, std::function<void(float)> progress);
     Status generateMovie(const Object *obj, QString ffmpegPath, QString strOutputFile, std::function<void(float)> progress);
-    Status generateGif(const Object *obj, QString ffmpeg, QString strOut, std::function<void(float)>  progress);
+    Status generateGif(const Object *obj, QString strOut, std::function<void(float)>  progress);
 
     Status executeFFMpegPipe(const QString& cmd, const QStringList& args, std::function<void(float)> progress, std::function<bool(QProcess&,int)> writeFrame);
     Status checkInputParameters(const ExportMovieDesc&);
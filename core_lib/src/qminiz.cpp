@@ -21,6 +21,7 @@ GNU General Public License for more details.
 #include <QDebug>
 #include <QDirIterator>
 #include "util.h"
+#include "tracer.h"
 
 
 Status MiniZ::sanityCheck(const QString& sZipFilePath)
@@ -67,6 +68,7 @@ size_t MiniZ::istreamReadCallback(void *pOpaque, mz_uint64 file_ofs, void * pBuf
 // ReSharper disable once CppInconsistentNaming
 Status MiniZ::compressFolder(QString zipFilePath, QString srcFolderPath, const QStringList& fileList, QString mimetype)
 {
+    TRACE_SCOPE("io", "MiniZ::compressFolder");
     DebugDetails dd;
     dd << "\n[Miniz COMPRESSION diagnostics]\n";
     dd << QString("Creating Zip %1 from folder %2").arg(zipFilePath, srcFolderPath);
@@ -160,6 +162,7 @@ Status MiniZ::compressFolder(QString zipFilePath, QString srcFolderPath, const Q
 
 Status MiniZ::uncompressFolder(QString zipFilePath, QString destPath)
 {
+    TRACE_SCOPE("io", "MiniZ::uncompressFolder");
     DebugDetails dd;
     dd << "\n[Miniz EXTRACTION diagnostics]\n";
     dd << QString("Unzip file %1 to folder %2").arg(zipFilePath, destPath);
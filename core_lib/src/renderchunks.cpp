@@ -0,0 +1,129 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "renderchunks.h"
+
+#include "layercamera.h"
+#include "object.h"
+
+namespace
+{
+    // Relative costs: writing the image dominates, each drawing adds its paint time
+    const double HELD_FRAME_COST = 0.1;
+    const double FRAME_COST = 1.0;
+    const double DRAWING_COST = 0.5;
+}
+
+QList<RenderChunk> RenderChunks::splitByCount(int startFrame, int endFrame, int chunkCount)
+{
+    QList<RenderChunk> chunks;
+    const int frameCount = endFrame - startFrame + 1;
+    if (frameCount <= 0 || chunkCount <= 0) { return chunks; }
+
+    chunkCount = qMin(chunkCount, frameCount);
+    const int baseSize = frameCount / chunkCount;
+    const int remainder = frameCount % chunkCount;
+
+    int frame = startFrame;
+    for (int i = 0; i < chunkCount; i++)
+    {
+        RenderChunk chunk;
+        chunk.startFrame = frame;
+        chunk.endFrame = frame + baseSize + (i < remainder ? 1 : 0) - 1;
+        chunks.append(chunk);
+        frame = chunk.endFrame + 1;
+    }
+    return chunks;
+}
+
+QList<RenderChunk> RenderChunks::splitByCost(int startFrame, const QVector<double>& costs, int chunkCount)
+{
+    QList<RenderChunk> chunks;
+    const int frameCount = costs.size();
+    if (frameCount == 0 || chunkCount <= 0) { return chunks; }
+
+    chunkCount = qMin(chunkCount, frameCount);
+
+    double total = 0;
+    for (double cost : costs)
+    {
+        total += qMax(cost, 0.0);
+    }
+    if (total <= 0)
+    {
+        return splitByCount(startFrame, startFrame + frameCount - 1, chunkCount);
+    }
+
+    int first = 0;
+    double accumulated = 0;
+    for (int i = 0; i < chunkCount; i++)
+    {
+        const int chunksLeft = chunkCount - i - 1;
+        int last = first;
+        accumulated += qMax(costs[last], 0.0);
+        if (chunksLeft == 0)
+        {
+            last = frameCount - 1;
+        }
+        else
+        {
+            // Close the chunk once its share of the total is reached,
+            // leaving at least one frame for each of the remaining chunks
+            const double target = total * (i + 1) / chunkCount;
+            while (last + 1 < frameCount - chunksLeft && accumulated < target)
+            {
+                last++;
+                accumulated += qMax(costs[last], 0.0);
+            }
+        }
+
+        RenderChunk chunk;
+        chunk.startFrame = startFrame + first;
+        chunk.endFrame = startFrame + last;
+        chunks.append(chunk);
+        first = last + 1;
+    }
+    return chunks;
+}
+
+QVector<double> RenderChunks::estimateCosts(const Object* object, const LayerCamera* cameraLayer, int startFrame, int endFrame)
+{
+    Q_ASSERT(object);
+    Q_ASSERT(cameraLayer);
+
+    QVector<double> costs;
+    costs.reserve(qMax(endFrame - startFrame + 1, 0));
+
+    FrameSignature lastSignature;
+    for (int frame = startFrame; frame <= endFrame; frame++)
+    {
+        FrameSignature signature = object->frameSignature(frame, cameraLayer->getViewAtFrame(frame));
+        if (frame > startFrame && signature == lastSignature)
+        {
+            costs.append(HELD_FRAME_COST);
+            continue;
+        }
+
+        double cost = FRAME_COST;
+        for (const auto& key : signature.keys)
+        {
+            if (key.first) { cost += DRAWING_COST; }
+        }
+        costs.append(cost);
+        lastSignature = signature;
+    }
+    return costs;
+}
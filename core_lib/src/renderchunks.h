@@ -0,0 +1,63 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef RENDERCHUNKS_H
+#define RENDERCHUNKS_H
+
+#include <QList>
+#include <QVector>
+
+class Object;
+class LayerCamera;
+
+/** A contiguous range of frames rendered as one job, both ends included */
+struct RenderChunk
+{
+    int startFrame = 1;
+    int endFrame = 1;
+
+    int frameCount() const { return endFrame - startFrame + 1; }
+    bool operator==(const RenderChunk& other) const { return startFrame == other.startFrame && endFrame == other.endFrame; }
+};
+
+/**
+ * Splits a frame range into contiguous chunks, so that each chunk can be
+ * rendered by a different process and the image sequences put back together.
+ *
+ * Every chunk holds at least one frame, so fewer chunks than requested are
+ * returned for ranges shorter than the chunk count.
+ */
+class RenderChunks
+{
+public:
+    /** Chunks whose frame counts differ by at most one */
+    static QList<RenderChunk> splitByCount(int startFrame, int endFrame, int chunkCount);
+
+    /**
+     * Chunks of about the same total cost.
+     * @param costs The cost of each frame, starting with @p startFrame
+     */
+    static QList<RenderChunk> splitByCost(int startFrame, const QVector<double>& costs, int chunkCount);
+
+    /**
+     * Estimates how expensive each frame is to export. Frames that show the same
+     * drawings as the frame before are copied by Object::exportFrames and cost little,
+     * other frames cost more the more drawings they show.
+     */
+    static QVector<double> estimateCosts(const Object* object, const LayerCamera* cameraLayer, int startFrame, int endFrame);
+};
+
+#endif // RENDERCHUNKS_H
@@ -0,0 +1,289 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "renderstats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QDateTime>
+#include <QJsonArray>
+
+namespace
+{
+    double toMsec(qint64 nsecs)
+    {
+        return nsecs / 1000000.0;
+    }
+}
+
+RenderStats::StageTimer::StageTimer(RenderStats* stats, Stage stage) :
+    mStats(stats),
+    mStage(stage)
+{
+    if (mStats == nullptr) { return; }
+
+    mOuterStage = mStats->mRunningStage;
+    mStats->mRunningStage = mStage;
+    mTimer.start();
+}
+
+RenderStats::StageTimer::~StageTimer()
+{
+    if (mStats == nullptr) { return; }
+
+    const qint64 elapsed = mTimer.nsecsElapsed();
+    mStats->addStageTime(mStage, elapsed);
+    if (mOuterStage != STAGE_COUNT && mOuterStage != mStage)
+    {
+        mStats->addStageTime(mOuterStage, -elapsed);
+    }
+    mStats->mRunningStage = mOuterStage;
+}
+
+RenderStats::RenderStats(int capacity) : mCapacity(qMax(capacity, 1))
+{
+    mSamples.reserve(mCapacity);
+}
+
+void RenderStats::beginPaint(int frame)
+{
+    mCurrent = Sample();
+    mCurrent.frame = frame;
+    mPainting = true;
+    mPaintTimer.start();
+}
+
+void RenderStats::endPaint()
+{
+    if (!mPainting) { return; }
+
+    mCurrent.nsecs[STAGE_COUNT] = mPaintTimer.nsecsElapsed();
+    mPainting = false;
+
+    if (mSamples.size() < mCapacity)
+    {
+        mSamples.append(mCurrent);
+    }
+    else
+    {
+        mSamples[mNextSample] = mCurrent;
+        mNextSample = (mNextSample + 1) % mCapacity;
+    }
+}
+
+void RenderStats::addStageTime(Stage stage, qint64 nsecs)
+{
+    Q_ASSERT(stage >= 0 && stage < STAGE_COUNT);
+    // Work done outside of a paint, e.g. while rendering the cache ahead of time, is not recorded
+    if (!mPainting) { return; }
+    mCurrent.nsecs[stage] += nsecs;
+}
+
+void RenderStats::countCache(Cache cache, bool hit)
+{
+    Q_ASSERT(cache >= 0 && cache < CACHE_COUNT);
+    if (hit) {
+        mHits[cache]++;
+    } else {
+        mMisses[cache]++;
+    }
+}
+
+double RenderStats::percentile(Stage stage, double percent) const
+{
+    return percentileOf(stage, percent);
+}
+
+double RenderStats::maximum(Stage stage) const
+{
+    return maximumOf(stage);
+}
+
+double RenderStats::totalPercentile(double percent) const
+{
+    return percentileOf(STAGE_COUNT, percent);
+}
+
+double RenderStats::totalMaximum() const
+{
+    return maximumOf(STAGE_COUNT);
+}
+
+double RenderStats::percentileOf(int column, double percent) const
+{
+    if (mSamples.isEmpty()) { return 0; }
+
+    QVector<qint64> values;
+    values.reserve(mSamples.size());
+    for (const Sample& sample : mSamples)
+    {
+        values.append(sample.nsecs[column]);
+    }
+
+    // Nearest rank
+    const int rank = static_cast<int>(std::ceil(qBound(0.0, percent, 100.0) / 100.0 * values.size()));
+    const int index = qBound(0, rank - 1, values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return toMsec(values[index]);
+}
+
+double RenderStats::maximumOf(int column) const
+{
+    qint64 maximum = 0;
+    for (const Sample& sample : mSamples)
+    {
+        maximum = qMax(maximum, sample.nsecs[column]);
+    }
+    return toMsec(maximum);
+}
+
+QVector<RenderStats::Sample> RenderStats::orderedSamples() const
+{
+    if (mSamples.size() < mCapacity) { return mSamples; }
+    return mSamples.mid(mNextSample) + mSamples.mid(0, mNextSample);
+}
+
+void RenderStats::reset()
+{
+    mSamples.clear();
+    mNextSample = 0;
+    mPainting = false;
+    mRunningStage = STAGE_COUNT;
+    std::fill(std::begin(mHits), std::end(mHits), 0);
+    std::fill(std::begin(mMisses), std::end(mMisses), 0);
+}
+
+QString RenderStats::stageName(Stage stage)
+{
+    switch (stage)
+    {
+    case PREP: return tr("Preparation");
+    case ONION_SKIN: return tr("Onion skin");
+    case LAYERS: return tr("Layers");
+    case CAMERA_OVERLAY: return tr("Camera and overlays");
+    case TOOL_OVERLAY: return tr("Tool");
+    case SELECTION: return tr("Selection");
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+QString RenderStats::cacheName(Cache cache)
+{
+    switch (cache)
+    {
+    case FRAME_CACHE: return tr("Frames");
+    case PRE_LAYERS_CACHE: return tr("Layers below");
+    case POST_LAYERS_CACHE: return tr("Layers above");
+    case ONION_SKIN_CACHE: return tr("Onion skin");
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+QString RenderStats::stageId(Stage stage)
+{
+    switch (stage)
+    {
+    case PREP: return "prep";
+    case ONION_SKIN: return "onion_skin";
+    case LAYERS: return "layers";
+    case CAMERA_OVERLAY: return "camera_overlay";
+    case TOOL_OVERLAY: return "tool_overlay";
+    case SELECTION: return "selection";
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+QString RenderStats::cacheId(Cache cache)
+{
+    switch (cache)
+    {
+    case FRAME_CACHE: return "frame";
+    case PRE_LAYERS_CACHE: return "pre_layers";
+    case POST_LAYERS_CACHE: return "post_layers";
+    case ONION_SKIN_CACHE: return "onion_skin";
+    default: Q_UNREACHABLE(); return QString();
+    }
+}
+
+QJsonObject RenderStats::toJson() const
+{
+    auto summary = [this](int column)
+    {
+        QJsonObject stats;
+        stats["p50_ms"] = percentileOf(column, 50);
+        stats["p95_ms"] = percentileOf(column, 95);
+        stats["max_ms"] = maximumOf(column);
+        return stats;
+    };
+
+    QJsonObject stages;
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        stages[stageId(static_cast<Stage>(i))] = summary(i);
+    }
+
+    QJsonObject caches;
+    for (int i = 0; i < CACHE_COUNT; i++)
+    {
+        QJsonObject cache;
+        cache["hits"] = mHits[i];
+        cache["misses"] = mMisses[i];
+        caches[cacheId(static_cast<Cache>(i))] = cache;
+    }
+
+    QJsonArray samples;
+    for (const Sample& sample : orderedSamples())
+    {
+        QJsonObject paint;
+        paint["frame"] = sample.frame;
+        paint["total_ms"] = toMsec(sample.nsecs[STAGE_COUNT]);
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            paint[stageId(static_cast<Stage>(i)) + "_ms"] = toMsec(sample.nsecs[i]);
+        }
+        samples.append(paint);
+    }
+
+    QJsonObject json;
+    json["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["sample_count"] = mSamples.size();
+    json["total"] = summary(STAGE_COUNT);
+    json["stages"] = stages;
+    json["caches"] = caches;
+    json["samples"] = samples;
+    return json;
+}
+
+QString RenderStats::toCsv() const
+{
+    QStringList header{ "frame", "total_ms" };
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        header << stageId(static_cast<Stage>(i)) + "_ms";
+    }
+
+    QStringList lines{ header.join(',') };
+    for (const Sample& sample : orderedSamples())
+    {
+        QStringList fields{ QString::number(sample.frame), QString::number(toMsec(sample.nsecs[STAGE_COUNT]), 'f', 3) };
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            fields << QString::number(toMsec(sample.nsecs[i]), 'f', 3);
+        }
+        lines << fields.join(',');
+    }
+    return lines.join('\n') + '\n';
+}
@@ -0,0 +1,128 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QVector>
+
+/**
+ * Records how long the canvas takes to paint, split by stage, for the last few hundred paints,
+ * and how often the render caches are hit.
+ *
+ * A paint is recorded between beginPaint() and endPaint(). Stages are timed with StageTimer;
+ * when stages are nested, the time spent in the inner stage is not counted in the outer one.
+ */
+class RenderStats
+{
+    Q_DECLARE_TR_FUNCTIONS(RenderStats)
+public:
+    enum Stage
+    {
+        PREP,
+        ONION_SKIN,
+        LAYERS,
+        CAMERA_OVERLAY,
+        TOOL_OVERLAY,
+        SELECTION,
+        STAGE_COUNT
+    };
+
+    enum Cache
+    {
+        FRAME_CACHE,
+        PRE_LAYERS_CACHE,
+        POST_LAYERS_CACHE,
+        ONION_SKIN_CACHE,
+        CACHE_COUNT
+    };
+
+    /** Times a stage from construction to destruction, does nothing when @p stats is null */
+    class StageTimer
+    {
+    public:
+        StageTimer(RenderStats* stats, Stage stage);
+        ~StageTimer();
+
+    private:
+        RenderStats* mStats = nullptr;
+        Stage mStage = STAGE_COUNT;
+        Stage mOuterStage = STAGE_COUNT;
+        QElapsedTimer mTimer;
+    };
+
+    explicit RenderStats(int capacity = 240);
+
+    void beginPaint(int frame);
+    void endPaint();
+    void addStageTime(Stage stage, qint64 nsecs);
+    void countCache(Cache cache, bool hit);
+
+    /** The number of paints kept, at most the capacity */
+    int sampleCount() const { return mSamples.size(); }
+
+    /** Time in milliseconds below which @p percent % of the kept paints spent in @p stage */
+    double percentile(Stage stage, double percent) const;
+    double maximum(Stage stage) const;
+    /** The same over the whole paint, including the work not attributed to a stage */
+    double totalPercentile(double percent) const;
+    double totalMaximum() const;
+
+    int hits(Cache cache) const { return mHits[cache]; }
+    int misses(Cache cache) const { return mMisses[cache]; }
+
+    void reset();
+
+    /** A name for display */
+    static QString stageName(Stage stage);
+    static QString cacheName(Cache cache);
+    /** A stable name for machine readable output */
+    static QString stageId(Stage stage);
+    static QString cacheId(Cache cache);
+
+    /** The rolling statistics, the cache counters and every kept paint */
+    QJsonObject toJson() const;
+    /** One line per kept paint, oldest first, times in milliseconds */
+    QString toCsv() const;
+
+private:
+    struct Sample
+    {
+        int frame = 0;
+        qint64 nsecs[STAGE_COUNT + 1] = {}; // the stages, then the whole paint
+    };
+
+    double percentileOf(int column, double percent) const;
+    double maximumOf(int column) const;
+    QVector<Sample> orderedSamples() const;
+
+    int mCapacity = 0;
+    QVector<Sample> mSamples;
+    int mNextSample = 0; // where the next paint goes once the buffer is full
+
+    Sample mCurrent;
+    QElapsedTimer mPaintTimer;
+    bool mPainting = false;
+    Stage mRunningStage = STAGE_COUNT;
+
+    int mHits[CACHE_COUNT] = {};
+    int mMisses[CACHE_COUNT] = {};
+};
+
+#endif // RENDERSTATS_H
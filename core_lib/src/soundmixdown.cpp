@@ -0,0 +1,400 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "soundmixdown.h"
+
+#include <cstring>
+#include <QDebug>
+#include <QFile>
+#include <QDataStream>
+#include <QProcess>
+#include <QAudioBuffer>
+#include <QAudioDecoder>
+#include <QEventLoop>
+#include <QUrl>
+#include <QtEndian>
+#include <QtMath>
+
+namespace
+{
+    const quint16 WAVE_FORMAT_PCM = 0x0001;
+    const quint16 WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+    const quint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    float readSample(const uchar* p, quint16 format, int bits)
+    {
+        if (format == WAVE_FORMAT_IEEE_FLOAT)
+        {
+            if (bits == 32)
+            {
+                quint32 raw = qFromLittleEndian<quint32>(p);
+                float f;
+                memcpy(&f, &raw, sizeof(f));
+                return f;
+            }
+            quint64 raw = qFromLittleEndian<quint64>(p);
+            double d;
+            memcpy(&d, &raw, sizeof(d));
+            return static_cast<float>(d);
+        }
+
+        switch (bits)
+        {
+        case 8: return (p[0] - 128) / 128.f;
+        case 16: return qFromLittleEndian<qint16>(p) / 32768.f;
+        case 24:
+        {
+            qint32 v = p[0] | (p[1] << 8) | (p[2] << 16);
+            if (v & 0x800000) v |= ~0xFFFFFF; // sign extend
+            return v / 8388608.f;
+        }
+        case 32: return static_cast<float>(qFromLittleEndian<qint32>(p) / 2147483648.0);
+        default: return 0.f;
+        }
+    }
+
+    QVector<float> resample(const QVector<float>& input, int fromRate, int toRate)
+    {
+        if (fromRate == toRate || input.isEmpty()) return input;
+
+        const double step = static_cast<double>(fromRate) / toRate;
+        const int outputSize = static_cast<int>(input.size() / step);
+        QVector<float> output(outputSize);
+        for (int i = 0; i < outputSize; i++)
+        {
+            const double pos = i * step;
+            const int i0 = static_cast<int>(pos);
+            const int i1 = qMin(i0 + 1, input.size() - 1);
+            const float t = static_cast<float>(pos - i0);
+            output[i] = input[i0] + (input[i1] - input[i0]) * t;
+        }
+        return output;
+    }
+
+    float audioBufferSample(const QAudioBuffer& buffer, int index)
+    {
+        const QAudioFormat format = buffer.format();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        switch (format.sampleFormat())
+        {
+        case QAudioFormat::Float: return buffer.constData<float>()[index];
+        case QAudioFormat::Int16: return buffer.constData<qint16>()[index] / 32768.f;
+        case QAudioFormat::Int32: return static_cast<float>(buffer.constData<qint32>()[index] / 2147483648.0);
+        case QAudioFormat::UInt8: return (buffer.constData<quint8>()[index] - 128) / 128.f;
+        default: return 0.f;
+        }
+#else
+        if (format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32)
+        {
+            return buffer.constData<float>()[index];
+        }
+        switch (format.sampleSize())
+        {
+        case 8: return (buffer.constData<quint8>()[index] - 128) / 128.f;
+        case 16: return buffer.constData<qint16>()[index] / 32768.f;
+        case 32: return static_cast<float>(buffer.constData<qint32>()[index] / 2147483648.0);
+        default: return 0.f;
+        }
+#endif
+    }
+}
+
+SoundMixdown::SoundMixdown(qint64 sampleCount)
+{
+    mSamples.fill(0.f, static_cast<int>(qMax<qint64>(sampleCount, 0)));
+}
+
+void SoundMixdown::mix(const QVector<float>& samples, qint64 offset)
+{
+    const qint64 begin = qMax<qint64>(0, -offset);
+    const qint64 end = qMin<qint64>(samples.size(), mSamples.size() - offset);
+
+    const float* src = samples.constData();
+    float* dst = mSamples.data();
+    for (qint64 i = begin; i < end; i++)
+    {
+        dst[offset + i] += src[i];
+    }
+}
+
+Status SoundMixdown::writeWav(const QString& filePath, int channels) const
+{
+    DebugDetails dd;
+    dd << "SoundMixdown::writeWav";
+    dd << QString("filePath = ").append(filePath);
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+    {
+        dd << ("file.error() = " + file.errorString());
+        return Status(Status::FAIL, dd);
+    }
+
+    const quint16 bitsPerSample = 16;
+    const quint16 blockAlign = static_cast<quint16>(channels * bitsPerSample / 8);
+    const quint32 dataSize = static_cast<quint32>(mSamples.size()) * blockAlign;
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("RIFF", 4);
+    out << quint32(36 + dataSize);
+    out.writeRawData("WAVE", 4);
+    out.writeRawData("fmt ", 4);
+    out << quint32(16) << WAVE_FORMAT_PCM << quint16(channels) << quint32(SAMPLE_RATE)
+        << quint32(SAMPLE_RATE * blockAlign) << blockAlign << bitsPerSample;
+    out.writeRawData("data", 4);
+    out << dataSize;
+
+    QByteArray pcm(static_cast<int>(dataSize), Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(pcm.data());
+    for (float sample : mSamples)
+    {
+        const qint16 value = static_cast<qint16>(qBound(-32768, qRound(sample * 32767.f), 32767));
+        for (int c = 0; c < channels; c++)
+        {
+            qToLittleEndian<qint16>(value, p);
+            p += 2;
+        }
+    }
+    out.writeRawData(pcm.constData(), pcm.size());
+
+    if (out.status() != QDataStream::Ok)
+    {
+        dd << "Error: Failed to write the audio data";
+        return Status(Status::FAIL, dd);
+    }
+    return Status::OK;
+}
+
+/** Decodes a sound file to mono float samples at SAMPLE_RATE.
+ *  WAV files are read natively, ffmpeg is only started for other formats,
+ *  and the decoder of the platform is used when ffmpeg can't be run. */
+Status SoundMixdown::decode(const QString& filePath, const QString& ffmpegPath, QVector<float>& samples)
+{
+    QFile file(filePath);
+    if (file.open(QFile::ReadOnly) && decodeWav(file, samples))
+    {
+        return Status::OK;
+    }
+    file.close();
+
+    Status st = decodeWithFFmpeg(filePath, ffmpegPath, samples);
+    if (!st.ok() && decodeWithQt(filePath, samples).ok())
+    {
+        return Status::OK;
+    }
+    return st;
+}
+
+/** Reads a RIFF/WAVE stream with integer or float PCM data.
+ *  @return false if the stream is not a WAV file this decoder understands */
+bool SoundMixdown::decodeWav(QIODevice& device, QVector<float>& samples)
+{
+    const QByteArray bytes = device.readAll();
+    const uchar* data = reinterpret_cast<const uchar*>(bytes.constData());
+    const int size = bytes.size();
+
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    quint16 format = 0;
+    int channels = 0;
+    int sampleRate = 0;
+    int bits = 0;
+    const uchar* pcm = nullptr;
+    int pcmSize = 0;
+
+    int pos = 12;
+    while (pos + 8 <= size)
+    {
+        const uchar* chunk = data + pos;
+        const int chunkSize = static_cast<int>(qMin<quint32>(qFromLittleEndian<quint32>(chunk + 4), static_cast<quint32>(size - pos - 8)));
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16)
+        {
+            format = qFromLittleEndian<quint16>(chunk + 8);
+            channels = qFromLittleEndian<quint16>(chunk + 10);
+            sampleRate = static_cast<int>(qFromLittleEndian<quint32>(chunk + 12));
+            bits = qFromLittleEndian<quint16>(chunk + 22);
+            if (format == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26)
+            {
+                format = qFromLittleEndian<quint16>(chunk + 32); // first bytes of the sub format GUID
+            }
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            pcm = chunk + 8;
+            pcmSize = chunkSize;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1); // chunks are word aligned
+    }
+
+    const bool supportedFormat = (format == WAVE_FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32))
+        || (format == WAVE_FORMAT_IEEE_FLOAT && (bits == 32 || bits == 64));
+    if (!supportedFormat || pcm == nullptr || channels <= 0 || sampleRate <= 0)
+    {
+        return false;
+    }
+
+    const int bytesPerSample = bits / 8;
+    const int frameCount = pcmSize / (bytesPerSample * channels);
+
+    QVector<float> mono(frameCount);
+    for (int i = 0; i < frameCount; i++)
+    {
+        const uchar* frame = pcm + i * bytesPerSample * channels;
+        float sum = 0.f;
+        for (int c = 0; c < channels; c++)
+        {
+            sum += readSample(frame + c * bytesPerSample, format, bits);
+        }
+        mono[i] = sum / channels;
+    }
+
+    samples = resample(mono, sampleRate, SAMPLE_RATE);
+    return true;
+}
+
+/** Uses ffmpeg as a plain decoder, piping raw mono float samples back through stdout. */
+Status SoundMixdown::decodeWithFFmpeg(const QString& filePath, const QString& ffmpegPath, QVector<float>& samples)
+{
+    DebugDetails dd;
+    dd << "SoundMixdown::decodeWithFFmpeg";
+    dd << QString("filePath = ").append(filePath);
+
+    QStringList args;
+    args << "-nostdin" << "-v" << "error" << "-i" << filePath;
+    args << "-f" << "f32le" << "-acodec" << "pcm_f32le" << "-ac" << "1" << "-ar" << QString::number(SAMPLE_RATE) << "-";
+
+    QProcess ffmpeg;
+    ffmpeg.start(ffmpegPath, args);
+    if (!ffmpeg.waitForStarted())
+    {
+        dd << "Error: Could not execute FFmpeg";
+        return Status(Status::FAIL, dd);
+    }
+
+    QByteArray pcm;
+    while (ffmpeg.state() == QProcess::Running)
+    {
+        ffmpeg.waitForReadyRead();
+        pcm += ffmpeg.readAllStandardOutput();
+    }
+    ffmpeg.waitForFinished();
+    pcm += ffmpeg.readAllStandardOutput();
+
+    if (ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0)
+    {
+        dd << QString::fromLocal8Bit(ffmpeg.readAllStandardError());
+        dd << QString("Exit code: %1").arg(ffmpeg.exitCode());
+        return Status(Status::FAIL, dd);
+    }
+
+    const int count = pcm.size() / static_cast<int>(sizeof(float));
+    samples.resize(count);
+    const uchar* p = reinterpret_cast<const uchar*>(pcm.constData());
+    for (int i = 0; i < count; i++)
+    {
+        quint32 raw = qFromLittleEndian<quint32>(p + i * 4);
+        memcpy(&samples[i], &raw, sizeof(float));
+    }
+    return Status::OK;
+}
+
+Status SoundMixdown::decodeWithQt(const QString& filePath, QVector<float>& samples)
+{
+    DebugDetails dd;
+    dd << "SoundMixdown::decodeWithQt";
+    dd << QString("filePath = ").append(filePath);
+
+    // Only a request, the backend may hand out buffers in another format
+    QAudioFormat format;
+    format.setSampleRate(SAMPLE_RATE);
+    format.setChannelCount(1);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    format.setSampleFormat(QAudioFormat::Float);
+#else
+    format.setCodec("audio/pcm");
+    format.setSampleSize(32);
+    format.setSampleType(QAudioFormat::Float);
+#endif
+
+    QAudioDecoder decoder;
+    decoder.setAudioFormat(format);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    decoder.setSource(QUrl::fromLocalFile(filePath));
+#else
+    decoder.setSourceFilename(filePath);
+#endif
+
+    QVector<float> mono;
+    int sampleRate = SAMPLE_RATE;
+    bool done = false;
+    bool failed = false;
+    QEventLoop loop;
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, [&]
+    {
+        const QAudioBuffer buffer = decoder.read();
+        const int channels = buffer.format().channelCount();
+        if (!buffer.isValid() || channels <= 0) { return; }
+
+        sampleRate = buffer.format().sampleRate();
+        const int frameCount = buffer.frameCount();
+        mono.reserve(mono.size() + frameCount);
+        for (int i = 0; i < frameCount; i++)
+        {
+            float sum = 0.f;
+            for (int c = 0; c < channels; c++)
+            {
+                sum += audioBufferSample(buffer, i * channels + c);
+            }
+            mono.append(sum / channels);
+        }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, [&]
+    {
+        done = true;
+        loop.quit();
+    });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), [&]
+    {
+        done = true;
+        failed = true;
+        loop.quit();
+    });
+
+    decoder.start();
+    if (!done) // errors may be reported right away
+    {
+        loop.exec();
+    }
+
+    if (failed || mono.isEmpty())
+    {
+        dd << QString("Error: %1").arg(decoder.errorString());
+        return Status(Status::FAIL, dd);
+    }
+
+    samples = resample(mono, sampleRate, SAMPLE_RATE);
+    return Status::OK;
+}
+
+qint64 SoundMixdown::frameToSample(int frame, int fps)
+{
+    return qRound64(static_cast<double>(SAMPLE_RATE) * (frame - 1) / fps);
+}
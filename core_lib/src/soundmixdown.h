@@ -0,0 +1,61 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef SOUNDMIXDOWN_H
+#define SOUNDMIXDOWN_H
+
+#include <QVector>
+#include "pencilerror.h"
+
+class QIODevice;
+
+/**
+ * Mixes decoded sound clips into a single mono PCM buffer.
+ *
+ * Clips are decoded to mono 32-bit float samples at SAMPLE_RATE, either natively
+ * for WAV files, or through ffmpeg as a plain decoder for everything else,
+ * falling back to the platform decoder of Qt Multimedia when ffmpeg is missing.
+ * They are then summed at sample accurate offsets.
+ */
+class SoundMixdown
+{
+public:
+    static const int SAMPLE_RATE = 44100;
+
+    explicit SoundMixdown(qint64 sampleCount);
+
+    /** Adds samples to the mix, starting at sample @p offset. The offset may be negative. */
+    void mix(const QVector<float>& samples, qint64 offset);
+
+    /** Writes the mix as a 16-bit PCM WAV file, duplicating the mono mix on each channel. */
+    Status writeWav(const QString& filePath, int channels = 2) const;
+
+    const QVector<float>& samples() const { return mSamples; }
+
+    static Status decode(const QString& filePath, const QString& ffmpegPath, QVector<float>& samples);
+    static bool decodeWav(QIODevice& device, QVector<float>& samples);
+    static Status decodeWithFFmpeg(const QString& filePath, const QString& ffmpegPath, QVector<float>& samples);
+    /** Decodes with QAudioDecoder, waiting in a local event loop, so it can be called from worker threads too. */
+    static Status decodeWithQt(const QString& filePath, QVector<float>& samples);
+
+    /** Index of the first sample of @p frame, counting frames from 1. */
+    static qint64 frameToSample(int frame, int fps);
+
+private:
+    QVector<float> mSamples;
+};
+
+#endif // SOUNDMIXDOWN_H
@@ -0,0 +1,303 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "soundmixer.h"
+
+#include <QAudioFormat>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QAudioSink>
+#include <QMediaDevices>
+#else
+#include <QAudioDeviceInfo>
+#include <QAudioOutput>
+#endif
+
+#include "soundmixdown.h"
+#include "util.h"
+
+namespace
+{
+    const int CHANNELS = 2;
+    const int BYTES_PER_FRAME = CHANNELS * static_cast<int>(sizeof(qint16));
+    const int BUFFER_MSEC = 50;
+}
+
+SoundMixer::SoundMixer(QObject* parent) : QIODevice(parent)
+{
+}
+
+SoundMixer::~SoundMixer()
+{
+    mDecodePool.clear();
+    mDecodePool.waitForDone();
+    stop();
+}
+
+void SoundMixer::clearClips()
+{
+    QMutexLocker locker(&mMutex);
+    mClips.clear();
+    mClipFiles.clear();
+}
+
+bool SoundMixer::addClip(const QString& fileName, qint64 startSample)
+{
+    if (fileName.isEmpty()) { return false; }
+
+    const QFileInfo fileInfo(fileName);
+    if (!fileInfo.exists()) { return false; }
+
+    const QDateTime modified = fileInfo.lastModified();
+    auto it = mDecoded.find(fileName);
+    if (it == mDecoded.end() || it->modified != modified)
+    {
+        decodeFile(fileName, modified);
+        it = mDecoded.find(fileName);
+    }
+    // Failed files are cached as silence, so they are not decoded again on every play
+    if (!it->pending && it->samples.isEmpty()) { return false; }
+
+    Clip clip;
+    clip.fileName = fileName;
+    clip.samples = it->samples; // still empty while decoding, filled in by fileDecoded()
+    clip.startSample = startSample;
+
+    QMutexLocker locker(&mMutex);
+    mClips.append(clip);
+    mClipFiles.append(fileName);
+    return true;
+}
+
+void SoundMixer::decode(const QString& fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    if (fileName.isEmpty() || !fileInfo.exists())
+    {
+        emit decoded(fileName, QVector<float>());
+        return;
+    }
+
+    const QDateTime modified = fileInfo.lastModified();
+    auto it = mDecoded.find(fileName);
+    if (it == mDecoded.end() || it->modified != modified)
+    {
+        decodeFile(fileName, modified);
+    }
+    else if (!it->pending)
+    {
+        emit decoded(fileName, it->samples);
+    }
+    // otherwise fileDecoded() emits it once the file being decoded is done
+}
+
+void SoundMixer::decodeFile(const QString& fileName, const QDateTime& modified)
+{
+    DecodedFile decoded;
+    decoded.modified = modified;
+    {
+        QMutexLocker locker(&mMutex);
+        mDecoded.insert(fileName, decoded);
+    }
+
+    const QString ffmpegPath = ffmpegLocation();
+    mDecodePool.start([this, fileName, modified, ffmpegPath]
+    {
+        QVector<float> samples;
+        Status st = SoundMixdown::decode(fileName, ffmpegPath, samples);
+        if (!st.ok())
+        {
+            qDebug() << "SoundMixer: Failed to decode" << fileName;
+        }
+        QMetaObject::invokeMethod(this, [this, fileName, modified, samples]
+        {
+            fileDecoded(fileName, modified, samples);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SoundMixer::fileDecoded(const QString& fileName, const QDateTime& modified, const QVector<float>& samples)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        auto it = mDecoded.find(fileName);
+        if (it == mDecoded.end() || it->modified != modified) { return; } // changed in the meantime
+
+        it->samples = samples;
+        it->pending = false;
+        for (Clip& clip : mClips)
+        {
+            if (clip.fileName == fileName)
+            {
+                clip.samples = samples;
+            }
+        }
+    }
+    emit decoded(fileName, samples);
+}
+
+void SoundMixer::waitForDecoding()
+{
+    mDecodePool.waitForDone();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+void SoundMixer::releaseUnusedClips()
+{
+    QMutexLocker locker(&mMutex);
+    for (auto it = mDecoded.begin(); it != mDecoded.end();)
+    {
+        // Files still being decoded are kept, decoded() has to be emitted for them
+        if (mClipFiles.contains(it.key()) || it->pending)
+        {
+            ++it;
+        }
+        else
+        {
+            it = mDecoded.erase(it);
+        }
+    }
+}
+
+quint64 SoundMixer::memoryUsage() const
+{
+    QMutexLocker locker(&mMutex);
+    quint64 bytes = 0;
+    for (const DecodedFile& decoded : mDecoded)
+    {
+        bytes += decoded.samples.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+void SoundMixer::start(qint64 sample, qint64 sampleCount)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mPosition = sample;
+        mEndPosition = (sampleCount > 0) ? sample + sampleCount : -1;
+    }
+
+    if (isActive()) { return; } // already streaming, it picks up the new position
+
+    if (mSink == nullptr)
+    {
+        QAudioFormat format;
+        format.setSampleRate(SoundMixdown::SAMPLE_RATE);
+        format.setChannelCount(CHANNELS);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        format.setSampleFormat(QAudioFormat::Int16);
+        mSink = new QAudioSink(QMediaDevices::defaultAudioOutput(), format, this);
+#else
+        format.setSampleSize(16);
+        format.setCodec("audio/pcm");
+        format.setSampleType(QAudioFormat::SignedInt);
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        mSink = new QAudioOutput(QAudioDeviceInfo::defaultOutputDevice(), format, this);
+#endif
+        // Keep the buffer short, it is what seeking and starting lag behind by
+        mSink->setBufferSize(SoundMixdown::SAMPLE_RATE * BUFFER_MSEC / 1000 * BYTES_PER_FRAME);
+    }
+
+    if (!isOpen())
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered); // buffering would delay seeking
+    }
+    mSink->start(this);
+}
+
+void SoundMixer::stop()
+{
+    if (mSink)
+    {
+        mSink->stop();
+    }
+    if (isOpen())
+    {
+        close();
+    }
+}
+
+bool SoundMixer::isActive() const
+{
+    return mSink && mSink->state() != QAudio::StoppedState;
+}
+
+void SoundMixer::setPosition(qint64 sample)
+{
+    QMutexLocker locker(&mMutex);
+    mPosition = sample;
+    mEndPosition = -1;
+}
+
+qint64 SoundMixer::bytesAvailable() const
+{
+    // The mix never runs dry, silence is streamed past the end of the clips
+    return SoundMixdown::SAMPLE_RATE * BYTES_PER_FRAME + QIODevice::bytesAvailable();
+}
+
+qint64 SoundMixer::readData(char* data, qint64 maxSize)
+{
+    const int frameCount = static_cast<int>(maxSize / BYTES_PER_FRAME);
+    if (frameCount <= 0) { return 0; }
+
+    QVector<float> mix(frameCount, 0.f);
+
+    QMutexLocker locker(&mMutex);
+    const qint64 position = mPosition;
+    qint64 end = position + frameCount;
+    if (mEndPosition >= 0)
+    {
+        end = qBound(position, mEndPosition, end);
+    }
+
+    float* dst = mix.data();
+    for (const Clip& clip : mClips)
+    {
+        const qint64 first = qMax(position, clip.startSample);
+        const qint64 last = qMin(end, clip.startSample + clip.samples.size());
+        if (first >= last) { continue; }
+
+        const float* src = clip.samples.constData() + (first - clip.startSample);
+        for (qint64 i = first; i < last; i++)
+        {
+            dst[i - position] += *src++;
+        }
+    }
+    mPosition += frameCount;
+    locker.unlock();
+
+    uchar* out = reinterpret_cast<uchar*>(data);
+    for (float sample : mix)
+    {
+        const qint16 value = static_cast<qint16>(qBound(-32768, qRound(sample * 32767.f), 32767));
+        for (int c = 0; c < CHANNELS; c++)
+        {
+            qToLittleEndian<qint16>(value, out);
+            out += sizeof(qint16);
+        }
+    }
+    return static_cast<qint64>(frameCount) * BYTES_PER_FRAME;
+}
+
+qint64 SoundMixer::writeData(const char*, qint64)
+{
+    return -1;
+}
@@ -0,0 +1,120 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef SOUNDMIXER_H
+#define SOUNDMIXER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QIODevice>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+class QAudioSink;
+typedef QAudioSink AudioSink;
+#else
+class QAudioOutput;
+typedef QAudioOutput AudioSink;
+#endif
+
+/**
+ * Mixes sound clips into a single audio output stream while playing back.
+ *
+ * Clips are decoded once to mono float PCM on a worker thread and cached by file name
+ * and modification time. A clip is silent until its file has been decoded. The same
+ * samples are handed out through decoded(), so the waveform peaks don't decode them again. The audio
+ * device pulls the mix from this device, which sums every clip overlapping the
+ * requested samples, so clips start at sample accurate offsets no matter how
+ * many of them overlap.
+ */
+class SoundMixer : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit SoundMixer(QObject* parent = nullptr);
+    ~SoundMixer() override;
+
+    /** Removes all clips from the mix. Decoded samples stay cached. */
+    void clearClips();
+    /**
+     * Adds the sound file to the mix, starting at @p startSample.
+     * Starts decoding it in the background on first use, or once the file has changed.
+     * @return false if the file is missing or could not be decoded before
+     */
+    bool addClip(const QString& fileName, qint64 startSample);
+    /**
+     * Decodes the sound file in the background unless its samples are already cached.
+     * decoded() is emitted once they are ready, right away if they were cached.
+     */
+    void decode(const QString& fileName);
+    /** Blocks until the files being decoded have been added to the mix */
+    void waitForDecoding();
+    /** Drops the cached samples of files that are no longer part of the mix. */
+    void releaseUnusedClips();
+    /** Bytes held by the decoded clips */
+    quint64 memoryUsage() const;
+
+    /** Starts the output stream at @p sample. If @p sampleCount is positive, only that many samples are heard. */
+    void start(qint64 sample, qint64 sampleCount = 0);
+    void stop();
+    bool isActive() const;
+
+    /** Moves the stream to @p sample and lifts the sample count limit of start(). */
+    void setPosition(qint64 sample);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+signals:
+    /** The samples of @p fileName are ready, they are empty if it could not be decoded */
+    void decoded(const QString& fileName, const QVector<float>& samples);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    struct Clip
+    {
+        QString fileName;
+        QVector<float> samples;
+        qint64 startSample = 0;
+    };
+    struct DecodedFile
+    {
+        QDateTime modified;
+        QVector<float> samples;
+        bool pending = true;
+    };
+
+    void decodeFile(const QString& fileName, const QDateTime& modified);
+    void fileDecoded(const QString& fileName, const QDateTime& modified, const QVector<float>& samples);
+
+    AudioSink* mSink = nullptr;
+    QThreadPool mDecodePool;
+
+    mutable QMutex mMutex;
+    QVector<Clip> mClips;
+    QHash<QString, DecodedFile> mDecoded;
+    QStringList mClipFiles;
+    qint64 mPosition = 0;
+    qint64 mEndPosition = -1;
+};
+
+#endif // SOUNDMIXER_H
@@ -0,0 +1,271 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "soundwaveform.h"
+
+#include <cstring>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QtMath>
+
+namespace
+{
+    const char MAGIC[] = "P2DW";
+    const int MAGIC_SIZE = 4;
+    const quint16 VERSION = 2;
+
+    inline qint8 quantize(float sample)
+    {
+        return static_cast<qint8>(qBound(-127, qRound(sample * 127.f), 127));
+    }
+
+    /** Modification time in seconds, rounded down to the two seconds a project archive keeps of it */
+    inline qint64 modificationTime(const QFileInfo& info)
+    {
+        const qint64 secs = info.lastModified().toMSecsSinceEpoch() / 1000;
+        return secs - (secs % 2);
+    }
+}
+
+void SoundWaveform::build(const QVector<float>& samples)
+{
+    mSampleCount = samples.size();
+    mLevels.clear();
+    if (samples.isEmpty()) { return; }
+
+    QVector<Peak> level((samples.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    for (int i = 0; i < level.size(); i++)
+    {
+        const int first = i * BLOCK_SIZE;
+        const int last = qMin(first + BLOCK_SIZE, samples.size());
+        float lo = samples[first];
+        float hi = lo;
+        for (int s = first + 1; s < last; s++)
+        {
+            lo = qMin(lo, samples[s]);
+            hi = qMax(hi, samples[s]);
+        }
+        level[i].min = quantize(lo);
+        level[i].max = quantize(hi);
+    }
+    mLevels.append(level);
+
+    while (mLevels.last().size() > 1)
+    {
+        const QVector<Peak>& finer = mLevels.last();
+        QVector<Peak> coarser((finer.size() + LEVEL_FACTOR - 1) / LEVEL_FACTOR);
+        for (int i = 0; i < coarser.size(); i++)
+        {
+            const int first = i * LEVEL_FACTOR;
+            const int last = qMin(first + LEVEL_FACTOR, finer.size());
+            Peak p = finer[first];
+            for (int j = first + 1; j < last; j++)
+            {
+                p.min = qMin(p.min, finer[j].min);
+                p.max = qMax(p.max, finer[j].max);
+            }
+            coarser[i] = p;
+        }
+        mLevels.append(coarser);
+    }
+}
+
+quint64 SoundWaveform::memoryUsage() const
+{
+    quint64 bytes = 0;
+    for (const QVector<Peak>& level : mLevels)
+    {
+        bytes += level.size() * sizeof(Peak);
+    }
+    return bytes;
+}
+
+qint64 SoundWaveform::blockSize(int level)
+{
+    qint64 size = BLOCK_SIZE;
+    for (int i = 0; i < level; i++)
+    {
+        size *= LEVEL_FACTOR;
+    }
+    return size;
+}
+
+SoundWaveform::Peak SoundWaveform::peak(qint64 firstSample, qint64 lastSample) const
+{
+    firstSample = qMax<qint64>(firstSample, 0);
+    lastSample = qMin(lastSample, mSampleCount);
+    if (mLevels.isEmpty() || firstSample >= lastSample) { return Peak(); }
+
+    Peak result;
+    bool found = false;
+    auto merge = [&](int level, qint64 index)
+    {
+        const Peak& p = mLevels[level][static_cast<int>(index)];
+        result.min = found ? qMin(result.min, p.min) : p.min;
+        result.max = found ? qMax(result.max, p.max) : p.max;
+        found = true;
+    };
+
+    // Take the unaligned peaks at both ends of the range from the finer level
+    // and the rest from the coarser one, so only a few peaks are read however long the range is
+    int level = 0;
+    qint64 first = firstSample / BLOCK_SIZE;
+    qint64 last = qMin<qint64>((lastSample + BLOCK_SIZE - 1) / BLOCK_SIZE, mLevels[0].size());
+    while (first < last)
+    {
+        if (level + 1 < mLevels.size() && last - first >= LEVEL_FACTOR)
+        {
+            while (first % LEVEL_FACTOR != 0) { merge(level, first++); }
+            while (last % LEVEL_FACTOR != 0) { merge(level, --last); }
+            first /= LEVEL_FACTOR;
+            last /= LEVEL_FACTOR;
+            level++;
+        }
+        else
+        {
+            while (first < last) { merge(level, first++); }
+        }
+    }
+    return result;
+}
+
+Status SoundWaveform::save(const QString& filePath, const QFileInfo& soundFile) const
+{
+    DebugDetails dd;
+    dd << "SoundWaveform::save";
+    dd << QString("filePath = ").append(filePath);
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+    {
+        dd << ("file.error() = " + file.errorString());
+        return Status(Status::FAIL, dd);
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(MAGIC, MAGIC_SIZE);
+    out << VERSION << soundFile.size() << modificationTime(soundFile) << mSampleCount << static_cast<quint32>(mLevels.size());
+    for (const QVector<Peak>& level : mLevels)
+    {
+        out << static_cast<quint32>(level.size());
+        out.writeRawData(reinterpret_cast<const char*>(level.constData()), level.size() * static_cast<int>(sizeof(Peak)));
+    }
+
+    if (out.status() != QDataStream::Ok)
+    {
+        // Don't leave a truncated file behind to be rejected on every load
+        file.remove();
+        dd << "Error: Failed to write the peaks";
+        return Status(Status::FAIL, dd);
+    }
+    return Status::OK;
+}
+
+Status SoundWaveform::load(const QString& filePath, const QFileInfo& soundFile)
+{
+    DebugDetails dd;
+    dd << "SoundWaveform::load";
+    dd << QString("filePath = ").append(filePath);
+
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly))
+    {
+        dd << ("file.error() = " + file.errorString());
+        return Status(Status::FAIL, dd);
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[MAGIC_SIZE];
+    quint16 version = 0;
+    qint64 storedSourceSize = 0;
+    qint64 storedSourceTime = 0;
+    qint64 sampleCount = 0;
+    quint32 levelCount = 0;
+    if (in.readRawData(magic, MAGIC_SIZE) != MAGIC_SIZE || memcmp(magic, MAGIC, MAGIC_SIZE) != 0)
+    {
+        dd << "Error: Not a peak file";
+        return Status(Status::FAIL, dd);
+    }
+    in >> version;
+    if (version != VERSION)
+    {
+        dd << "Error: The peaks are out of date";
+        return Status(Status::FAIL, dd);
+    }
+    in >> storedSourceSize >> storedSourceTime >> sampleCount >> levelCount;
+    if (storedSourceSize != soundFile.size() || storedSourceTime != modificationTime(soundFile))
+    {
+        dd << "Error: The peaks are out of date";
+        return Status(Status::FAIL, dd);
+    }
+
+    QVector<QVector<Peak>> levels;
+    for (quint32 i = 0; i < levelCount && in.status() == QDataStream::Ok; i++)
+    {
+        quint32 size = 0;
+        in >> size;
+        if (size > static_cast<quint32>(file.size()))
+        {
+            break; // corrupt, don't allocate for it
+        }
+        QVector<Peak> level(static_cast<int>(size));
+        const int bytes = level.size() * static_cast<int>(sizeof(Peak));
+        if (in.readRawData(reinterpret_cast<char*>(level.data()), bytes) != bytes)
+        {
+            break;
+        }
+        levels.append(level);
+    }
+
+    if (in.status() != QDataStream::Ok || levels.size() != static_cast<int>(levelCount))
+    {
+        dd << "Error: The peak file is truncated";
+        return Status(Status::FAIL, dd);
+    }
+
+    mSampleCount = sampleCount;
+    mLevels = levels;
+    return Status::OK;
+}
+
+QString SoundWaveform::peakFileName(const QString& soundFile)
+{
+    return soundFile + ".peaks";
+}
+
+QString SoundWaveform::peakFileName(const QString& soundFile, const QString& dataFolder)
+{
+    const QFileInfo info(soundFile);
+    const QString dataPath = QDir(dataFolder).canonicalPath();
+    if (!dataFolder.isEmpty() && !dataPath.isEmpty() && info.absoluteDir().canonicalPath() == dataPath)
+    {
+        return peakFileName(soundFile);
+    }
+
+    const QByteArray key = QCryptographicHash::hash(info.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+    const QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    return cacheDir.filePath(QString("peaks/%1.peaks").arg(QString::fromLatin1(key.toHex())));
+}
@@ -0,0 +1,74 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef SOUNDWAVEFORM_H
+#define SOUNDWAVEFORM_H
+
+#include <QVector>
+#include "pencilerror.h"
+
+class QFileInfo;
+
+/**
+ * Min/max peak pyramid of a decoded sound clip, for drawing its waveform at any zoom.
+ *
+ * The finest level holds one peak per BLOCK_SIZE samples and every following level
+ * merges LEVEL_FACTOR peaks of the previous one, so the peak of any sample range
+ * is found by reading a handful of peaks from the matching level.
+ */
+class SoundWaveform
+{
+public:
+    static const int BLOCK_SIZE = 64;
+    static const int LEVEL_FACTOR = 4;
+
+    struct Peak
+    {
+        qint8 min = 0;
+        qint8 max = 0;
+    };
+
+    void build(const QVector<float>& samples);
+
+    bool isEmpty() const { return mLevels.isEmpty(); }
+    qint64 sampleCount() const { return mSampleCount; }
+    int levelCount() const { return mLevels.size(); }
+    quint64 memoryUsage() const;
+    /** Number of samples each peak of @p level covers */
+    static qint64 blockSize(int level);
+
+    /** Lowest and highest sample from @p firstSample up to, but not including, @p lastSample. */
+    Peak peak(qint64 firstSample, qint64 lastSample) const;
+
+    /** Writes the pyramid, tagged with the size and modification time of the sound file it was built from. */
+    Status save(const QString& filePath, const QFileInfo& soundFile) const;
+    /** Reads a pyramid written by save(), failing if the sound file has changed since. */
+    Status load(const QString& filePath, const QFileInfo& soundFile);
+
+    /** Where the peaks of @p soundFile are kept, next to the sound file itself. */
+    static QString peakFileName(const QString& soundFile);
+    /**
+     * Where the peaks of @p soundFile are written: next to it when it's in the project's @p dataFolder,
+     * otherwise in the cache folder, so sound files that don't belong to the project are left alone.
+     */
+    static QString peakFileName(const QString& soundFile, const QString& dataFolder);
+
+private:
+    qint64 mSampleCount = 0;
+    QVector<QVector<Peak>> mLevels;
+};
+
+#endif // SOUNDWAVEFORM_H
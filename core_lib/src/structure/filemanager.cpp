@@ -20,12 +20,18 @@ GNU General Public License for more details.
 #include <ctime>
 #include <QDebug>
 #include <QDir>
+#include <QThreadPool>
 #include <QVersionNumber>
+#include <QXmlStreamReader>
 #include "qminiz.h"
 #include "fileformat.h"
 #include "object.h"
+#include "bitmapcodec.h"
+#include "layerbitmap.h"
 #include "layercamera.h"
+#include "layervector.h"
 #include "util.h"
+#include "tracer.h"
 
 FileManager::FileManager(QObject* parent) : QObject(parent)
 {
@@ -34,6 +40,7 @@ FileManager::FileManager(QObject* parent) : QObject(parent)
 
 Object* FileManager::load(const QString& sFileName)
 {
+    TRACE_SCOPE("io", "FileManager::load");
     DebugDetails dd;
     dd << "\n[Project LOAD diagnostics]\n";
     dd << QString("File name: ").append(sFileName);
@@ -122,86 +129,110 @@ Object* FileManager::load(const QString& sFileName)
 
     dd << "Main XML exists: Yes";
 
-    QDomDocument xmlDoc;
-    if (!xmlDoc.setContent(&file))
+    Status st = readMainXml(obj.get(), &file);
+    if (!st.ok())
+    {
+        obj.reset();
+        dd.collect(st.details());
+        handleOpenProjectError(st.code(), dd);
+        return nullptr;
+    }
+
+    verifyObject(obj.get());
+
+    return obj.release();
+}
+
+/** Reads main.xml with a pull parser and builds the object while parsing,
+ *  so the whole document is never held in memory as a DOM tree. */
+Status FileManager::readMainXml(Object* object, QIODevice* device)
+{
+    TRACE_SCOPE("io", "FileManager::readMainXml");
+    DebugDetails dd;
+    QXmlStreamReader xmlStream(device);
+
+    QString docType;
+    while (!xmlStream.atEnd())
+    {
+        QXmlStreamReader::TokenType token = xmlStream.readNext();
+        if (token == QXmlStreamReader::DTD)
+        {
+            docType = xmlStream.dtdName().toString();
+        }
+        else if (token == QXmlStreamReader::StartElement)
+        {
+            break;
+        }
+    }
+
+    if (xmlStream.hasError())
     {
         FILEMANAGER_LOG("Couldn't open the main XML file");
         dd << "Error: Unable to parse or open the main XML file";
-        handleOpenProjectError(Status::ERROR_INVALID_XML_FILE, dd);
-        return nullptr;
+        dd << xmlStream.errorString();
+        return Status(Status::ERROR_INVALID_XML_FILE, dd);
     }
 
-    QDomDocumentType type = xmlDoc.doctype();
-    if (!(type.name() == "PencilDocument" || type.name() == "MyObject"))
+    if (!(docType == "PencilDocument" || docType == "MyObject"))
     {
         FILEMANAGER_LOG("Invalid main XML doctype");
-        dd << QString("Error: Invalid main XML doctype: ").append(type.name());
-        handleOpenProjectError(Status::ERROR_INVALID_PENCIL_FILE, dd);
-        return nullptr;
+        dd << QString("Error: Invalid main XML doctype: ").append(docType);
+        return Status(Status::ERROR_INVALID_PENCIL_FILE, dd);
     }
 
-    QDomElement root = xmlDoc.documentElement();
-    if (root.isNull())
+    if (!xmlStream.isStartElement())
     {
         dd << "Error: Main XML root node is null";
-        handleOpenProjectError(Status::ERROR_INVALID_PENCIL_FILE, dd);
-        return nullptr;
+        return Status(Status::ERROR_INVALID_PENCIL_FILE, dd);
     }
 
-    loadPalette(obj.get());
+    loadPalette(object);
 
     bool ok = true;
 
-    if (root.tagName() == "document")
+    if (xmlStream.name() == QLatin1String("document"))
     {
-        ok = loadObject(obj.get(), root);
+        ok = loadObject(object, xmlStream);
     }
-    else if (root.tagName() == "object" || root.tagName() == "MyOject") // old Pencil format (<=0.4.3)
+    else if (xmlStream.name() == QLatin1String("object") || xmlStream.name() == QLatin1String("MyOject")) // old Pencil format (<=0.4.3)
     {
-        ok = loadObjectOldWay(obj.get(), root);
+        ok = loadObjectOldWay(object, xmlStream);
+    }
+
+    if (xmlStream.hasError())
+    {
+        dd << "Error: Unable to parse the main XML file";
+        dd << QString("Line %1: %2").arg(xmlStream.lineNumber()).arg(xmlStream.errorString());
+        return Status(Status::ERROR_INVALID_XML_FILE, dd);
     }
 
     if (!ok)
     {
-        obj.reset();
         dd << "Error: Issue occurred during object loading";
-        handleOpenProjectError(Status::ERROR_INVALID_PENCIL_FILE, dd);
-        return nullptr;
+        return Status(Status::ERROR_INVALID_PENCIL_FILE, dd);
     }
-
-    verifyObject(obj.get());
-
-    return obj.release();
+    return Status::OK;
 }
 
-bool FileManager::loadObject(Object* object, const QDomElement& root)
+bool FileManager::loadObject(Object* object, QXmlStreamReader& xmlStream)
 {
-    QDomElement e = root.firstChildElement("object");
-    if (e.isNull())
-        return false;
-
+    bool hasObject = false;
     bool ok = true;
-    for (QDomNode node = root.firstChild(); !node.isNull(); node = node.nextSibling())
+    while (xmlStream.readNextStartElement())
     {
-        QDomElement element = node.toElement(); // try to convert the node to an element.
-        if (element.isNull())
-        {
-            continue;
-        }
-
-        if (element.tagName() == "object")
+        if (xmlStream.name() == QLatin1String("object"))
         {
-            ok = object->loadXML(element, [this]{ progressForward(); });
+            hasObject = true;
+            ok = object->loadXmlStream(xmlStream, [this]{ progressForward(); });
             if (!ok) FILEMANAGER_LOG("Failed to Load object");
-
         }
-        else if (element.tagName() == "editor" || element.tagName() == "projectdata")
+        else if (xmlStream.name() == QLatin1String("editor") || xmlStream.name() == QLatin1String("projectdata"))
         {
-            object->setData(loadProjectData(element));
+            object->setData(loadProjectData(xmlStream));
         }
-        else if (element.tagName() == "version")
+        else if (xmlStream.name() == QLatin1String("version"))
         {
-            QVersionNumber fileVersion = QVersionNumber::fromString(element.text());
+            QVersionNumber fileVersion = QVersionNumber::fromString(xmlStream.readElementText());
             QVersionNumber appVersion = QVersionNumber::fromString(APP_VERSION);
 
             if (!fileVersion.isNull())
@@ -214,15 +245,16 @@ bool FileManager::loadObject(Object* object, const QDomElement& root)
         }
         else
         {
-            Q_ASSERT(false);
+            qWarning() << "Skipping unknown element" << xmlStream.name();
+            xmlStream.skipCurrentElement();
         }
     }
-    return ok;
+    return hasObject && ok;
 }
 
-bool FileManager::loadObjectOldWay(Object* object, const QDomElement& root)
+bool FileManager::loadObjectOldWay(Object* object, QXmlStreamReader& xmlStream)
 {
-    return object->loadXML(root, [this] { progressForward(); });
+    return object->loadXmlStream(xmlStream, [this] { progressForward(); });
 }
 
 bool FileManager::isArchiveFormat(const QString& fileName) const
@@ -235,6 +267,7 @@ bool FileManager::isArchiveFormat(const QString& fileName) const
 
 Status FileManager::save(const Object* object, const QString& sFileName)
 {
+    TRACE_SCOPE("io", "FileManager::save");
     DebugDetails dd;
     dd << "\n[Project SAVE diagnostics]\n";
     dd << ("file name:" + sFileName);
@@ -412,27 +445,13 @@ Status FileManager::writeToWorkingFolder(const Object* object)
     return Status(errorCode, dd);
 }
 
-ObjectData FileManager::loadProjectData(const QDomElement& docElem)
+ObjectData FileManager::loadProjectData(QXmlStreamReader& xmlStream)
 {
     ObjectData data;
-    if (docElem.isNull())
+    while (xmlStream.readNextStartElement())
     {
-        return data;
-    }
-
-    QDomNode tag = docElem.firstChild();
-
-    while (!tag.isNull())
-    {
-        QDomElement element = tag.toElement(); // try to convert the node to an element.
-        if (element.isNull())
-        {
-            continue;
-        }
-
-        extractProjectData(element, data);
-
-        tag = tag.nextSibling();
+        extractProjectData(xmlStream.name().toString(), xmlStream.attributes(), data);
+        xmlStream.skipCurrentElement();
     }
     return data;
 }
@@ -496,56 +515,60 @@ QDomElement FileManager::saveProjectData(const ObjectData* data, QDomDocument& x
     return rootTag;
 }
 
-void FileManager::extractProjectData(const QDomElement& element, ObjectData& data)
+void FileManager::extractProjectData(const QString& strName, const QXmlStreamAttributes& attrs, ObjectData& data)
 {
-    QString strName = element.tagName();
+    auto attribute = [&attrs](const QString& name, const QString& defaultValue = QString())
+    {
+        return attrs.hasAttribute(name) ? attrs.value(name).toString() : defaultValue;
+    };
+
     if (strName == "currentFrame")
     {
-        data.setCurrentFrame(element.attribute("value").toInt());
+        data.setCurrentFrame(attribute("value").toInt());
     }
     else  if (strName == "currentColor")
     {
-        int r = element.attribute("r", "255").toInt();
-        int g = element.attribute("g", "255").toInt();
-        int b = element.attribute("b", "255").toInt();
-        int a = element.attribute("a", "255").toInt();
+        int r = attribute("r", "255").toInt();
+        int g = attribute("g", "255").toInt();
+        int b = attribute("b", "255").toInt();
+        int a = attribute("a", "255").toInt();
 
         data.setCurrentColor(QColor(r, g, b, a));
     }
     else if (strName == "currentLayer")
     {
-        data.setCurrentLayer(element.attribute("value", "0").toInt());
+        data.setCurrentLayer(attribute("value", "0").toInt());
     }
     else if (strName == "currentView")
     {
-        double m11 = element.attribute("m11", "1").toDouble();
-        double m12 = element.attribute("m12", "0").toDouble();
-        double m21 = element.attribute("m21", "0").toDouble();
-        double m22 = element.attribute("m22", "1").toDouble();
-        double dx = element.attribute("dx", "0").toDouble();
-        double dy = element.attribute("dy", "0").toDouble();
+        double m11 = attribute("m11", "1").toDouble();
+        double m12 = attribute("m12", "0").toDouble();
+        double m21 = attribute("m21", "0").toDouble();
+        double m22 = attribute("m22", "1").toDouble();
+        double dx = attribute("dx", "0").toDouble();
+        double dy = attribute("dy", "0").toDouble();
 
         data.setCurrentView(QTransform(m11, m12, m21, m22, dx, dy));
     }
     else if (strName == "fps" || strName == "currentFps")
     {
-        data.setFrameRate(element.attribute("value", "12").toInt());
+        data.setFrameRate(attribute("value", "12").toInt());
     }
     else if (strName == "isLoop")
     {
-        data.setLooping(element.attribute("value", "false") == "true");
+        data.setLooping(attribute("value", "false") == "true");
     }
     else if (strName == "isRangedPlayback")
     {
-        data.setRangedPlayback((element.attribute("value", "false") == "true"));
+        data.setRangedPlayback((attribute("value", "false") == "true"));
     }
     else if (strName == "markInFrame")
     {
-        data.setMarkInFrameNumber(element.attribute("value", "0").toInt());
+        data.setMarkInFrameNumber(attribute("value", "0").toInt());
     }
     else if (strName == "markOutFrame")
     {
-        data.setMarkOutFrameNumber(element.attribute("value", "15").toInt());
+        data.setMarkOutFrameNumber(attribute("value", "15").toInt());
     }
 }
 
@@ -655,6 +678,7 @@ bool FileManager::loadPalette(Object* obj)
 
 Status FileManager::writeKeyFrameFiles(const Object* object, const QString& dataFolder, QStringList& filesFlushed)
 {
+    TRACE_SCOPE("io", "FileManager::writeKeyFrameFiles");
     DebugDetails dd;
     dd << "\n[Keyframes WRITE diagnostics]\n";
 
@@ -664,9 +688,40 @@ Status FileManager::writeKeyFrameFiles(const Object* object, const QString& data
     for (int i = 0; i < numLayers; ++i)
     {
         Layer* layer = object->getLayer(i);
+        if (layer->type() == Layer::VECTOR)
+        {
+            static_cast<LayerVector*>(layer)->setBinaryKeyFrames(object->binaryVectorKeyFrames());
+        }
+        else if (layer->type() == Layer::BITMAP)
+        {
+            static_cast<LayerBitmap*>(layer)->setFastKeyFrames(object->fastBitmapKeyFrames());
+        }
         layer->presave(dataFolder);
     }
 
+    // Encode the keyframes of every layer at once. Each file name is decided before its job starts,
+    // and the keyframes are only updated once all of them have been written.
+    QThreadPool pool;
+    std::atomic<int> writtenCount(0);
+    for (int i = 0; i < numLayers; ++i)
+    {
+        object->getLayer(i)->queueKeyFrameWrites(dataFolder, pool, writtenCount);
+    }
+
+    int reportedCount = 0;
+    auto reportProgress = [&]
+    {
+        for (; reportedCount < writtenCount; ++reportedCount)
+        {
+            progressForward();
+        }
+    };
+    while (!pool.waitForDone(50))
+    {
+        reportProgress();
+    }
+    reportProgress();
+
     bool saveLayersOK = true;
     for (int i = 0; i < numLayers; ++i)
     {
@@ -674,7 +729,7 @@ Status FileManager::writeKeyFrameFiles(const Object* object, const QString& data
 
         dd << QString("Layer[%1] = [id=%2, type=%3, name=%4]").arg(i).arg(layer->id()).arg(layer->type()).arg(layer->name());
 
-        Status st = layer->save(dataFolder, filesFlushed, [this] { progressForward(); });
+        Status st = layer->finishSave(dataFolder, filesFlushed, [this] { progressForward(); });
         if (!st.ok())
         {
             saveLayersOK = false;
@@ -698,6 +753,7 @@ Status FileManager::writeKeyFrameFiles(const Object* object, const QString& data
 
 Status FileManager::writeMainXml(const Object* object, const QString& mainXmlPath, QStringList& filesWritten)
 {
+    TRACE_SCOPE("io", "FileManager::writeMainXml");
     DebugDetails dd;
     dd << "\n[XML WRITE diagnostics]\n";
 
@@ -897,7 +953,7 @@ bool FileManager::isProjectRecoverable(const QString& projectFolder)
     Q_ASSERT(ok);
 
     QStringList nameFiler;
-    nameFiler << "*.png" << "*.vec" << "*.xml";
+    nameFiler << "*.png" << "*.pbi" << "*.vec" << "*.xml";
     QStringList entries = dir.entryList(nameFiler, QDir::Files);
 
     return (entries.size() > 0);
@@ -952,29 +1008,28 @@ Status FileManager::recoverObject(Object* object)
     {
         // the main.xml is broken, try to rebuild one
         rebuildMainXML(object);
+    }
 
-        // Load the newly built main.xml
-        QFile file(object->mainXMLFile());
-        file.open(QFile::ReadOnly);
-        xmlDoc.setContent(&file);
-        root = xmlDoc.documentElement();
-        objectTag = root.firstChildElement("object");
+    // Load the (possibly rebuilt) main.xml
+    QFile mainXml(object->mainXMLFile());
+    if (!mainXml.open(QFile::ReadOnly))
+    {
+        return Status::ERROR_FILE_CANNOT_OPEN;
     }
-    loadPalette(object);
 
-    bool ok = loadObject(object, root);
+    Status st = readMainXml(object, &mainXml);
     verifyObject(object);
 
-    return ok ? Status::OK : Status::FAIL;
+    return st.ok() ? Status::OK : Status::FAIL;
 }
 
-/** Create a new main.xml based on the png/vec filenames left in the data folder */
+/** Create a new main.xml based on the png/pbi/vec filenames left in the data folder */
 Status FileManager::rebuildMainXML(Object* object)
 {
     QDir dataDir(object->dataDir());
 
     QStringList nameFiler;
-    nameFiler << "*.png" << "*.vec";
+    nameFiler << "*.png" << "*.pbi" << "*.vec";
     const QStringList entries = dataDir.entryList(nameFiler, QDir::Files | QDir::Readable, QDir::Name);
 
     QMap<int, QStringList> keyFrameGroups;
@@ -1014,7 +1069,7 @@ Status FileManager::rebuildMainXML(Object* object)
     for (const int layerIndex : keyFrameGroups.keys())
     {
         const QStringList& frames = keyFrameGroups.value(layerIndex);
-        Status st = rebuildLayerXmlTag(xmlDoc, elemObject, layerIndex, frames);
+        Status st = rebuildLayerXmlTag(xmlDoc, elemObject, layerIndex, frames, dataDir.absolutePath());
     }
 
     QTextStream fout(&file);
@@ -1034,11 +1089,12 @@ Status FileManager::rebuildMainXML(Object* object)
 Status FileManager::rebuildLayerXmlTag(QDomDocument& doc,
                                        QDomElement& elemObject,
                                        const int layerIndex,
-                                       const QStringList& frames)
+                                       const QStringList& frames,
+                                       const QString& dataFolder)
 {
     Q_ASSERT(frames.length() > 0);
 
-    Layer::LAYER_TYPE type = frames[0].endsWith(".png") ? Layer::BITMAP : Layer::VECTOR;
+    Layer::LAYER_TYPE type = frames[0].endsWith(".vec") ? Layer::VECTOR : Layer::BITMAP;
 
     QDomElement elemLayer = doc.createElement("layer");
     elemLayer.setAttribute("id", layerIndex + 1); // starts from 1, not 0.
@@ -1056,7 +1112,14 @@ Status FileManager::rebuildLayerXmlTag(QDomDocument& doc,
         elemFrame.setAttribute("frame", framePos);
         elemFrame.setAttribute("src", s);
 
-        if (type == Layer::BITMAP)
+        QRect bounds;
+        if (type == Layer::BITMAP && BitmapCodec::readBounds(QDir(dataFolder).filePath(s), bounds))
+        {
+            // The fast keyframe format keeps the original position in its header
+            elemFrame.setAttribute("topLeftX", bounds.left());
+            elemFrame.setAttribute("topLeftY", bounds.top());
+        }
+        else if (type == Layer::BITMAP)
         {
             // Since we have no way to know the original img position
             // Put it at the top left corner of the default camera
@@ -31,6 +31,9 @@ GNU General Public License for more details.
 class Object;
 class ObjectData;
 class QDir;
+class QIODevice;
+class QXmlStreamReader;
+class QXmlStreamAttributes;
 
 
 class FileManager : public QObject
@@ -59,18 +62,19 @@ private:
     Status copyDir(const QDir src, const QDir dst);
     Status unzip(const QString& strZipFile, const QString& strUnzipTarget);
 
-    bool loadObject(Object*, const QDomElement& root);
-    bool loadObjectOldWay(Object*, const QDomElement& root);
+    Status readMainXml(Object*, QIODevice* device);
+    bool loadObject(Object*, QXmlStreamReader& xmlStream);
+    bool loadObjectOldWay(Object*, QXmlStreamReader& xmlStream);
     bool isArchiveFormat(const QString& fileName) const;
     bool loadPalette(Object*);
     Status writeKeyFrameFiles(const Object* obj, const QString& dataFolder, QStringList& filesWritten);
     Status writeMainXml(const Object* obj, const QString& mainXmlPath, QStringList& filesWritten);
     Status writePalette(const Object* obj, const QString& dataFolder, QStringList& filesWritten);
 
-    ObjectData loadProjectData(const QDomElement& element);
+    ObjectData loadProjectData(QXmlStreamReader& xmlStream);
     QDomElement saveProjectData(const ObjectData*, QDomDocument& xmlDoc);
 
-    void extractProjectData(const QDomElement& element, ObjectData& data);
+    void extractProjectData(const QString& tagName, const QXmlStreamAttributes& attrs, ObjectData& data);
     void handleOpenProjectError(Status::ErrorCode, const DebugDetails&);
 
     QString backupPreviousFile(const QString& fileName);
@@ -84,7 +88,8 @@ private: // Project recovery
     Status recoverObject(Object* object);
     Status rebuildMainXML(Object* object);
     Status rebuildLayerXmlTag(QDomDocument& doc, QDomElement& elemObject,
-                              const int layerIndex, const QStringList& frames);
+                              const int layerIndex, const QStringList& frames,
+                              const QString& dataFolder);
     QString recoverLayerName(Layer::LAYER_TYPE, int index);
     int layerIndexFromFilename(const QString& filename);
     int framePosFromFilename(const QString& filename);
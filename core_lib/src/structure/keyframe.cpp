@@ -17,6 +17,8 @@ GNU General Public License for more details.
 
 #include "keyframe.h"
 
+#include <QAtomicInteger>
+
 
 KeyFrame::KeyFrame()
 {
@@ -28,7 +30,7 @@ KeyFrame::KeyFrame(const KeyFrame& k2)
     mLength = k2.mLength;
     mIsModified = k2.mIsModified;
     mAttachedFileName = k2.mAttachedFileName;
-    // intentionally not copying event listeners
+    // intentionally not copying event listeners or the revision
 }
 
 KeyFrame::~KeyFrame()
@@ -50,10 +52,18 @@ KeyFrame& KeyFrame::operator=(const KeyFrame& k2)
 	mLength = k2.mLength;
 	mIsModified = k2.mIsModified;
 	mAttachedFileName = k2.mAttachedFileName;
+    mRevision = nextRevision();
     // intentionally not copying event listeners
     return *this;
 }
 
+quint64 KeyFrame::nextRevision()
+{
+    // Images are also copied on worker threads, e.g. by the bucket fill
+    static QAtomicInteger<quint64> revision;
+    return ++revision;
+}
+
 void KeyFrame::addEventListener(KeyFrameEventListener* listener)
 {
     auto it = std::find(mEventListeners.begin(), mEventListeners.end(), listener);
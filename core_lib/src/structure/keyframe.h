@@ -41,10 +41,13 @@ public:
     int length() const { return mLength; }
     void setLength(int len) { mLength = len; }
 
-    void modification() { mIsModified = true; }
-    void setModified(bool b) { mIsModified = b; }
+    void modification() { mIsModified = true; mRevision = nextRevision(); }
+    void setModified(bool b) { mIsModified = b; if (b) { mRevision = nextRevision(); } }
     bool isModified() const { return mIsModified; }
 
+    /** Changes on every modification. No two keyframes share a revision, so it is a safe cache key. */
+    quint64 revision() const { return mRevision; }
+
     QString fileName() const { return mAttachedFileName; }
     void    setFileName(QString strFileName) { mAttachedFileName = strFileName; }
 
@@ -56,12 +59,18 @@ public:
     virtual void unloadFile() {}
     virtual bool isLoaded() const { return true; }
 
-    virtual quint64 memoryUsage() { return 0; }
+    /** Bytes unloadFile() frees, which is what the frame pool counts against its budget */
+    virtual quint64 memoryUsage() const { return 0; }
+    /** Bytes held by the keyframe for the memory report, including those that are never unloaded */
+    virtual quint64 totalMemoryUsage() const { return memoryUsage(); }
 
 private:
+    static quint64 nextRevision();
+
     int mFrame = -1;
     int mLength = 1;
     bool mIsModified = true;
+    quint64 mRevision = nextRevision();
     QString mAttachedFileName;
 
     std::vector<KeyFrameEventListener*> mEventListeners;
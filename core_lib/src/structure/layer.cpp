@@ -16,17 +16,28 @@ GNU General Public License for more details.
 */
 #include "layer.h"
 
+#include <algorithm>
+#include <iterator>
 #include <QApplication>
 #include <QDebug>
 #include <QSettings>
+#include <QThreadPool>
 #include <QPainter>
 #include <QDomElement>
+#include <QXmlStreamReader>
 #include "keyframe.h"
 
-// Used to sort the selected frames list
-bool sortAsc(int left, int right)
+namespace
 {
-    return left < right;
+    bool entryBefore(const std::pair<int, KeyFrame*>& entry, int position)
+    {
+        return entry.first < position;
+    }
+
+    bool positionBefore(int position, const std::pair<int, KeyFrame*>& entry)
+    {
+        return position < entry.first;
+    }
 }
 
 Layer::Layer(int id, LAYER_TYPE eType)
@@ -41,31 +52,88 @@ Layer::Layer(int id, LAYER_TYPE eType)
 
 Layer::~Layer()
 {
-    for (auto it : mKeyFrames)
+    for (const KeyFrameEntry& entry : mKeyFrames)
     {
-        KeyFrame* pKeyFrame = it.second;
-        delete pKeyFrame;
+        delete entry.second;
     }
     mKeyFrames.clear();
 }
 
+Layer::KeyFrameIterator Layer::lowerBound(int position) const
+{
+    return std::lower_bound(mKeyFrames.cbegin(), mKeyFrames.cend(), position, entryBefore);
+}
+
+Layer::KeyFrameIterator Layer::upperBound(int position) const
+{
+    return std::upper_bound(mKeyFrames.cbegin(), mKeyFrames.cend(), position, positionBefore);
+}
+
+Layer::KeyFrameIterator Layer::findKeyFrame(int position) const
+{
+    auto it = lowerBound(position);
+    if (it != mKeyFrames.cend() && it->first == position)
+    {
+        return it;
+    }
+    return mKeyFrames.cend();
+}
+
+void Layer::insertKeyFrame(KeyFrame* pKeyFrame)
+{
+    Q_ASSERT(findKeyFrame(pKeyFrame->pos()) == mKeyFrames.cend());
+    mKeyFrames.emplace(lowerBound(pKeyFrame->pos()), pKeyFrame->pos(), pKeyFrame);
+    keyFramesChanged();
+}
+
 void Layer::foreachKeyFrame(std::function<void(KeyFrame*)> action) const
 {
-    for (auto pair : mKeyFrames)
+    // From last to first, as the keys have always been visited
+    for (auto it = mKeyFrames.crbegin(); it != mKeyFrames.crend(); ++it)
+    {
+        action(it->second);
+    }
+}
+
+void Layer::foreachKeyFrameInRange(int first, int last, std::function<void(KeyFrame*)> action) const
+{
+    // Keys end in the order they start, so the search stops at the first one ending before the range.
+    // Sound clips are the exception: an earlier long clip can still reach the range after a shorter one
+    // has ended, so on sound layers, which only hold a few clips, the longest clip bounds the search instead.
+    int maxLength = 0;
+    if (type() == SOUND)
+    {
+        for (const KeyFrameEntry& entry : mKeyFrames)
+        {
+            maxLength = std::max(maxLength, entry.second->length());
+        }
+    }
+
+    for (auto it = upperBound(last); it != mKeyFrames.cbegin();)
     {
-        action(pair.second);
+        --it;
+        KeyFrame* key = it->second;
+        if (key->pos() + std::max(maxLength, key->length()) - 1 < first)
+        {
+            // Nothing before this key can reach the range
+            break;
+        }
+        if (key->pos() + key->length() - 1 >= first)
+        {
+            action(key);
+        }
     }
 }
 
 bool Layer::keyExists(int position) const
 {
-    return (mKeyFrames.find(position) != mKeyFrames.end());
+    return findKeyFrame(position) != mKeyFrames.cend();
 }
 
 KeyFrame* Layer::getKeyFrameAt(int position) const
 {
-    auto it = mKeyFrames.find(position);
-    if (it == mKeyFrames.end())
+    auto it = findKeyFrame(position);
+    if (it == mKeyFrames.cend())
     {
         return nullptr;
     }
@@ -78,43 +146,36 @@ KeyFrame* Layer::getLastKeyFrameAtPosition(int position) const
     {
         position = 1;
     }
-    auto it = mKeyFrames.lower_bound(position);
-    if (it == mKeyFrames.end())
+    auto it = upperBound(position);
+    if (it == mKeyFrames.cbegin())
     {
         return nullptr;
     }
-    return it->second;
+    return (--it)->second;
 }
 
 int Layer::getPreviousKeyFramePosition(int position) const
 {
-    auto it = mKeyFrames.upper_bound(position);
-    if (it == mKeyFrames.end())
+    auto it = lowerBound(position);
+    if (it == mKeyFrames.cbegin())
     {
         return firstKeyFramePosition();
     }
-    return it->first;
+    return (--it)->first;
 }
 
 int Layer::getNextKeyFramePosition(int position) const
 {
-    // workaround: bug with lower_bound?
-    // when position is before the first frame it == mKeyFrames.end() for some reason
     if (position < firstKeyFramePosition())
     {
        return firstKeyFramePosition();
     }
 
-    auto it = mKeyFrames.lower_bound(position);
-    if (it == mKeyFrames.end())
+    auto it = upperBound(position);
+    if (it == mKeyFrames.cend())
     {
         return getMaxKeyFramePosition();
     }
-
-    if (it != mKeyFrames.begin())
-    {
-        --it;
-    }
     return it->first;
 }
 
@@ -153,7 +214,7 @@ int Layer::firstKeyFramePosition() const
 {
     if (!mKeyFrames.empty())
     {
-        return mKeyFrames.rbegin()->first; // rbegin is the lowest key frame position
+        return mKeyFrames.front().first;
     }
     return 0;
 }
@@ -162,7 +223,7 @@ int Layer::getMaxKeyFramePosition() const
 {
     if (!mKeyFrames.empty())
     {
-        return mKeyFrames.begin()->first; // begin is the highest key frame position
+        return mKeyFrames.back().first;
     }
     return 0;
 }
@@ -196,7 +257,7 @@ bool Layer::addKeyFrame(int position, KeyFrame* pKeyFrame)
     }
 
     pKeyFrame->setPos(position);
-    mKeyFrames.emplace(position, pKeyFrame);
+    insertKeyFrame(pKeyFrame);
     markFrameAsDirty(position);
     return true;
 }
@@ -223,17 +284,31 @@ bool Layer::removeKeyFrame(int position)
     if (frame)
     {
         removeFromSelectionList(frame->pos());
-        mKeyFrames.erase(frame->pos());
+        mKeyFrames.erase(findKeyFrame(frame->pos()));
         markFrameAsDirty(frame->pos());
         delete frame;
+        keyFramesChanged();
     }
     return true;
 }
 
 void Layer::removeFromSelectionList(int position)
 {
-    mSelectedFrames_byLast.removeAll(position);
-    mSelectedFrames_byPosition.removeAll(position);
+    if (mSelectedFrames.remove(position))
+    {
+        mSelectedFrames_byLast.removeAll(position);
+        mSelectedFrames_byPosition.removeAll(position);
+    }
+}
+
+void Layer::rebuildSelectionSet()
+{
+    mSelectedFrames.clear();
+    mSelectedFrames.reserve(mSelectedFrames_byPosition.size());
+    for (int pos : mSelectedFrames_byPosition)
+    {
+        mSelectedFrames.insert(pos);
+    }
 }
 
 bool Layer::moveKeyFrame(int position, int offset)
@@ -247,29 +322,24 @@ bool Layer::moveKeyFrame(int position, int offset)
 
     if (swapKeyFrames(position, newPos)) {
 
-        auto oldPosIndex = mSelectedFrames_byPosition.indexOf(position);
-        auto newPosIndex = mSelectedFrames_byPosition.indexOf(newPos);
-
-        auto oldLastIndex = mSelectedFrames_byLast.indexOf(position);
-        auto newLastndex = mSelectedFrames_byLast.indexOf(newPos);
+        const bool newPosSelected = mSelectedFrames.contains(newPos);
 
+        // The selection follows the keys, so a selected key swapped with an unselected one
+        // moves its position in the selection
+        if (frameSelected != newPosSelected) {
+            const int from = frameSelected ? position : newPos;
+            const int to = frameSelected ? newPos : position;
 
-        // Old position is selected
-        if (oldPosIndex != -1) {
-            mSelectedFrames_byPosition[oldPosIndex] = newPos;
-            mSelectedFrames_byLast[oldLastIndex] = newPos;
-        }
-
-        // Old position is selected
-        if (newPosIndex != -1) {
-            mSelectedFrames_byPosition[newPosIndex] = position;
-            mSelectedFrames_byLast[newLastndex] = position;
+            mSelectedFrames_byLast[mSelectedFrames_byLast.indexOf(from)] = to;
+            mSelectedFrames_byPosition.removeOne(from);
+            mSelectedFrames_byPosition.insert(std::lower_bound(mSelectedFrames_byPosition.begin(), mSelectedFrames_byPosition.end(), to), to);
+            mSelectedFrames.remove(from);
+            mSelectedFrames.insert(to);
         }
         return true;
     }
 
-    mSelectedFrames_byLast.clear();
-    mSelectedFrames_byPosition.clear();
+    deselectAll();
 
     setFrameSelected(position, true);
 
@@ -277,6 +347,7 @@ bool Layer::moveKeyFrame(int position, int offset)
     if (!moveSelectedFrames(offset)) {
         mSelectedFrames_byLast = listOfFramesLast;
         mSelectedFrames_byPosition = listOfFramesPos;
+        rebuildSelectionSet();
         return false;
     }
 
@@ -286,6 +357,7 @@ bool Layer::moveKeyFrame(int position, int offset)
 
     mSelectedFrames_byLast = listOfFramesLast;
     mSelectedFrames_byPosition = listOfFramesPos;
+    rebuildSelectionSet();
 
     // If the frame was selected prior to moving, make sure it's still selected.
     setFrameSelected(newPos, frameSelected);
@@ -296,20 +368,22 @@ bool Layer::moveKeyFrame(int position, int offset)
 // Current behaviour, need to refresh the swapped cels
 bool Layer::swapKeyFrames(int position1, int position2)
 {
-    KeyFrame* pFirstFrame = nullptr;
-    KeyFrame* pSecondFrame = nullptr;
+    auto it1 = findKeyFrame(position1);
+    auto it2 = findKeyFrame(position2);
 
-    if (mKeyFrames.count(position1) != 1 || mKeyFrames.count(position2) != 1)
+    if (it1 == mKeyFrames.cend() || it2 == mKeyFrames.cend())
     {
         return false;
     }
 
     // Both keys exist
-    pFirstFrame = mKeyFrames[position1];
-    pSecondFrame = mKeyFrames[position2];
+    auto first = mKeyFrames.begin() + (it1 - mKeyFrames.cbegin());
+    auto second = mKeyFrames.begin() + (it2 - mKeyFrames.cbegin());
+    KeyFrame* pFirstFrame = first->second;
+    KeyFrame* pSecondFrame = second->second;
 
-    mKeyFrames[position1] = pSecondFrame;
-    mKeyFrames[position2] = pFirstFrame;
+    first->second = pSecondFrame;
+    second->second = pFirstFrame;
 
     pFirstFrame->setPos(position2);
     pSecondFrame->setPos(position1);
@@ -319,38 +393,104 @@ bool Layer::swapKeyFrames(int position1, int position2)
 
     markFrameAsDirty(position1);
     markFrameAsDirty(position2);
+    keyFramesChanged();
 
     return true;
 }
 
 bool Layer::loadKey(KeyFrame* pKey)
 {
-    auto it = mKeyFrames.find(pKey->pos());
-    if (it != mKeyFrames.end())
+    auto it = findKeyFrame(pKey->pos());
+    if (it != mKeyFrames.cend())
     {
         delete it->second;
         mKeyFrames.erase(it);
     }
-    mKeyFrames.emplace(pKey->pos(), pKey);
+    insertKeyFrame(pKey);
     return true;
 }
 
 Status Layer::save(const QString& sDataFolder, QStringList& attachedFiles, ProgressCallback progressStep)
+{
+    QThreadPool pool;
+    std::atomic<int> writtenCount(0);
+    const int queued = queueKeyFrameWrites(sDataFolder, pool, writtenCount);
+    pool.waitForDone();
+
+    for (int i = 0; i < queued; ++i)
+    {
+        progressStep();
+    }
+    return finishSave(sDataFolder, attachedFiles, progressStep);
+}
+
+int Layer::queueKeyFrameWrites(const QString& sDataFolder, QThreadPool& pool, std::atomic<int>& writtenCount)
+{
+    Q_ASSERT(mPendingWrites.empty());
+
+    for (auto it = mKeyFrames.crbegin(); it != mKeyFrames.crend(); ++it)
+    {
+        KeyFrame* keyFrame = it->second;
+        const QString filePath = keyFrameFileToWrite(keyFrame, sDataFolder);
+        if (!filePath.isEmpty())
+        {
+            PendingWrite write;
+            write.key = keyFrame;
+            write.filePath = filePath;
+            // The jobs write a copy, since the caller may process events and change the keyframe meanwhile
+            write.copy.reset(keyFrame->clone());
+            write.revision = keyFrame->revision();
+            Q_ASSERT(write.copy);
+            mPendingWrites.push_back(std::move(write));
+        }
+    }
+
+    // The file names are all decided at this point, so the order the files get written in doesn't matter.
+    // The list doesn't change anymore either, so the jobs can hold on to its entries.
+    for (PendingWrite& write : mPendingWrites)
+    {
+        PendingWrite* w = &write;
+        pool.start([this, w, &writtenCount]
+        {
+            w->status = writeKeyFrameFile(w->copy.get(), w->filePath);
+            writtenCount++;
+        });
+    }
+    return static_cast<int>(mPendingWrites.size());
+}
+
+Status Layer::finishSave(const QString& sDataFolder, QStringList& attachedFiles, ProgressCallback progressStep)
 {
     DebugDetails dd;
     dd << "\n[Layer SAVE diagnostics]\n";
 
     bool ok = true;
 
-    for (auto pair : mKeyFrames)
+    auto pending = mPendingWrites.cbegin();
+    for (auto it = mKeyFrames.crbegin(); it != mKeyFrames.crend(); ++it)
     {
-        KeyFrame* keyFrame = pair.second;
-        Status st = saveKeyFrameFile(keyFrame, sDataFolder);
+        KeyFrame* keyFrame = it->second;
+        Status st = Status::OK;
+        if (pending != mPendingWrites.cend() && pending->key == keyFrame)
+        {
+            st = keyFrameFileWritten(keyFrame, pending->filePath, pending->status);
+            if (keyFrame->revision() != pending->revision)
+            {
+                // Changed after the copy was taken, so the file is already out of date
+                keyFrame->setModified(true);
+            }
+            ++pending;
+        }
+        else
+        {
+            st = saveKeyFrameFile(keyFrame, sDataFolder);
+            progressStep();
+        }
+
         if (st.ok())
         {
             //qDebug() << "Layer [" << name() << "] FN=" << keyFrame->fileName();
-            if (!keyFrame->fileName().isEmpty())
-                attachedFiles.append(keyFrame->fileName());
+            attachedFiles.append(keyFrameFiles(keyFrame));
         }
         else
         {
@@ -358,8 +498,9 @@ Status Layer::save(const QString& sDataFolder, QStringList& attachedFiles, Progr
             dd.collect(st.details());
             dd << QString("- Keyframe[%1] failed to save").arg(keyFrame->pos());
         }
-        progressStep();
     }
+    mPendingWrites.clear();
+
     if (!ok)
     {
         dd << "\nError: Failed to save one or more files";
@@ -368,6 +509,30 @@ Status Layer::save(const QString& sDataFolder, QStringList& attachedFiles, Progr
     return Status::OK;
 }
 
+QStringList Layer::keyFrameFiles(const KeyFrame* key) const
+{
+    if (key->fileName().isEmpty())
+    {
+        return QStringList();
+    }
+    return QStringList(key->fileName());
+}
+
+QString Layer::keyFrameFileToWrite(KeyFrame*, const QString&)
+{
+    return QString();
+}
+
+Status Layer::writeKeyFrameFile(const KeyFrame*, const QString&) const
+{
+    return Status::SAFE;
+}
+
+Status Layer::keyFrameFileWritten(KeyFrame*, const QString&, const Status& st)
+{
+    return st;
+}
+
 void Layer::setModified(int position, bool modified) const
 {
     KeyFrame* key = getKeyFrameAt(position);
@@ -382,7 +547,7 @@ bool Layer::isFrameSelected(int position) const
     KeyFrame* keyFrame = getKeyFrameWhichCovers(position);
     if (keyFrame == nullptr) { return false; }
 
-    return mSelectedFrames_byLast.contains(keyFrame->pos());
+    return mSelectedFrames.contains(keyFrame->pos());
 }
 
 void Layer::setFrameSelected(int position, bool isSelected)
@@ -392,20 +557,20 @@ void Layer::setFrameSelected(int position, bool isSelected)
     {
         int startPosition = keyFrame->pos();
 
-        if (isSelected && !mSelectedFrames_byLast.contains(startPosition))
+        if (isSelected && !mSelectedFrames.contains(startPosition))
         {
             // Add the selected frame to the lists
+            mSelectedFrames.insert(startPosition);
             mSelectedFrames_byLast.insert(0, startPosition);
-            mSelectedFrames_byPosition.append(startPosition);
 
             // We need to keep the list of selected frames sorted
             // in order to easily handle their movement
-            std::sort(mSelectedFrames_byPosition.begin(), mSelectedFrames_byPosition.end(), sortAsc);
+            auto it = std::lower_bound(mSelectedFrames_byPosition.begin(), mSelectedFrames_byPosition.end(), startPosition);
+            mSelectedFrames_byPosition.insert(it, startPosition);
         }
         else if (!isSelected)
         {
-            mSelectedFrames_byLast.removeOne(startPosition);
-            mSelectedFrames_byPosition.removeOne(startPosition);
+            removeFromSelectionList(startPosition);
         }
     }
 }
@@ -441,11 +606,15 @@ void Layer::extendSelectionTo(int position)
             endPos = lastSelected;
         }
 
-        int i = startPos;
-        while (i <= endPos)
+        // Select from first to last, visiting the keys rather than every frame in between
+        auto it = upperBound(startPos);
+        if (it != mKeyFrames.cbegin() && getKeyFrameWhichCovers(startPos) != nullptr)
         {
-            setFrameSelected(i, true);
-            i++;
+            --it;
+        }
+        for (; it != mKeyFrames.cend() && it->first <= endPos; ++it)
+        {
+            setFrameSelected(it->first, true);
         }
     }
 }
@@ -461,8 +630,11 @@ bool Layer::newSelectionOfConnectedFrames(int position)
     setFrameSelected(position, true);
 
     // Find keyframes that are connected and make sure we're below max.
-    while (position < getMaxKeyFramePosition() && getKeyFrameWhichCovers(position) != nullptr) {
-        position++;
+    const int maxPosition = getMaxKeyFramePosition();
+    while (position < maxPosition) {
+        KeyFrame* key = getKeyFrameWhichCovers(position);
+        if (key == nullptr) { break; }
+        position = qMin(key->pos() + key->length(), maxPosition);
     }
 
     extendSelectionTo(position);
@@ -492,16 +664,15 @@ void Layer::deselectAll()
 {
     mSelectedFrames_byLast.clear();
     mSelectedFrames_byPosition.clear();
+    mSelectedFrames.clear();
 }
 
 bool Layer::canMoveSelectedFramesToOffset(int offset) const
 {
-    QList<int> newByPositions = mSelectedFrames_byPosition;
-
-    for (int pos : newByPositions)
+    for (int pos : mSelectedFrames_byPosition)
     {
         pos += offset;
-        if (keyExists(pos) && !newByPositions.contains(pos)) {
+        if (!mSelectedFrames.contains(pos) && keyExists(pos)) {
             return false;
         }
     }
@@ -571,7 +742,7 @@ void Layer::setExposureForSelectedFrames(int offset)
 
                int pos = selectedFramesByPos[nextIndex+selIndex];
 
-               if (!mSelectedFrames_byPosition.contains(pos)) { continue; }
+               if (!mSelectedFrames.contains(pos)) { continue; }
 
                selectedFramesByPos[nextIndex+selIndex] = pos + offsetDirection;
 
@@ -620,44 +791,43 @@ bool Layer::moveSelectedFrames(int offset)
         return false;
     }
 
-    // If we are moving to the right we start moving selected frames from the highest (right) to the lowest (left)
-    int indexInSelection = mSelectedFrames_byPosition.count() - 1;
-    int step = -1;
-
-    if (offset < 0)
+    // Check if we are not moving out of the timeline
+    if (offset < 0 && mSelectedFrames_byPosition[0] + offset < 1)
     {
-        // If we are moving to the left we start moving selected frames from the lowest (left) to the highest (right)
-        indexInSelection = 0;
-        step = 1;
-
-        // Check if we are not moving out of the timeline
-        if (mSelectedFrames_byPosition[0] + offset < 1) {
-            offset = 1 - mSelectedFrames_byPosition[0];
-        }
+        offset = 1 - mSelectedFrames_byPosition[0];
     }
 
     while (!canMoveSelectedFramesToOffset(offset)) { offset += 1; }
     if (offset == 0) { return false; }
 
-    for (; indexInSelection > -1 && indexInSelection < mSelectedFrames_byPosition.count(); indexInSelection += step)
-    {
-        int fromPos = mSelectedFrames_byPosition[indexInSelection];
-        int toPos = fromPos + offset;
-
-        // Get the frame to move
-        KeyFrame* selectedFrame = getKeyFrameAt(fromPos);
-
-        Q_ASSERT(!keyExists(toPos));
+    // Take the selected keys out, shift them and merge them back in,
+    // so moving any number of keys is a single pass over the layer
+    std::vector<KeyFrameEntry> remaining;
+    std::vector<KeyFrameEntry> moved;
+    remaining.reserve(mKeyFrames.size());
+    moved.reserve(static_cast<size_t>(mSelectedFrames_byPosition.count()));
 
-        mKeyFrames.erase(fromPos);
-        markFrameAsDirty(fromPos);
+    for (const KeyFrameEntry& entry : mKeyFrames)
+    {
+        if (!mSelectedFrames.contains(entry.first))
+        {
+            remaining.push_back(entry);
+            continue;
+        }
+        const int toPos = entry.first + offset;
+        markFrameAsDirty(entry.first);
 
         // Update the position of the selected frame
-        selectedFrame->setPos(toPos);
-        mKeyFrames.insert(std::make_pair(toPos, selectedFrame));
+        entry.second->setPos(toPos);
+        moved.emplace_back(toPos, entry.second);
         markFrameAsDirty(toPos);
     }
 
+    mKeyFrames.clear();
+    std::merge(remaining.cbegin(), remaining.cend(), moved.cbegin(), moved.cend(), std::back_inserter(mKeyFrames),
+               [](const KeyFrameEntry& a, const KeyFrameEntry& b) { return a.first < b.first; });
+    keyFramesChanged();
+
     // Update selection lists
     for (int& pos : mSelectedFrames_byPosition)
     {
@@ -667,6 +837,7 @@ bool Layer::moveSelectedFrames(int offset)
     {
         pos += offset;
     }
+    rebuildSelectionSet();
     return true;
 }
 
@@ -713,3 +884,14 @@ void Layer::loadBaseDomElement(const QDomElement& elem)
     setName(elem.attribute("name", "untitled"));
     setVisible(elem.attribute("visibility", "1").toInt());
 }
+
+void Layer::loadBaseXmlAttributes(const QXmlStreamAttributes& attrs)
+{
+    if (attrs.hasAttribute("id"))
+    {
+        int id = attrs.value("id").toInt();
+        setId(id);
+    }
+    setName(attrs.hasAttribute("name") ? attrs.value("name").toString() : QString("untitled"));
+    setVisible(attrs.hasAttribute("visibility") ? attrs.value("visibility").toInt() : 1);
+}
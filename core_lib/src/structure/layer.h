@@ -17,15 +17,21 @@ GNU General Public License for more details.
 #ifndef LAYER_H
 #define LAYER_H
 
-#include <map>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <functional>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QDomElement>
 #include "pencilerror.h"
 
 class KeyFrame;
 class Status;
+class QXmlStreamReader;
+class QXmlStreamAttributes;
+class QThreadPool;
 
 typedef std::function<void()> ProgressCallback;
 
@@ -66,9 +72,13 @@ public:
 
     virtual Status saveKeyFrameFile(KeyFrame*, QString dataPath) = 0;
     virtual void loadDomElement(const QDomElement& element, QString dataDirPath, ProgressCallback progressForward) = 0;
+    /** Streaming counterpart of loadDomElement(), used when opening projects.
+     *  The reader is positioned on the <layer> start element and is left on its end element. */
+    virtual void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressForward) = 0;
     virtual QDomElement createDomElement(QDomDocument& doc) const = 0;
     QDomElement createBaseDomElement(QDomDocument& doc) const;
     void loadBaseDomElement(const QDomElement& elem);
+    void loadBaseXmlAttributes(const QXmlStreamAttributes& attrs);
 
     // KeyFrame interface
     int getMaxKeyFramePosition() const;
@@ -114,6 +124,8 @@ public:
     KeyFrame *getKeyFrameWhichCovers(int frameNumber) const;
 
     void foreachKeyFrame(std::function<void(KeyFrame*)>) const;
+    /** Calls @p action for every keyframe that covers at least one frame from @p first to @p last, from last to first. */
+    void foreachKeyFrameInRange(int first, int last, std::function<void(KeyFrame*)> action) const;
 
     void setModified(int position, bool isModified) const;
 
@@ -160,6 +172,20 @@ public:
     Status save(const QString& sDataFolder, QStringList& attachedFiles, ProgressCallback progressStep);
     virtual Status presave(const QString& sDataFolder) { Q_UNUSED(sDataFolder); return Status::SAFE; }
 
+    /**
+     * save() in two steps, so that the keyframe files of several layers can be written at once.
+     * queueKeyFrameWrites() starts writing the files that need it on @p pool. The jobs write copies of the keyframes
+     * taken on the calling thread, so events may be processed while the pool runs. Call finishSave() once it is done.
+     * @param writtenCount Incremented from the pool each time a file is written
+     * @return The number of files queued
+     */
+    int queueKeyFrameWrites(const QString& sDataFolder, QThreadPool& pool, std::atomic<int>& writtenCount);
+    /**
+     * Updates the keyframes written by the pool and saves the others, collecting the results in keyframe order.
+     * @p progressStep is only called for the keyframes that weren't queued.
+     */
+    Status finishSave(const QString& sDataFolder, QStringList& attachedFiles, ProgressCallback progressStep);
+
     bool isPaintable() const;
 
     /** Returns a list of dirty frame positions */
@@ -174,17 +200,44 @@ public:
 
 protected:
     virtual KeyFrame* createKeyFrame(int position) = 0;
+    /** Files saved for @p key that go into the project archive */
+    virtual QStringList keyFrameFiles(const KeyFrame* key) const;
+
+    /**
+     * The file @p key has to be written to, or an empty string if it is up to date.
+     * Layers that leave the whole work to saveKeyFrameFile() don't override this.
+     */
+    virtual QString keyFrameFileToWrite(KeyFrame* key, const QString& dataFolder);
+    /** Writes the file of @p key, which is a copy when run on a worker thread. It must not change the layer. */
+    virtual Status writeKeyFrameFile(const KeyFrame* key, const QString& filePath) const;
+    /** Updates @p key once writeKeyFrameFile() returned @p st */
+    virtual Status keyFrameFileWritten(KeyFrame* key, const QString& filePath, const Status& st);
+    /** Called after keys were added, removed or moved */
+    virtual void keyFramesChanged() {}
     bool loadKey(KeyFrame*);
 
 private:
+    typedef std::pair<int, KeyFrame*> KeyFrameEntry;
+    typedef std::vector<KeyFrameEntry>::const_iterator KeyFrameIterator;
+
+    /** First entry at or after @p position */
+    KeyFrameIterator lowerBound(int position) const;
+    /** First entry after @p position */
+    KeyFrameIterator upperBound(int position) const;
+    KeyFrameIterator findKeyFrame(int position) const;
+    void insertKeyFrame(KeyFrame* pKeyFrame);
+
     void removeFromSelectionList(int position);
+    void rebuildSelectionSet();
 
     LAYER_TYPE meType = UNDEFINED;
     int        mId = 0;
     bool       mVisible = true;
     QString    mName;
 
-    std::map<int, KeyFrame*, std::greater<int>> mKeyFrames;
+    // Sorted by position. A flat vector keeps lookups cache friendly and lets
+    // retiming move many keys in a single pass.
+    std::vector<KeyFrameEntry> mKeyFrames;
 
     // We need to keep track of selected frames ordered by last selected
     // and by position.
@@ -192,9 +245,21 @@ private:
     //
     QList<int> mSelectedFrames_byLast; // Used to handle selection range (based on last selected
     QList<int> mSelectedFrames_byPosition; // Used to handle frames movements on the timeline
+    QSet<int> mSelectedFrames; // Used for membership tests, holds the same positions as the lists above
 
     // Used for clearing cache for modified frames.
     QList<int> mDirtyFrames;
+
+    struct PendingWrite
+    {
+        KeyFrame* key = nullptr;
+        std::unique_ptr<const KeyFrame> copy; //< what the pool writes, owned here so it is freed on the calling thread
+        quint64 revision = 0; //< of the keyframe when the copy was taken
+        QString filePath;
+        Status status = Status::OK;
+    };
+    // Between queueKeyFrameWrites() and finishSave(), from the last keyframe to the first
+    std::vector<PendingWrite> mPendingWrites;
 };
 
 #endif
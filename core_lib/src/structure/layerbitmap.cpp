@@ -19,7 +19,9 @@ GNU General Public License for more details.
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QXmlStreamReader>
 #include "keyframe.h"
+#include "bitmapcodec.h"
 #include "bitmapimage.h"
 #include "util/util.h"
 
@@ -74,19 +76,41 @@ void LayerBitmap::loadImageAtFrame(QString path, QPoint topLeft, int frameNumber
 
 Status LayerBitmap::saveKeyFrameFile(KeyFrame* keyframe, QString path)
 {
-    QString strFilePath = filePath(keyframe, QDir(path));
+    QString strFilePath = keyFrameFileToWrite(keyframe, path);
+    if (strFilePath.isEmpty())
+    {
+        return Status::SAFE;
+    }
+    return keyFrameFileWritten(keyframe, strFilePath, writeKeyFrameFile(keyframe, strFilePath));
+}
 
-    BitmapImage* bitmapImage = static_cast<BitmapImage*>(keyframe);
+QString LayerBitmap::keyFrameFileToWrite(KeyFrame* keyframe, const QString& dataFolder)
+{
+    QString strFilePath = filePath(keyframe, QDir(dataFolder));
 
     bool needSave = needSaveFrame(keyframe, strFilePath);
     if (!needSave)
     {
-        return Status::SAFE;
+        return QString();
     }
 
-    bitmapImage->setFileName(strFilePath);
+    // Load and crop here rather than while writing, which may happen on another thread
+    BitmapImage* bitmapImage = static_cast<BitmapImage*>(keyframe);
+    bitmapImage->loadFile();
+    bitmapImage->autoCrop();
+    return strFilePath;
+}
+
+Status LayerBitmap::writeKeyFrameFile(const KeyFrame* keyframe, const QString& strFilePath) const
+{
+    const bool fastFormat = (QFileInfo(strFilePath).suffix() == BitmapCodec::SUFFIX);
+    return static_cast<const BitmapImage*>(keyframe)->writeFile(strFilePath, fastFormat ? "PBI" : "PNG");
+}
+
+Status LayerBitmap::keyFrameFileWritten(KeyFrame* keyframe, const QString& strFilePath, const Status& st)
+{
+    BitmapImage* bitmapImage = static_cast<BitmapImage*>(keyframe);
 
-    Status st = bitmapImage->writeFile(strFilePath);
     if (!st.ok())
     {
         bitmapImage->setFileName("");
@@ -100,6 +124,21 @@ Status LayerBitmap::saveKeyFrameFile(KeyFrame* keyframe, QString path)
         return Status(Status::FAIL, dd);
     }
 
+    // A modified key saved in the other format leaves its previous file behind,
+    // under the same name with the other suffix, so remove it like presave() does for moved keys
+    const QFileInfo previousFile(bitmapImage->fileName());
+    const QFileInfo writtenFile(strFilePath);
+    if (!bitmapImage->fileName().isEmpty()
+        && previousFile.suffix() != writtenFile.suffix()
+        && previousFile.completeBaseName() == writtenFile.completeBaseName()
+        && previousFile.dir() == writtenFile.dir())
+    {
+        QFile::remove(previousFile.absoluteFilePath());
+    }
+
+    // The frame is likely empty, act like there's no file name
+    // so we don't end up writing to it later.
+    bitmapImage->setFileName(bitmapImage->bounds().isEmpty() ? "" : strFilePath);
     bitmapImage->setModified(false);
     return Status::OK;
 }
@@ -133,7 +172,7 @@ Status LayerBitmap::presave(const QString& sDataFolder)
     {
         // Move to temporary locations first to avoid overwritting anything we shouldn't be
         // Ex: Frame A moves from 1 -> 2, Frame B moves from 2 -> 3. Make sure A does not overwrite B
-        QString tmpPath = dataFolder.filePath(QString::asprintf("t_%03d.%03d.png", id(), b->pos()));
+        QString tmpPath = dataFolder.filePath(QString::asprintf("t_%03d.%03d.%s", id(), b->pos(), qPrintable(fileSuffix(b))));
         if (QFileInfo(b->fileName()).dir() != dataFolder) {
             // Copy instead of move if the data folder itself has changed
             QFile::copy(b->fileName(), tmpPath);
@@ -163,7 +202,17 @@ QString LayerBitmap::filePath(KeyFrame* key, const QDir& dataFolder) const
 
 QString LayerBitmap::fileName(KeyFrame* key) const
 {
-    return QString::asprintf("%03d.%03d.png", id(), key->pos());
+    return QString::asprintf("%03d.%03d.%s", id(), key->pos(), qPrintable(fileSuffix(key)));
+}
+
+QString LayerBitmap::fileSuffix(KeyFrame* key) const
+{
+    // A key that hasn't been drawn on since it was saved stays in the format of its file
+    if (!key->isModified() && !key->fileName().isEmpty())
+    {
+        return (QFileInfo(key->fileName()).suffix() == BitmapCodec::SUFFIX) ? BitmapCodec::SUFFIX : "png";
+    }
+    return mFastKeyFrames ? BitmapCodec::SUFFIX : "png";
 }
 
 bool LayerBitmap::needSaveFrame(KeyFrame* key, const QString& savePath)
@@ -226,3 +275,28 @@ void LayerBitmap::loadDomElement(const QDomElement& element, QString dataDirPath
         imageTag = imageTag.nextSibling();
     }
 }
+
+void LayerBitmap::loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep)
+{
+    this->loadBaseXmlAttributes(xmlStream.attributes());
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("image"))
+        {
+            const QXmlStreamAttributes attrs = xmlStream.attributes();
+            QString path = validateDataPath(attrs.value("src").toString(), dataDirPath);
+            if (!path.isEmpty())
+            {
+                int position = attrs.value("frame").toInt();
+                int x = attrs.value("topLeftX").toInt();
+                int y = attrs.value("topLeftY").toInt();
+                qreal opacity = attrs.hasAttribute("opacity") ? attrs.value("opacity").toDouble() : 1.0;
+                loadImageAtFrame(path, QPoint(x, y), position, opacity);
+            }
+
+            progressStep();
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
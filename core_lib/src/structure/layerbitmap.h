@@ -32,6 +32,7 @@ public:
 
     QDomElement createDomElement(QDomDocument& doc) const override;
     void loadDomElement(const QDomElement& element, QString dataDirPath, ProgressCallback progressStep) override;
+    void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep) override;
     Status presave(const QString& sDataFolder) override;
 
     BitmapImage* getBitmapImageAtFrame(int frameNumber);
@@ -41,15 +42,27 @@ public:
     void repositionFrame(QPoint point, int frame);
     QRect getFrameBounds(int frame);
 
+    /**
+     * Saves keyframes in the fast format of BitmapCodec instead of PNG. Both are readable on load.
+     * Keyframes already on disk keep their format until they are modified.
+     */
+    void setFastKeyFrames(bool b) { mFastKeyFrames = b; }
+
 protected:
     Status saveKeyFrameFile(KeyFrame*, QString strPath) override;
     KeyFrame* createKeyFrame(int position) override;
+    QString keyFrameFileToWrite(KeyFrame* key, const QString& dataFolder) override;
+    Status writeKeyFrameFile(const KeyFrame* key, const QString& filePath) const override;
+    Status keyFrameFileWritten(KeyFrame* key, const QString& filePath, const Status& st) override;
 
 private:
     void loadImageAtFrame(QString strFilePath, QPoint topLeft, int frameNumber, qreal opacity);
     QString filePath(KeyFrame* key, const QDir& dataFolder) const;
     QString fileName(KeyFrame* key) const;
+    QString fileSuffix(KeyFrame* key) const;
     bool needSaveFrame(KeyFrame* key, const QString& strSavePath);
+
+    bool mFastKeyFrames = false;
 };
 
 #endif
@@ -16,8 +16,10 @@ GNU General Public License for more details.
 */
 #include "layercamera.h"
 
+#include <QMutexLocker>
 #include <QSettings>
 #include <QEasingCurve>
+#include <QXmlStreamReader>
 
 #include "camera.h"
 #include "pencildef.h"
@@ -59,6 +61,7 @@ bool LayerCamera::removeKeyFrame(int position)
 void LayerCamera::replaceKeyFrame(const KeyFrame* camera)
 {
     *getCameraAtFrame(camera->pos()) = *static_cast<const Camera*>(camera);
+    clearSegmentCache();
 }
 
 Camera* LayerCamera::getCameraAtFrame(int frameNumber) const
@@ -107,6 +110,53 @@ QTransform LayerCamera::getViewAtFrame(int frameNumber) const
         return camera1->getView();
     }
 
+    QMutexLocker locker(&mSegmentCacheMutex);
+    const InterpolatedSegment& segment = interpolatedSegment(camera1, camera2);
+    return segment.views[qBound(0, frameNumber - segment.firstPos, segment.views.size() - 1)];
+}
+
+void LayerCamera::keyFramesChanged()
+{
+    clearSegmentCache();
+}
+
+void LayerCamera::clearSegmentCache() const
+{
+    QMutexLocker locker(&mSegmentCacheMutex);
+    mSegmentCache.clear();
+}
+
+/** Must be called with mSegmentCacheMutex held, the returned entry is only valid until it is released. */
+const LayerCamera::InterpolatedSegment& LayerCamera::interpolatedSegment(const Camera* camera1, const Camera* camera2) const
+{
+    InterpolatedSegment& segment = mSegmentCache[camera1->pos()];
+    if (segment.first == camera1 && segment.firstRevision == camera1->revision() && segment.firstPos == camera1->pos() &&
+        segment.last == camera2 && segment.lastRevision == camera2->revision() && segment.lastPos == camera2->pos())
+    {
+        return segment;
+    }
+
+    segment.first = camera1;
+    segment.last = camera2;
+    segment.firstRevision = camera1->revision();
+    segment.lastRevision = camera2->revision();
+    segment.firstPos = camera1->pos();
+    segment.lastPos = camera2->pos();
+
+    const int frameCount = camera2->pos() - camera1->pos() + 1;
+    const QPointF center = QRectF(viewRect).center();
+    segment.views.resize(frameCount);
+    segment.path.resize(frameCount);
+    for (int i = 0; i < frameCount; i++)
+    {
+        segment.views[i] = interpolateView(camera1, camera2, camera1->pos() + i);
+        segment.path[i] = segment.views[i].inverted().map(center);
+    }
+    return segment;
+}
+
+QTransform LayerCamera::interpolateView(const Camera* camera1, const Camera* camera2, int frameNumber) const
+{
     double frame1 = camera1->pos();
     double frame2 = camera2->pos();
 
@@ -287,6 +337,7 @@ void LayerCamera::splitControlPointIfNeeded(int frame) const
         Camera* camPrev = getCameraAtFrame(prev);
         camPrev->setPathControlPointMoved(false);
     }
+    clearSegmentCache();
 }
 
 void LayerCamera::mergeControlPointIfNeeded(int frame) const
@@ -327,6 +378,7 @@ void LayerCamera::mergeControlPointIfNeeded(int frame) const
             }
         }
     }
+    clearSegmentCache();
 }
 
 QRect LayerCamera::getViewRect() const
@@ -342,6 +394,7 @@ QSize LayerCamera::getViewSize() const
 void LayerCamera::setViewRect(QRect newViewRect)
 {
     viewRect = newViewRect;
+    clearSegmentCache(); // the cached path depends on the view rect
 }
 
 void LayerCamera::setCameraEasingAtFrame(CameraEasingType type, int frame) const
@@ -349,6 +402,7 @@ void LayerCamera::setCameraEasingAtFrame(CameraEasingType type, int frame) const
     Camera* camera = getLastCameraAtFrame(frame);
     camera->setEasingType(type);
     camera->updateViewTransform();
+    clearSegmentCache();
 }
 
 void LayerCamera::resetCameraAtFrame(CameraFieldOption type, int frame) const
@@ -412,6 +466,7 @@ void LayerCamera::resetCameraAtFrame(CameraFieldOption type, int frame) const
     }
 
     camera->updateViewTransform();
+    clearSegmentCache();
 }
 
 void LayerCamera::updateDotColor(DotColorType color)
@@ -488,6 +543,19 @@ QList<QPointF> LayerCamera::getBezierPointsAtFrame(int frame) const
     return points;
 }
 
+/** Camera centers of every frame from the key at @p keyFramePosition to the next key, in canvas coordinates. */
+QPolygonF LayerCamera::getInterpolatedPath(int keyFramePosition) const
+{
+    Camera* camera1 = getCameraAtFrame(keyFramePosition);
+    Camera* camera2 = getCameraAtFrame(getNextKeyFramePosition(keyFramePosition));
+    if (camera1 == nullptr || camera2 == nullptr || camera1 == camera2)
+    {
+        return QPolygonF();
+    }
+    QMutexLocker locker(&mSegmentCacheMutex);
+    return interpolatedSegment(camera1, camera2).path;
+}
+
 QPointF LayerCamera::getCenteredPathPoint(int frame) const
 {
     if (!keyExists(frame) || frame == getMaxKeyFramePosition())
@@ -512,6 +580,7 @@ void LayerCamera::setPathMovedAtFrame(int frame, bool moved) const
     Q_ASSERT(cam);
 
     cam->setPathControlPointMoved(moved);
+    clearSegmentCache();
 }
 
 void LayerCamera::updatePathControlPointAtFrame(const QPointF& point, int frame) const
@@ -521,6 +590,7 @@ void LayerCamera::updatePathControlPointAtFrame(const QPointF& point, int frame)
 
     camera->setPathControlPoint(point);
     camera->setPathControlPointMoved(true);
+    clearSegmentCache();
 }
 
 void LayerCamera::loadImageAtFrame(int frameNumber, qreal dx, qreal dy, qreal rotate, qreal scale, CameraEasingType easing, const QPointF& pathPoint, bool pathMoved)
@@ -631,3 +701,40 @@ void LayerCamera::loadDomElement(const QDomElement& element, QString dataDirPath
         imageTag = imageTag.nextSibling();
     }
 }
+
+void LayerCamera::loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep)
+{
+    Q_UNUSED(dataDirPath)
+    Q_UNUSED(progressStep)
+
+    const QXmlStreamAttributes layerAttrs = xmlStream.attributes();
+    this->loadBaseXmlAttributes(layerAttrs);
+
+    int width = layerAttrs.value("width").toInt();
+    int height = layerAttrs.value("height").toInt();
+    mShowPath = layerAttrs.value("showPath").toInt();
+    updateDotColor(static_cast<DotColorType>(layerAttrs.value("pathColorType").toInt()));
+    viewRect = QRect(-width / 2, -height / 2, width, height);
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("camera"))
+        {
+            const QXmlStreamAttributes attrs = xmlStream.attributes();
+            int frame = attrs.value("frame").toInt();
+
+            qreal rotate = attrs.value("r").toDouble();
+            qreal scale = attrs.hasAttribute("s") ? attrs.value("s").toDouble() : 1.0;
+            qreal dx = attrs.value("dx").toDouble();
+            qreal dy = attrs.value("dy").toDouble();
+            CameraEasingType easing = static_cast<CameraEasingType>(attrs.value("easing").toInt());
+            qreal pathX = attrs.value("pathCPX").toDouble();
+            qreal pathY = attrs.value("pathCPY").toDouble();
+
+            bool pathMoved = pathX != 0 || pathY != 0;
+
+            loadImageAtFrame(frame, dx, dy, rotate, scale, easing, QPointF(pathX, pathY), pathMoved);
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
@@ -19,6 +19,11 @@ GNU General Public License for more details.
 
 #include <QRect>
 #include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QPolygonF>
+#include <QTransform>
+#include <QVector>
 #include "layer.h"
 #include "camerafieldoption.h"
 #include "cameraeasingtype.h"
@@ -37,6 +42,7 @@ public:
 
     QDomElement createDomElement(QDomDocument& doc) const override;
     void loadDomElement(const QDomElement& element, QString dataDirPath, ProgressCallback progressStep) override;
+    void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep) override;
 
     bool addKeyFrame(int position, KeyFrame* pKeyFrame) override;
     bool removeKeyFrame(int position) override;
@@ -64,6 +70,7 @@ public:
     bool hasSameTranslation(int frame1, int frame2) const;
     QList<QPointF> getBezierPointsAtFrame(int frame) const;
     QPointF getCenteredPathPoint(int frame) const;
+    QPolygonF getInterpolatedPath(int keyFramePosition) const;
     void updatePathControlPointAtFrame(const QPointF& point, int frame) const;
     void setPathMovedAtFrame(int frame, bool moved) const;
 
@@ -73,8 +80,26 @@ public:
 protected:
     Status saveKeyFrameFile(KeyFrame*, QString path) override;
     KeyFrame* createKeyFrame(int position) override;
+    void keyFramesChanged() override;
 
 private:
+    /** Views and camera centers of every frame from one camera key to the next. */
+    struct InterpolatedSegment
+    {
+        const Camera* first = nullptr;
+        const Camera* last = nullptr;
+        quint64 firstRevision = 0;
+        quint64 lastRevision = 0;
+        int firstPos = 0;
+        int lastPos = 0;
+
+        QVector<QTransform> views;
+        QPolygonF path; //< center of the view rect in canvas coordinates
+    };
+
+    void clearSegmentCache() const;
+    const InterpolatedSegment& interpolatedSegment(const Camera* camera1, const Camera* camera2) const;
+    QTransform interpolateView(const Camera* camera1, const Camera* camera2, int frameNumber) const;
     void linearInterpolateTransform(Camera*);
     qreal getInterpolationPercent(CameraEasingType type, qreal percent) const;
     QPointF getBezierPoint(const QPointF& first, const QPointF& last, const QPointF& pathPoint, qreal percent) const;
@@ -88,6 +113,13 @@ private:
     DotColorType mDotColorType = DotColorType::RED;
 
     const int mControlPointMergeThreshold = 2000;
+
+    // Keyed by the position of the first key. It is cleared whenever keys are added, removed
+    // or moved and by the setters above; cameras edited directly are caught by their revision,
+    // as an entry is only used while both keys are at the same positions and revisions as when it was built.
+    // Exports and preloading read views from worker threads, so the cache is only accessed under the mutex.
+    mutable QHash<int, InterpolatedSegment> mSegmentCache;
+    mutable QMutex mSegmentCacheMutex;
 };
 
 #endif
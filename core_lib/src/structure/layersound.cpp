@@ -18,9 +18,12 @@ GNU General Public License for more details.
 
 #include <QDebug>
 #include <QMediaPlayer>
+#include <QFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QXmlStreamReader>
 #include "soundclip.h"
+#include "soundwaveform.h"
 #include "util/util.h"
 
 
@@ -117,6 +120,34 @@ void LayerSound::loadDomElement(const QDomElement& element, QString dataDirPath,
     }
 }
 
+void LayerSound::loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep)
+{
+    this->loadBaseXmlAttributes(xmlStream.attributes());
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == QLatin1String("sound"))
+        {
+            const QXmlStreamAttributes attrs = xmlStream.attributes();
+            const QString soundFile = attrs.value("src").toString();
+            const QString sSoundClipName = attrs.hasAttribute("name") ? attrs.value("name").toString() : QString("My Sound Clip");
+
+            if (!soundFile.isEmpty())
+            {
+                QString path = validateDataPath(soundFile, dataDirPath);
+                if (!path.isEmpty())
+                {
+                    int position = attrs.value("frame").toInt();
+                    Status st = loadSoundClipAtFrame(sSoundClipName, path, position);
+                    Q_ASSERT(st.ok());
+                }
+            }
+            progressStep();
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
 void LayerSound::replaceKeyFrame(const KeyFrame* soundClip)
 {
     *getSoundClipWhichCovers(soundClip->pos()) = *static_cast<const SoundClip*>(soundClip);
@@ -155,11 +186,35 @@ Status LayerSound::saveKeyFrameFile(KeyFrame* key, QString path)
             dd << QString("Error: Failed to save SoundClip");
             return Status(Status::FAIL, dd);
         }
+
+        // The waveform peaks travel with the sound, so they don't have to be analysed again.
+        // They are written again rather than copied, as the copy of the sound has another modification time.
+        const QString sDestPeakFile = SoundWaveform::peakFileName(sDestFileLocation);
+        QFile::remove(sDestPeakFile);
+        SoundWaveform waveform;
+        if (waveform.load(SoundWaveform::peakFileName(key->fileName()), info).ok())
+        {
+            waveform.save(sDestPeakFile, QFileInfo(sDestFileLocation));
+        }
     }
     key->setFileName(sDestFileLocation);
     return Status::OK;
 }
 
+QStringList LayerSound::keyFrameFiles(const KeyFrame* key) const
+{
+    QStringList files = Layer::keyFrameFiles(key);
+    if (!files.isEmpty())
+    {
+        const QString peakFile = SoundWaveform::peakFileName(key->fileName());
+        if (QFile::exists(peakFile))
+        {
+            files.append(peakFile);
+        }
+    }
+    return files;
+}
+
 KeyFrame* LayerSound::createKeyFrame(int position)
 {
     SoundClip* s = new SoundClip;
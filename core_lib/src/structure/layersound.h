@@ -31,6 +31,7 @@ public:
     ~LayerSound();
     QDomElement createDomElement(QDomDocument& doc) const override;
     void loadDomElement(const QDomElement& element, QString dataDirPath, ProgressCallback progressStep) override;
+    void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep) override;
 
     void replaceKeyFrame(const KeyFrame* soundClip) override;
 
@@ -42,6 +43,7 @@ public:
 protected:
     Status saveKeyFrameFile(KeyFrame*, QString path) override;
     KeyFrame* createKeyFrame(int position) override;
+    QStringList keyFrameFiles(const KeyFrame* key) const override;
 };
 
 #endif
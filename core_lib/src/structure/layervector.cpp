@@ -17,9 +17,12 @@ GNU General Public License for more details.
 #include "layervector.h"
 
 #include "vectorimage.h"
+#include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QXmlStreamReader>
 #include "util/util.h"
 
 LayerVector::LayerVector(int id) : Layer(id, Layer::VECTOR)
@@ -29,6 +32,10 @@ LayerVector::LayerVector(int id) : Layer(id, Layer::VECTOR)
 
 LayerVector::~LayerVector()
 {
+    for (PendingImage& pending : mPendingImages)
+    {
+        delete pending.image;
+    }
 }
 
 bool LayerVector::usesColor(int colorIndex)
@@ -70,23 +77,44 @@ void LayerVector::loadImageAtFrame(QString path, int frameNumber)
     }
     VectorImage* vecImg = new VectorImage;
     vecImg->setPos(frameNumber);
-    vecImg->read(path);
+    if (!vecImg->read(path))
+    {
+        qWarning() << "Unable to read vector keyframe" << path;
+    }
     addKeyFrame(frameNumber, vecImg);
 }
 
 Status LayerVector::saveKeyFrameFile(KeyFrame* keyFrame, QString path)
 {
-    QString theFileName = fileName(keyFrame);
-    QString strFilePath = QDir(path).filePath(theFileName);
+    QString strFilePath = keyFrameFileToWrite(keyFrame, path);
+    if (strFilePath.isEmpty())
+    {
+        return Status::SAFE;
+    }
+    return keyFrameFileWritten(keyFrame, strFilePath, writeKeyFrameFile(keyFrame, strFilePath));
+}
 
-    VectorImage* vecImage = static_cast<VectorImage*>(keyFrame);
+QString LayerVector::keyFrameFileToWrite(KeyFrame* keyFrame, const QString& dataFolder)
+{
+    QString theFileName = fileName(keyFrame);
+    QString strFilePath = QDir(dataFolder).filePath(theFileName);
 
     if (needSaveFrame(keyFrame, strFilePath) == false)
     {
-        return Status::SAFE;
+        return QString();
     }
+    return strFilePath;
+}
+
+Status LayerVector::writeKeyFrameFile(const KeyFrame* keyFrame, const QString& strFilePath) const
+{
+    return static_cast<const VectorImage*>(keyFrame)->write(strFilePath, mBinaryKeyFrames ? "VECB" : "VEC");
+}
+
+Status LayerVector::keyFrameFileWritten(KeyFrame* keyFrame, const QString& strFilePath, const Status& st)
+{
+    VectorImage* vecImage = static_cast<VectorImage*>(keyFrame);
 
-    Status st = vecImage->write(strFilePath, "VEC");
     if (!st.ok())
     {
         vecImage->setFileName("");
@@ -185,6 +213,85 @@ void LayerVector::loadDomElement(const QDomElement& element, QString dataDirPath
     }
 }
 
+void LayerVector::loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep)
+{
+    QThreadPool pool;
+    loadXmlStream(xmlStream, dataDirPath, progressStep, pool);
+    pool.waitForDone();
+    finishLoad(progressStep);
+}
+
+void LayerVector::loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep, QThreadPool& pool)
+{
+    this->loadBaseXmlAttributes(xmlStream.attributes());
+
+    // .vec files are independent of each other, so they are parsed on the pool
+    // while the rest of the xml is read, and only added to the layer in finishLoad().
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() != QLatin1String("image"))
+        {
+            xmlStream.skipCurrentElement();
+            continue;
+        }
+
+        const QXmlStreamAttributes attrs = xmlStream.attributes();
+        const int position = attrs.value("frame").toInt();
+        const qreal opacity = attrs.hasAttribute("opacity") ? attrs.value("opacity").toDouble() : 1.0;
+
+        if (attrs.hasAttribute("src"))
+        {
+            QString path = validateDataPath(attrs.value("src").toString(), dataDirPath);
+            if (!path.isEmpty())
+            {
+                VectorImage* vecImg = new VectorImage;
+                vecImg->setPos(position);
+                vecImg->setOpacity(opacity);
+                mPendingImages.push_back({ vecImg, path, false });
+                PendingImage& pending = mPendingImages.back();
+                pool.start([&pending] { pending.ok = pending.image->read(pending.path); });
+            }
+            else
+            {
+                progressStep();
+            }
+            xmlStream.skipCurrentElement();
+        }
+        else
+        {
+            addNewKeyFrameAt(position);
+            VectorImage* vecImg = getVectorImageAtFrame(position);
+            vecImg->loadXmlStream(xmlStream);
+            vecImg->setOpacity(opacity);
+            progressStep();
+        }
+    }
+}
+
+void LayerVector::finishLoad(ProgressCallback progressStep)
+{
+    for (PendingImage& pending : mPendingImages)
+    {
+        if (!pending.ok)
+        {
+            qWarning() << "Unable to read vector keyframe" << pending.path;
+        }
+
+        VectorImage* vecImg = pending.image;
+        const int position = vecImg->pos();
+        if (keyExists(position))
+        {
+            removeKeyFrame(position);
+        }
+        if (!addKeyFrame(position, vecImg))
+        {
+            delete vecImg;
+        }
+        progressStep();
+    }
+    mPendingImages.clear();
+}
+
 VectorImage* LayerVector::getVectorImageAtFrame(int frameNumber) const
 {
     return static_cast<VectorImage*>(getKeyFrameAt(frameNumber));
@@ -17,9 +17,11 @@ GNU General Public License for more details.
 #ifndef LAYERVECTOR_H
 #define LAYERVECTOR_H
 
+#include <list>
 #include <QImage>
 #include "layer.h"
 
+class QThreadPool;
 class VectorImage;
 
 class LayerVector : public Layer
@@ -35,6 +37,15 @@ public:
 
     QDomElement createDomElement(QDomDocument& doc) const override;
     void loadDomElement(const QDomElement& element, QString dataDirPath, ProgressCallback progressStep) override;
+    void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep) override;
+
+    /**
+     * Reads the layer like loadXmlStream() above, but leaves the .vec files to be parsed on @p pool,
+     * so that the files of several layers can be parsed at once.
+     * Call finishLoad() once the pool is done to add those keyframes to the layer.
+     */
+    void loadXmlStream(QXmlStreamReader& xmlStream, QString dataDirPath, ProgressCallback progressStep, QThreadPool& pool);
+    void finishLoad(ProgressCallback progressStep);
 
     VectorImage* getVectorImageAtFrame(int frameNumber) const;
     VectorImage* getLastVectorImageAtFrame(int frameNumber) const;
@@ -44,13 +55,30 @@ public:
     void removeColor(int index);
     void moveColor(int start, int end);
 
+    /** Saves keyframes in the compact binary vector format instead of xml. Both are readable on load. */
+    void setBinaryKeyFrames(bool b) { mBinaryKeyFrames = b; }
+
 protected:
     Status saveKeyFrameFile(KeyFrame*, QString path) override;
     KeyFrame* createKeyFrame(int position) override;
+    QString keyFrameFileToWrite(KeyFrame* key, const QString& dataFolder) override;
+    Status writeKeyFrameFile(const KeyFrame* key, const QString& filePath) const override;
+    Status keyFrameFileWritten(KeyFrame* key, const QString& filePath, const Status& st) override;
 
 private:
     QString fileName(KeyFrame* key) const;
     bool needSaveFrame(KeyFrame* key, const QString& strSavePath);
+
+    /** A keyframe parsed on a thread pool while loading, not yet in the layer */
+    struct PendingImage
+    {
+        VectorImage* image = nullptr;
+        QString path;
+        bool ok = false;
+    };
+
+    bool mBinaryKeyFrames = false;
+    std::list<PendingImage> mPendingImages; //< a list, so the entries stay in place while the pool writes to them
 };
 
 #endif
@@ -17,6 +17,7 @@ GNU General Public License for more details.
 #include "object.h"
 
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QTextStream>
 #include <QProgressDialog>
 #include <QApplication>
@@ -27,6 +28,7 @@ GNU General Public License for more details.
 #include <QDateTime>
 #include <QImageWriter>
 #include <QRegularExpression>
+#include <QThreadPool>
 
 #include "layer.h"
 #include "layerbitmap.h"
@@ -39,6 +41,7 @@ GNU General Public License for more details.
 #include "vectorimage.h"
 #include "fileformat.h"
 #include "activeframepool.h"
+#include "tracer.h"
 
 
 Object::Object()
@@ -118,6 +121,63 @@ bool Object::loadXML(const QDomElement& docElem, ProgressCallback progressForwar
     return true;
 }
 
+/** Builds the layers straight from a stream positioned on the <object> start element.
+ *  The reader is left on the matching end element. */
+bool Object::loadXmlStream(QXmlStreamReader& xmlStream, ProgressCallback progressForward)
+{
+    const QString dataDirPath = mDataDirPath;
+
+    // The .vec files of all vector layers are parsed on one pool while the rest of the xml is read
+    QThreadPool pool;
+    std::vector<LayerVector*> vectorLayers;
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() != QLatin1String("layer"))
+        {
+            xmlStream.skipCurrentElement();
+            continue;
+        }
+
+        Layer* newLayer;
+        switch (xmlStream.attributes().value("type").toInt())
+        {
+        case Layer::BITMAP:
+            newLayer = new LayerBitmap(getUniqueLayerID());
+            break;
+        case Layer::VECTOR:
+            newLayer = new LayerVector(getUniqueLayerID());
+            break;
+        case Layer::SOUND:
+            newLayer = new LayerSound(getUniqueLayerID());
+            break;
+        case Layer::CAMERA:
+            newLayer = new LayerCamera(getUniqueLayerID());
+            break;
+        default:
+            Q_UNREACHABLE();
+        }
+        mLayers.append(newLayer);
+        if (newLayer->type() == Layer::VECTOR)
+        {
+            LayerVector* layerVector = static_cast<LayerVector*>(newLayer);
+            layerVector->loadXmlStream(xmlStream, dataDirPath, progressForward, pool);
+            vectorLayers.push_back(layerVector);
+        }
+        else
+        {
+            newLayer->loadXmlStream(xmlStream, dataDirPath, progressForward);
+        }
+    }
+
+    pool.waitForDone();
+    for (LayerVector* layerVector : vectorLayers)
+    {
+        layerVector->finishLoad(progressForward);
+    }
+    return !xmlStream.hasError();
+}
+
 LayerBitmap* Object::addNewBitmapLayer()
 {
     LayerBitmap* layerBitmap = new LayerBitmap(getUniqueLayerID());
@@ -760,6 +820,31 @@ void Object::paintImage(QPainter& painter,int frameNumber,
     }
 }
 
+FrameSignature Object::frameSignature(int frameNumber, const QTransform& view) const
+{
+    FrameSignature signature;
+    signature.view = view;
+    for (Layer* layer : mLayers)
+    {
+        if (!layer->visible())
+        {
+            continue;
+        }
+
+        if (layer->type() == Layer::BITMAP)
+        {
+            BitmapImage* bitmap = static_cast<LayerBitmap*>(layer)->getLastBitmapImageAtFrame(frameNumber);
+            signature.keys.emplace_back(bitmap, bitmap ? bitmap->getOpacity() : 0.0);
+        }
+        else if (layer->type() == Layer::VECTOR)
+        {
+            VectorImage* vec = static_cast<LayerVector*>(layer)->getLastVectorImageAtFrame(frameNumber);
+            signature.keys.emplace_back(vec, vec ? vec->getOpacity() : 0.0);
+        }
+    }
+    return signature;
+}
+
 QString Object::copyFileToDataFolder(const QString& strFilePath)
 {
     if (!QFile::exists(strFilePath))
@@ -799,8 +884,10 @@ Status Object::exportFrames(int frameStart, int frameEnd,
                           const QString& layerName,
                           bool antialiasing,
                           QProgressDialog* progress = nullptr,
-                          int progressMax = 50) const
+                          int progressMax = 50,
+                          const std::function<void(int, const QString&)>& frameExported) const
 {
+    TRACE_SCOPE("export", "Object::exportFrames");
     Q_ASSERT(cameraLayer);
 
     QString extension = "";
@@ -845,6 +932,10 @@ Status Object::exportFrames(int frameStart, int frameEnd,
     dd << "\n[Export frames diagnostics]\n";
     bool ok = true;
 
+    // Held drawings are not rendered again, the previously written file is copied instead
+    FrameSignature lastSignature;
+    QString lastFileName;
+
     for (int currentFrame = frameStart; currentFrame <= frameEnd; currentFrame++)
     {
         if (progress != nullptr)
@@ -872,24 +963,33 @@ Status Object::exportFrames(int frameStart, int frameEnd,
         }
         QString sFileName = filePath + frameNumberString + extension;
         Layer* layer = findLayerByName(layerName);
-        Status st = Status::SAFE;
-        if (exportKeyframesOnly)
+        if (exportKeyframesOnly && !layer->keyExists(currentFrame))
         {
-            if (layer->keyExists(currentFrame))
-            {
-                st = exportIm(currentFrame, view, camSize, exportSize, sFileName, format, antialiasing, transparency);
-            }
+            continue;
         }
-        else
+
+        FrameSignature signature = frameSignature(currentFrame, view);
+        if (!lastFileName.isEmpty() && signature == lastSignature)
         {
-            st = exportIm(currentFrame, view, camSize, exportSize, sFileName, format, antialiasing, transparency);
+            QFile::remove(sFileName);
+            if (QFile::copy(lastFileName, sFileName))
+            {
+                if (frameExported) { frameExported(currentFrame, sFileName); }
+                continue;
+            }
         }
 
+        Status st = exportIm(currentFrame, view, camSize, exportSize, sFileName, format, antialiasing, transparency);
         if (!st.ok())
         {
             ok = false;
             dd.collect(st.details());
+            lastFileName.clear();
+            continue;
         }
+        lastSignature = signature;
+        lastFileName = sFileName;
+        if (frameExported) { frameExported(currentFrame, sFileName); }
     }
 
     if (!ok)
@@ -903,6 +1003,7 @@ Status Object::exportFrames(int frameStart, int frameEnd,
 
 Status Object::exportIm(int frame, const QTransform& view, QSize cameraSize, QSize exportSize, const QString& filePath, const QString& format, bool antialiasing, bool transparency) const
 {
+    TRACE_SCOPE("export", "Object::exportIm");
     QImage imageToExport(exportSize, QImage::Format_ARGB32_Premultiplied);
 
     QColor bgColor = Qt::white;
@@ -973,8 +1074,23 @@ void Object::updateActiveFrames(int frame) const
     }
 }
 
+void Object::addToActiveFrames(KeyFrame* key) const
+{
+    mActiveFramePool->put(key);
+}
+
 void Object::setActiveFramePoolSize(int sizeInMB)
 {
     // convert MB to Byte
     mActiveFramePool->resize(qint64(sizeInMB) * 1024 * 1024);
 }
+
+quint64 Object::activeFramePoolUsedMemory() const
+{
+    return mActiveFramePool->usedMemory();
+}
+
+quint64 Object::activeFramePoolBudget() const
+{
+    return mActiveFramePool->memoryBudget();
+}
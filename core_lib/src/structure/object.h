@@ -18,10 +18,12 @@ GNU General Public License for more details.
 #define OBJECT_H
 
 #include <memory>
+#include <vector>
 #include <QCoreApplication>
 #include <QObject>
 #include <QList>
 #include <QColor>
+#include <QTransform>
 #include "layer.h"
 #include "colorref.h"
 #include "pencilerror.h"
@@ -30,6 +32,7 @@ GNU General Public License for more details.
 
 class QProgressDialog;
 class QFile;
+class QXmlStreamReader;
 class LayerBitmap;
 class LayerVector;
 class LayerCamera;
@@ -37,6 +40,20 @@ class LayerSound;
 class ObjectData;
 class ActiveFramePool;
 
+/**
+ * Identifies what Object::paintImage() draws for a frame: the camera view and,
+ * for every visible drawing layer, the keyframe shown and its opacity.
+ * Two frames with equal signatures render to identical images, which lets
+ * exporters reuse the previous frame for held drawings.
+ */
+struct FrameSignature
+{
+    QTransform view;
+    std::vector<std::pair<const KeyFrame*, qreal>> keys;
+
+    bool operator==(const FrameSignature& other) const { return view == other.view && keys == other.keys; }
+    bool operator!=(const FrameSignature& other) const { return !(*this == other); }
+};
 
 class Object final
 {
@@ -68,8 +85,10 @@ public:
 
     QDomElement saveXML(QDomDocument& doc) const;
     bool loadXML(const QDomElement& element, ProgressCallback progressForward);
+    bool loadXmlStream(QXmlStreamReader& xmlStream, ProgressCallback progressForward);
 
     void paintImage(QPainter& painter, int frameNumber, bool background, bool antialiasing) const;
+    FrameSignature frameSignature(int frameNumber, const QTransform& view) const;
 
     QString copyFileToDataFolder(const QString& strFilePath);
 
@@ -147,8 +166,10 @@ public:
     }
 
     // these functions need to be moved to somewhere...
+    /** @p frameExported is called with the frame number and file name of every frame written */
     Status exportFrames(int frameStart, int frameEnd, const LayerCamera* cameraLayer, QSize exportSize, QString filePath, QString format,
-                      bool transparency, bool exportKeyframesOnly, const QString& layerName, bool antialiasing, QProgressDialog* progress, int progressMax) const;
+                      bool transparency, bool exportKeyframesOnly, const QString& layerName, bool antialiasing, QProgressDialog* progress, int progressMax,
+                      const std::function<void(int, const QString&)>& frameExported = {}) const;
 
     Status exportIm(int frameStart, const QTransform& view, QSize cameraSize, QSize exportSize, const QString& filePath, const QString& format, bool antialiasing, bool transparency) const;
 
@@ -164,7 +185,17 @@ public:
 
     int totalKeyFrameCount() const;
     void updateActiveFrames(int frame) const;
+    /** Keeps an already loaded keyframe in the pool, as if it had been visited */
+    void addToActiveFrames(KeyFrame* key) const;
     void setActiveFramePoolSize(int sizeInMB);
+    quint64 activeFramePoolUsedMemory() const;
+    quint64 activeFramePoolBudget() const;
+
+    void setBinaryVectorKeyFrames(bool b) { mBinaryVectorKeyFrames = b; }
+    bool binaryVectorKeyFrames() const { return mBinaryVectorKeyFrames; }
+
+    void setFastBitmapKeyFrames(bool b) { mFastBitmapKeyFrames = b; }
+    bool fastBitmapKeyFrames() const { return mFastBitmapKeyFrames; }
 
 private:
     int getMaxLayerID();
@@ -176,6 +207,8 @@ private:
 
     QList<Layer*> mLayers;
     bool modified = false;
+    bool mBinaryVectorKeyFrames = false; //< save vector keyframes in the compact binary format
+    bool mFastBitmapKeyFrames = false; //< save bitmap keyframes in the fast lossless format instead of PNG
 
     QList<ColorRef> mPalette;
 
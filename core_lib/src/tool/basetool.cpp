@@ -57,8 +57,8 @@ void BaseTool::initialize(Editor* editor)
 {
     Q_ASSERT(editor);
     mEditor = editor;
+    // Null when exporting from the command line, where tools are never used
     mScribbleArea = editor->getScribbleArea();
-    Q_ASSERT(mScribbleArea);
     loadSettings();
 }
 
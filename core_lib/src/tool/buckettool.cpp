@@ -18,6 +18,7 @@ GNU General Public License for more details.
 
 #include <QPixmap>
 #include <QPainter>
+#include <QProgressDialog>
 #include <QSettings>
 #include "pointerevent.h"
 
@@ -47,6 +48,7 @@ void BucketTool::loadSettings()
     mPropertyUsed[BucketToolProperties::FILLEXPAND_ENABLED] = { Layer::BITMAP };
     mPropertyUsed[BucketToolProperties::FILLLAYERREFERENCEMODE_VALUE] = { Layer::BITMAP };
     mPropertyUsed[BucketToolProperties::FILLMODE_VALUE] = { Layer::BITMAP };
+    mPropertyUsed[BucketToolProperties::FILLSELECTEDFRAMES_ENABLED] = { Layer::BITMAP };
 
     QSettings pencilSettings(PENCIL2D, PENCIL2D);
 
@@ -59,6 +61,7 @@ void BucketTool::loadSettings()
     info[BucketToolProperties::FILLEXPAND_ENABLED] = true;
     info[BucketToolProperties::FILLLAYERREFERENCEMODE_VALUE] = { 0, 1, 0 };
     info[BucketToolProperties::FILLMODE_VALUE] = { 0, 2, 0 };
+    info[BucketToolProperties::FILLSELECTEDFRAMES_ENABLED] = false;
 
     toolProperties().insertProperties(info);
     toolProperties().loadFrom(typeName(), pencilSettings);
@@ -82,6 +85,17 @@ void BucketTool::loadSettings()
     }
 }
 
+void BucketTool::clearToolData()
+{
+    mBitmapBucketCache.clear();
+}
+
+bool BucketTool::leavingThisTool()
+{
+    mBitmapBucketCache.clear();
+    return BaseTool::leavingThisTool();
+}
+
 QCursor BucketTool::cursor()
 {
     if (mEditor->preference()->isOn(SETTING::TOOL_CURSOR))
@@ -104,12 +118,17 @@ void BucketTool::pointerPressEvent(PointerEvent* event)
 
     LayerCamera* layerCam = mEditor->layers()->getCameraLayerBelow(mEditor->currentLayerIndex());
 
-    mUndoSaveState = mEditor->undoRedo()->createState(UndoRedoRecordType::KEYFRAME_MODIFY);
+    // Filling several frames happens once on release, so there's nothing to fill while dragging
+    mFillSelectedFrames = mSettings.fillSelectedFramesEnabled() && targetLayer->hasAnySelectedFrames();
+
+    mUndoSaveState = mEditor->undoRedo()->createState(mFillSelectedFrames ? UndoRedoRecordType::KEYFRAMES_MODIFY
+                                                                          : UndoRedoRecordType::KEYFRAME_MODIFY);
     mBitmapBucket = BitmapBucket(mEditor,
                                  mEditor->color()->frontColor(),
                                  layerCam ? layerCam->getViewAtFrame(mEditor->currentFrame()).inverted().mapRect(layerCam->getViewRect()) : QRect(),
                                  getCurrentPoint(),
-                                 mSettings);
+                                 mSettings,
+                                 &mBitmapBucketCache);
 
     // Because we can change layer to on the fly, but we do not act reactively
     // on it, it's necessary to invalidate layer cache on press event.
@@ -123,7 +142,7 @@ void BucketTool::pointerMoveEvent(PointerEvent* event)
     if (event->buttons() & Qt::LeftButton)
     {
         Layer* layer = mEditor->layers()->currentLayer();
-        if (layer->type() == Layer::BITMAP)
+        if (layer->type() == Layer::BITMAP && !mFillSelectedFrames)
         {
             paintBitmap();
             mFilledOnMove = true;
@@ -145,12 +164,17 @@ void BucketTool::pointerReleaseEvent(PointerEvent* event)
             mEditor->backup(typeName());
             paintVector(layer);
         }
+        else if (layer->type() == Layer::BITMAP && mFillSelectedFrames)
+        {
+            paintBitmapFrames(layer);
+        }
         else if (layer->type() == Layer::BITMAP && !mFilledOnMove)
         {
             paintBitmap();
         }
     }
     mFilledOnMove = false;
+    mFillSelectedFrames = false;
 }
 
 void BucketTool::paintBitmap()
@@ -169,6 +193,36 @@ void BucketTool::paintBitmap()
     });
 }
 
+void BucketTool::paintBitmapFrames(Layer* layer)
+{
+    const QList<int> frames = layer->selectedKeyFramesPositions();
+
+    QProgressDialog progressDialog(tr("Filling frames..."), tr("Abort"), 0, frames.size(), mScribbleArea);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    mBitmapBucket.paintFrames(getCurrentPoint(), frames, [this, layer](BucketState progress, int layerIndex, int frameIndex)
+    {
+        if (progress == BucketState::WillFillTarget)
+        {
+            mEditor->undoRedo()->addKeyFrameState(mUndoSaveState, layer->getKeyFrameAt(frameIndex));
+            mEditor->backup(layerIndex, frameIndex, typeName());
+        }
+        else if (progress == BucketState::DidFillTarget)
+        {
+            mEditor->setModified(layerIndex, frameIndex);
+        }
+    }, [&progressDialog](int done, int total)
+    {
+        progressDialog.setMaximum(total);
+        progressDialog.setValue(done);
+        return !progressDialog.wasCanceled();
+    });
+
+    // Records nothing if no frame was filled
+    mEditor->undoRedo()->record(mUndoSaveState, typeName());
+}
+
 void BucketTool::paintVector(Layer* layer)
 {
     mScribbleArea->clearDrawingBuffer();
@@ -237,6 +291,12 @@ void BucketTool::setFillMode(int mode)
     emit fillModeChanged(mode);
 }
 
+void BucketTool::setFillSelectedFramesEnabled(bool enabled)
+{
+    toolProperties().setBaseValue(BucketToolProperties::FILLSELECTEDFRAMES_ENABLED, enabled);
+    emit fillSelectedFramesEnabledChanged(enabled);
+}
+
 QPointF BucketTool::getCurrentPoint() const
 {
     return mEditor->view()->mapScreenToCanvas(getCurrentPixel());
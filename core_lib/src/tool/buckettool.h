@@ -39,12 +39,15 @@ public:
     const BucketToolProperties& settings() const { return mSettings; }
 
     void loadSettings() override;
+    void clearToolData() override;
+    bool leavingThisTool() override;
 
     void pointerPressEvent(PointerEvent*) override;
     void pointerMoveEvent(PointerEvent*) override;
     void pointerReleaseEvent(PointerEvent*) override;
 
     void paintBitmap();
+    void paintBitmapFrames(Layer* layer);
     void paintVector(Layer* layer);
 
     void applyChanges();
@@ -56,12 +59,14 @@ public:
     void setFillExpandEnabled(bool enabled);
     void setFillReferenceMode(int referenceMode);
     void setFillMode(int mode);
+    void setFillSelectedFramesEnabled(bool enabled);
 
     QPointF getCurrentPoint() const;
     QPointF getCurrentPixel() const;
 
 signals:
     void fillModeChanged(int mode);
+    void fillSelectedFramesEnabledChanged(bool isON);
     void fillReferenceModeChanged(int referenceMode);
     void fillExpandEnabledChanged(bool isON);
     void fillExpandChanged(int fillExpandValue);
@@ -72,9 +77,11 @@ signals:
 private:
 
     BitmapBucket mBitmapBucket;
+    BitmapBucketCache mBitmapBucketCache;
     VectorImage* vectorImage = nullptr;
 
     bool mFilledOnMove = false;
+    bool mFillSelectedFrames = false;
 
     BucketToolProperties mSettings;
     StrokeInterpolator mInterpolator;
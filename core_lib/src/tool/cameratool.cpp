@@ -619,11 +619,10 @@ void CameraTool::paintInterpolations(QPainter& painter, const QTransform& worldT
         painter.setPen(Qt::black);
         painter.setBrush(color);
 
-        for (int frameInBetween = frame; frameInBetween <= nextFrame ; frameInBetween++)
+        const QPolygonF& path = cameraLayer->getInterpolatedPath(frame);
+        for (const QPointF& point : path)
         {
-            const QTransform& transform = cameraLayer->getViewAtFrame(frameInBetween);
-            const QPointF& center = Transform::mapToWorldRect(transform, worldTransform, cameraRect).center();
-            painter.drawEllipse(center, mDotWidth/2., mDotWidth/2.);
+            painter.drawEllipse(worldTransform.map(point), mDotWidth/2., mDotWidth/2.);
         }
         painter.restore();
 
@@ -498,6 +498,7 @@ struct BucketToolProperties: public ToolPropertiesBase
         FILLMODE_VALUE                  = 304,
         COLORTOLERANCE_ENABLED          = 305,
         FILLEXPAND_ENABLED              = 306,
+        FILLSELECTEDFRAMES_ENABLED      = 307,
 
         END                             = 399,
     };
@@ -513,7 +514,8 @@ struct BucketToolProperties: public ToolPropertiesBase
             { FILLEXPAND_ENABLED,           "FillExpandEnabled"},
             { COLORTOLERANCE_ENABLED,       "ColorToleranceEnabled"},
             { FILLLAYERREFERENCEMODE_VALUE, "FillReferenceMode"},
-            { FILLMODE_VALUE,               "FillMode"}
+            { FILLMODE_VALUE,               "FillMode"},
+            { FILLSELECTEDFRAMES_ENABLED,   "FillSelectedFramesEnabled"}
         });
     }
 
@@ -530,6 +532,7 @@ struct BucketToolProperties: public ToolPropertiesBase
     int fillMode() const { return getInfo(FILLMODE_VALUE).intValue(); }
     bool colorToleranceEnabled() const { return getInfo(COLORTOLERANCE_ENABLED).boolValue(); }
     bool fillExpandEnabled() const { return getInfo(FILLEXPAND_ENABLED).boolValue(); }
+    bool fillSelectedFramesEnabled() const { return getInfo(FILLSELECTEDFRAMES_ENABLED).boolValue(); }
 
 private:
     ToolProperties mToolProperties;
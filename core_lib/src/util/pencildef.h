@@ -230,6 +230,8 @@ const static int MaxFramesBound = 9999;
 #define SETTING_AUTO_SAVE_NUMBER    "AutosaveNumber"
 #define SETTING_AUTO_SAVE_BY_TIME       "AutoSaveByTime"
 #define SETTING_AUTO_SAVE_BY_TIME_TIMER "AutoSaveByTimeTimer"
+#define SETTING_BINARY_VECTOR_KEYFRAMES "BinaryVectorKeyFrames"
+#define SETTING_FAST_BITMAP_KEYFRAMES   "FastBitmapKeyFrames"
 #define SETTING_TOOL_CURSOR         "ToolCursors"
 #define SETTING_CANVAS_CURSOR       "DottedCursors"
 #define SETTING_HIGH_RESOLUTION     "HighResPosition"
@@ -275,6 +277,7 @@ const static int MaxFramesBound = 9999;
 #define SETTING_ONION_RED        "OnionRed"
 
 #define SETTING_FRAME_POOL_SIZE  "FramePoolSizeInMB"
+#define SETTING_FRAME_PRELOAD_COUNT "FramePreloadCount"
 #define SETTING_GRID_SIZE_W      "GridSizeW"
 #define SETTING_GRID_SIZE_H      "GridSizeH"
 #define SETTING_OVERLAY_CENTER   "OverlayCenter"
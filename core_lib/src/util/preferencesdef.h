@@ -93,6 +93,9 @@ enum class SETTING
     LOAD_MOST_RECENT,
     LOAD_DEFAULT_PRESET,
     DEFAULT_PRESET,
+    BINARY_VECTOR_KEYFRAMES,
+    FAST_BITMAP_KEYFRAMES,
+    FRAME_PRELOAD_COUNT,
     COUNT, // COUNT must always be the last one.
 };
 
@@ -0,0 +1,170 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace
+{
+    std::atomic<int> gThreadCount{ 0 };
+
+    // Small sequential ids read better in trace viewers than native thread handles
+    int threadId()
+    {
+        thread_local int id = ++gThreadCount;
+        return id;
+    }
+
+    QString threadName(int id)
+    {
+        QThread* thread = QThread::currentThread();
+        if (!thread->objectName().isEmpty()) { return thread->objectName(); }
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) { return "Main"; }
+        return QString("Thread %1").arg(id);
+    }
+}
+
+Tracer& Tracer::instance()
+{
+    // Off until a trace is asked for, so the traced operations don't pay for it otherwise
+    static Tracer tracer(65536, false);
+    return tracer;
+}
+
+Tracer::Tracer(int capacity, bool enabled) : mCapacity(qMax(capacity, 1)), mEnabled(enabled)
+{
+    mClock.start();
+}
+
+void Tracer::begin(const char* category, const char* name)
+{
+    record('B', category, name);
+}
+
+void Tracer::end(const char* category, const char* name)
+{
+    record('E', category, name);
+}
+
+void Tracer::record(char phase, const char* category, const char* name)
+{
+    if (!isEnabled()) { return; }
+
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.phase = phase;
+    event.thread = threadId();
+    event.nsecs = mClock.nsecsElapsed();
+
+    QMutexLocker locker(&mMutex);
+    if (!mThreadNames.contains(event.thread))
+    {
+        mThreadNames.insert(event.thread, threadName(event.thread));
+    }
+
+    if (mEvents.size() < mCapacity)
+    {
+        mEvents.append(event);
+    }
+    else
+    {
+        mEvents[mNextEvent] = event;
+        mNextEvent = (mNextEvent + 1) % mCapacity;
+    }
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mEvents.clear();
+    mNextEvent = 0;
+}
+
+int Tracer::eventCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mEvents.size();
+}
+
+QByteArray Tracer::toChromeTraceJson() const
+{
+    QVector<Event> events;
+    QHash<int, QString> threadNames;
+    {
+        QMutexLocker locker(&mMutex);
+        events = mEvents.mid(mNextEvent) + mEvents.mid(0, mNextEvent);
+        threadNames = mThreadNames;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (auto it = threadNames.cbegin(); it != threadNames.cend(); ++it)
+    {
+        QJsonObject metadata;
+        metadata["ph"] = "M";
+        metadata["name"] = "thread_name";
+        metadata["pid"] = pid;
+        metadata["tid"] = it.key();
+        metadata["args"] = QJsonObject{ { "name", it.value() } };
+        traceEvents.append(metadata);
+    }
+
+    // The oldest events may have been overwritten, leaving ends without their begins
+    QHash<int, int> openScopes;
+    for (const Event& event : events)
+    {
+        int& depth = openScopes[event.thread];
+        if (event.phase == 'E')
+        {
+            if (depth == 0) { continue; }
+            depth--;
+        }
+        else
+        {
+            depth++;
+        }
+
+        QJsonObject traceEvent;
+        traceEvent["ph"] = QString(QChar(event.phase));
+        traceEvent["cat"] = event.category;
+        traceEvent["name"] = event.name;
+        traceEvent["ts"] = event.nsecs / 1000.0;
+        traceEvent["pid"] = pid;
+        traceEvent["tid"] = event.thread;
+        traceEvents.append(traceEvent);
+    }
+
+    QJsonObject json;
+    json["traceEvents"] = traceEvents;
+    json["displayTimeUnit"] = "ms";
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::save(const QString& filePath) const
+{
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly)) { return false; }
+    return file.write(toChromeTraceJson()) >= 0;
+}
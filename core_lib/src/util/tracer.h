@@ -0,0 +1,115 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/**
+ * Records when the slow operations of the editor begin and end, on which thread,
+ * so that a session can be looked at afterwards in a trace viewer such as chrome://tracing or Perfetto.
+ *
+ * Events are kept in a ring buffer, so only the most recent ones are kept and memory stays bounded.
+ * Use TRACE_SCOPE rather than calling begin() and end() directly. The shared instance records
+ * nothing until it is enabled, and while disabled a TRACE_SCOPE costs a single atomic load.
+ * Building with PENCIL2D_NO_TRACE defined removes the tracing altogether.
+ */
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    explicit Tracer(int capacity = 65536, bool enabled = true);
+
+    /** Events are only recorded while enabled */
+    void setEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @param category A string literal grouping related events, e.g. "io"
+     * @param name A string literal naming the operation
+     */
+    void begin(const char* category, const char* name);
+    void end(const char* category, const char* name);
+
+    void clear();
+    int eventCount() const;
+
+    /** The recorded events in the Chrome trace event format, oldest first */
+    QByteArray toChromeTraceJson() const;
+    bool save(const QString& filePath) const;
+
+private:
+    struct Event
+    {
+        const char* category = nullptr;
+        const char* name = nullptr;
+        qint64 nsecs = 0;
+        int thread = 0;
+        char phase = 'B';
+    };
+
+    void record(char phase, const char* category, const char* name);
+
+    const int mCapacity;
+    std::atomic<bool> mEnabled;
+    QElapsedTimer mClock;
+
+    mutable QMutex mMutex;
+    QVector<Event> mEvents;
+    int mNextEvent = 0; // where the next event goes once the buffer is full
+    QHash<int, QString> mThreadNames;
+};
+
+/**
+ * Records a begin event when constructed and the matching end event when destroyed.
+ * Does nothing else when the tracer was disabled on construction, so no end is left without its begin.
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name)
+        : mCategory(category), mName(name), mActive(Tracer::instance().isEnabled())
+    {
+        if (mActive) { Tracer::instance().begin(mCategory, mName); }
+    }
+    ~TraceScope()
+    {
+        if (mActive) { Tracer::instance().end(mCategory, mName); }
+    }
+
+private:
+    const char* mCategory;
+    const char* mName;
+    const bool mActive;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef PENCIL2D_NO_TRACE
+  #define TRACE_SCOPE(category, name) ((void)0)
+#else
+  #define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#endif
+
+#endif // TRACER_H
@@ -152,3 +152,158 @@ TEST_CASE("BitmapBucket - Fill drag behaviour across four segments")
     delete scribbleArea;
     delete editor;
 }
+
+TEST_CASE("BitmapBucket - Fill several frames at once")
+{
+    FileManager fm;
+    Object* obj = fm.load(":/fill-drag-test/fill-drag-test.pcl");
+    Editor* editor = new Editor;
+    ScribbleArea* scribbleArea = new ScribbleArea(nullptr);
+    editor->setScribbleArea(scribbleArea);
+    editor->setObject(obj);
+    editor->init();
+
+    BucketToolProperties properties;
+    QSettings settings;
+
+    QHash<int, PropertyInfo> info;
+
+    info[BucketToolProperties::FILLLAYERREFERENCEMODE_VALUE] = 0;
+    info[BucketToolProperties::FILLEXPAND_ENABLED] = false;
+    info[BucketToolProperties::FILLMODE_VALUE] = 0;
+    info[BucketToolProperties::COLORTOLERANCE_VALUE] = 25;
+    info[BucketToolProperties::COLORTOLERANCE_ENABLED] = true;
+    properties.toolProperties().insertProperties(info);
+    properties.toolProperties().loadFrom("BucketTest", settings);
+
+    LayerBitmap* layer = static_cast<LayerBitmap*>(editor->layers()->currentLayer());
+    BitmapImage* firstImage = layer->getBitmapImageAtFrame(1);
+    layer->addKeyFrame(2, firstImage->clone());
+    layer->addKeyFrame(3, firstImage->clone());
+
+    QRect bounds = firstImage->bounds();
+    QPoint pressPoint = bounds.topLeft() + QPoint(3, 7);
+    QColor fillColor = QColor(0, 255, 0, 255);
+
+    BitmapBucket bucket = BitmapBucket(editor, fillColor, bounds, pressPoint, properties);
+
+    SECTION("Every frame is filled")
+    {
+        int fillCount = 0;
+        int filled = bucket.paintFrames(pressPoint, { 1, 2, 3 }, [&fillCount](BucketState state, int, int) {
+            if (state == BucketState::DidFillTarget) {
+                fillCount++;
+            }
+        }, [](int, int) { return true; });
+
+        REQUIRE(filled == 3);
+        REQUIRE(fillCount == 3);
+        for (int frame = 1; frame <= 3; frame++)
+        {
+            verifyOnlyPixelsInsideSegmentsAreFilled(pressPoint, layer->getBitmapImageAtFrame(frame), fillColor.rgba());
+        }
+    }
+
+    SECTION("Cancelling leaves every frame untouched")
+    {
+        int filled = bucket.paintFrames(pressPoint, { 1, 2, 3 }, [](BucketState, int, int) {
+            FAIL("No frame should be filled");
+        }, [](int, int) { return false; });
+
+        REQUIRE(filled == 0);
+        for (int frame = 1; frame <= 3; frame++)
+        {
+            REQUIRE(layer->getBitmapImageAtFrame(frame)->constScanLine(pressPoint.x(), pressPoint.y()) == 0);
+        }
+    }
+
+    SECTION("Frames that don't reach the press point are skipped")
+    {
+        // Without a camera rect, only the frames that cover the press point can be filled
+        layer->addKeyFrame(4, new BitmapImage(QRect(bounds.bottomRight() + QPoint(50, 50), QSize(4, 4)), Qt::black));
+        layer->addKeyFrame(5, new BitmapImage);
+        BitmapBucket noCameraBucket = BitmapBucket(editor, fillColor, QRect(), pressPoint, properties);
+
+        QList<int> filledFrames;
+        int filled = noCameraBucket.paintFrames(pressPoint, { 1, 4, 5 }, [&filledFrames](BucketState state, int, int frame) {
+            if (state == BucketState::DidFillTarget) {
+                filledFrames.append(frame);
+            }
+        }, [](int, int) { return true; });
+
+        REQUIRE(filled == 1);
+        REQUIRE(filledFrames == QList<int>({ 1 }));
+        verifyOnlyPixelsInsideSegmentsAreFilled(pressPoint, layer->getBitmapImageAtFrame(1), fillColor.rgba());
+        REQUIRE(layer->getBitmapImageAtFrame(4)->bounds().size() == QSize(4, 4));
+        REQUIRE(layer->getBitmapImageAtFrame(5)->bounds().isEmpty());
+    }
+
+    delete scribbleArea;
+    delete editor;
+}
+
+TEST_CASE("BitmapBucketCache")
+{
+    FileManager fm;
+    Object* obj = fm.load(":/fill-drag-test/fill-drag-test.pcl");
+    Editor* editor = new Editor;
+    ScribbleArea* scribbleArea = new ScribbleArea(nullptr);
+    editor->setScribbleArea(scribbleArea);
+    editor->setObject(obj);
+    editor->init();
+
+    BitmapBucketCache cache;
+    const int layerIndex = editor->currentLayerIndex();
+    LayerBitmap* layer = static_cast<LayerBitmap*>(editor->layers()->currentLayer());
+
+    SECTION("The composite is reused until a layer changes")
+    {
+        BitmapImage first = cache.flattenedImage(editor, 1, layerIndex);
+        BitmapImage second = cache.flattenedImage(editor, 1, layerIndex);
+        REQUIRE(first.image()->cacheKey() == second.image()->cacheKey());
+
+        BitmapImage* image = layer->getBitmapImageAtFrame(1);
+        QPoint point = image->bounds().topLeft() + QPoint(3, 7);
+        image->setPixel(point, qRgba(255, 0, 0, 255));
+
+        BitmapImage third = cache.flattenedImage(editor, 1, layerIndex);
+        REQUIRE(third.image()->cacheKey() != first.image()->cacheKey());
+        REQUIRE(third.constScanLine(point.x(), point.y()) == qRgba(255, 0, 0, 255));
+    }
+
+    SECTION("The mask marks the pixels matching the color")
+    {
+        BitmapImage reference = *layer->getBitmapImageAtFrame(1);
+        QRect bounds = reference.bounds();
+        QBitArray mask = cache.matchMask(reference, 0, 0);
+
+        REQUIRE(mask.size() == bounds.width() * bounds.height());
+        for (int y = bounds.top(); y <= bounds.bottom(); y++)
+        {
+            for (int x = bounds.left(); x <= bounds.right(); x++)
+            {
+                bool bit = mask.testBit((y - bounds.top()) * bounds.width() + x - bounds.left());
+                REQUIRE(bit == (reference.constScanLine(x, y) == 0));
+            }
+        }
+    }
+
+    SECTION("The mask is carried over a fill of the reference")
+    {
+        BitmapImage reference = *layer->getBitmapImageAtFrame(1);
+        QRect bounds = reference.bounds();
+        cache.matchMask(reference, 0, 0);
+
+        const qint64 previousKey = reference.image()->cacheKey();
+        QPoint point = bounds.topLeft() + QPoint(3, 7);
+        reference.setPixel(point, qRgba(255, 0, 0, 255));
+        cache.updateMask(previousKey, reference, QRect(point, QSize(1, 1)));
+
+        BitmapBucketCache fresh;
+        REQUIRE(cache.matchMask(reference, 0, 0) == fresh.matchMask(reference, 0, 0));
+        REQUIRE_FALSE(cache.matchMask(reference, 0, 0).testBit(7 * bounds.width() + 3));
+    }
+
+    delete scribbleArea;
+    delete editor;
+}
@@ -16,8 +16,10 @@ GNU General Public License for more details.
 #include "catch.hpp"
 
 #include "bitmapimage.h"
+#include "bitmapcodec.h"
 #include <QElapsedTimer>
 #include <QDebug>
+#include <QTemporaryDir>
 
 TEST_CASE("BitmapImage constructors")
 {
@@ -437,3 +439,122 @@ TEST_CASE("BitmapImage autoCrop performance")
         REQUIRE(b->height() == 901);
     }
 }
+
+TEST_CASE("BitmapImage revision")
+{
+    BitmapImage b(QRect(0, 0, 10, 10), Qt::red);
+    const quint64 revision = b.revision();
+
+    SECTION("Changes on modification")
+    {
+        b.setPixel(1, 1, qRgba(0, 255, 0, 255));
+        REQUIRE(b.revision() != revision);
+    }
+
+    SECTION("Copies get a revision of their own")
+    {
+        BitmapImage copy(b);
+        REQUIRE(copy.revision() != revision);
+    }
+}
+
+TEST_CASE("BitmapImage mipmap")
+{
+    BitmapImage b(QRect(0, 0, 100, 60), Qt::red);
+
+    SECTION("Full image when not zoomed out far enough")
+    {
+        REQUIRE(&b.mipmap(1.0) == b.image());
+        REQUIRE(&b.mipmap(0.6) == b.image());
+    }
+
+    SECTION("Smallest level that still covers the screen")
+    {
+        REQUIRE(b.mipmap(0.5).size() == QSize(50, 30));
+        REQUIRE(b.mipmap(0.3).size() == QSize(50, 30));
+        REQUIRE(b.mipmap(0.25).size() == QSize(25, 15));
+        REQUIRE(b.mipmap(0.1).size() == QSize(13, 8));
+        REQUIRE(b.mipmap(0.1).pixel(3, 3) == qRgba(255, 0, 0, 255));
+    }
+
+    SECTION("Levels average the pixels and follow modifications")
+    {
+        BitmapImage line(QRect(0, 0, 2, 1), Qt::black);
+        REQUIRE(line.mipmap(0.5).pixel(0, 0) == qRgba(0, 0, 0, 255));
+
+        line.setPixel(1, 0, qRgba(255, 255, 255, 255));
+        REQUIRE(line.mipmap(0.5).pixel(0, 0) == qRgba(128, 128, 128, 255));
+    }
+
+    SECTION("Levels don't change the memory usage the frame pool counted")
+    {
+        const quint64 bytes = b.memoryUsage();
+        b.mipmap(0.1);
+        REQUIRE(b.memoryUsage() == bytes);
+    }
+}
+
+TEST_CASE("BitmapCodec")
+{
+    // Transparent space, a long flat run, gradients and semi-transparent edges
+    QImage image(97, 31, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    for (int y = 0; y < image.height(); y++)
+    {
+        for (int x = 0; x < image.width(); x++)
+        {
+            if (x > 70) {
+                image.setPixel(x, y, qRgba(0, 0, 0, 255));
+            } else if ((x + y) % 5 == 0) {
+                const int alpha = (x * 7 + y * 3) % 256;
+                image.setPixel(x, y, qPremultiply(qRgba(x * 3, 255 - y, (x * y) % 256, alpha)));
+            } else if (y > 20) {
+                image.setPixel(x, y, qRgba(x, x + 1, x + 2, 255));
+            }
+        }
+    }
+
+    SECTION("Round trip is lossless")
+    {
+        QByteArray data = BitmapCodec::encode(image, QPoint(-12, 40));
+        REQUIRE(BitmapCodec::isEncoded(data));
+        REQUIRE(data.size() < image.width() * image.height() * 4);
+
+        QRect bounds;
+        QImage decoded = BitmapCodec::decode(data, &bounds);
+        REQUIRE(decoded.format() == QImage::Format_ARGB32_Premultiplied);
+        REQUIRE(bounds == QRect(-12, 40, 97, 31));
+        REQUIRE(decoded == image);
+    }
+
+    SECTION("Truncated data is rejected")
+    {
+        QByteArray data = BitmapCodec::encode(image, QPoint(0, 0));
+        REQUIRE(BitmapCodec::decode(data.left(data.size() / 2)).isNull());
+        REQUIRE(BitmapCodec::decode(data.left(BitmapCodec::HEADER_SIZE - 1)).isNull());
+        REQUIRE_FALSE(BitmapCodec::isEncoded(QByteArray("\x89PNG")));
+    }
+
+    SECTION("BitmapImage reads both formats")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+
+        BitmapImage b(QPoint(5, 6), image);
+        for (const QString& format : { QString("PBI"), QString("PNG") })
+        {
+            const QString path = dir.filePath("001.001." + format.toLower());
+            REQUIRE(b.writeFile(path, format).ok());
+
+            BitmapImage loaded(QPoint(5, 6), path);
+            REQUIRE_FALSE(loaded.isLoaded());
+            REQUIRE(*loaded.image() == image);
+            REQUIRE(loaded.bounds() == QRect(5, 6, 97, 31));
+        }
+
+        QRect bounds;
+        REQUIRE(BitmapCodec::readBounds(dir.filePath("001.001.pbi"), bounds));
+        REQUIRE(bounds == QRect(5, 6, 97, 31));
+        REQUIRE_FALSE(BitmapCodec::readBounds(dir.filePath("001.001.png"), bounds));
+    }
+}
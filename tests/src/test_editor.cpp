@@ -0,0 +1,65 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "editor.h"
+#include "layercamera.h"
+#include "layermanager.h"
+#include "object.h"
+#include "pencildef.h"
+
+TEST_CASE("Editor without a canvas")
+{
+    // The command line exporter runs the editor and its managers without a ScribbleArea
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString projectPath = dir.filePath("camera-path-test.pclx");
+    REQUIRE(QFile::copy(":/camera-path-test.pclx", projectPath));
+
+    Editor* editor = new Editor;
+    REQUIRE(editor->init());
+    REQUIRE(editor->getScribbleArea() == nullptr);
+    REQUIRE(editor->openObject(projectPath, [](int){}, [](int){}).ok());
+
+    SECTION("Canvas updates are skipped")
+    {
+        editor->scrubTo(3);
+        editor->updateFrame();
+        editor->setLayerVisibility(LayerVisibility::CURRENTONLY);
+        REQUIRE(editor->layerVisibility() == LayerVisibility::ALL);
+        editor->switchVisibilityOfLayer(0);
+        REQUIRE(editor->currentFrame() == 3);
+    }
+
+    SECTION("Frames are exported")
+    {
+        const LayerCamera* cameraLayer = static_cast<LayerCamera*>(editor->layers()->getLastCameraLayer());
+        REQUIRE(cameraLayer);
+
+        QDir outDir(dir.filePath("out"));
+        REQUIRE(outDir.mkpath("."));
+        Status st = editor->object()->exportFrames(1, 2, cameraLayer, cameraLayer->getViewRect().size(),
+                                                   outDir.filePath("frame.png"), "PNG",
+                                                   false, false, "", true, nullptr, 0);
+        REQUIRE(st.ok());
+        REQUIRE(outDir.entryList(QStringList("*.png"), QDir::Files).size() == 2);
+    }
+    delete editor;
+}
@@ -15,9 +15,12 @@ GNU General Public License for more details.
 */
 #include "catch.hpp"
 
+#include <QFileInfo>
+#include <QSemaphore>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QImage>
+#include <QThreadPool>
 #include "qminiz.h"
 #include "fileformat.h"
 #include "filemanager.h"
@@ -399,6 +402,116 @@ TEST_CASE("FileManager File-saving")
         }
         delete o3;
     }
+
+    SECTION("Keyframes of several layers are written concurrently")
+    {
+        FileManager fm;
+
+        Object* o1 = new Object;
+        o1->init();
+        o1->addNewCameraLayer();
+        o1->addNewBitmapLayer();
+        o1->addNewBitmapLayer();
+        o1->setFastBitmapKeyFrames(true);
+
+        for (int l = 1; l <= 2; ++l)
+        {
+            LayerBitmap* layer = static_cast<LayerBitmap*>(o1->getLayer(l));
+            for (int i = 1; i <= 60; ++i)
+            {
+                layer->addNewKeyFrameAt(i);
+                layer->getBitmapImageAtFrame(i)->drawRect(QRectF(i, l, 10, 10), QPen(QColor(i, l, 0)), QBrush(QColor(i, l, 0)), QPainter::CompositionMode_SourceOver, false);
+            }
+        }
+
+        QTemporaryDir testDir("PENCIL_TEST_XXXXXXXX");
+        QString animationPath = testDir.path() + "/abc.pclx";
+        REQUIRE(fm.save(o1, animationPath).ok());
+
+        QMap<int, QRect> savedBounds;
+        for (int l = 1; l <= 2; ++l)
+        {
+            LayerBitmap* layer = static_cast<LayerBitmap*>(o1->getLayer(l));
+            for (int i = 1; i <= 60; ++i)
+            {
+                BitmapImage* bitmap = layer->getBitmapImageAtFrame(i);
+                REQUIRE_FALSE(bitmap->isModified());
+                REQUIRE(QFileInfo(bitmap->fileName()).fileName() == QString::asprintf("%03d.%03d.pbi", layer->id(), i));
+                savedBounds[l * 1000 + i] = bitmap->bounds();
+            }
+        }
+        delete o1;
+
+        Object* o2 = fm.load(animationPath);
+        REQUIRE(o2 != nullptr);
+        for (int l = 1; l <= 2; ++l)
+        {
+            LayerBitmap* layer = static_cast<LayerBitmap*>(o2->getLayer(l));
+            REQUIRE(layer->keyFrameCount() == 60);
+            for (int i = 1; i <= 60; ++i)
+            {
+                BitmapImage* bitmap = layer->getBitmapImageAtFrame(i);
+                REQUIRE(bitmap->bounds() == savedBounds[l * 1000 + i]);
+                REQUIRE(bitmap->pixel(QPoint(i + 5, l + 5)) == qRgba(i, l, 0, 255));
+            }
+        }
+        delete o2;
+    }
+
+    SECTION("Keyframes changed while their files are written are saved as queued")
+    {
+        Object* o1 = new Object;
+        o1->init();
+        LayerBitmap* layer = o1->addNewBitmapLayer();
+        BitmapImage* bitmap = layer->getBitmapImageAtFrame(1);
+        bitmap->drawRect(QRectF(0, 0, 10, 10), QPen(Qt::red), QBrush(Qt::red), QPainter::CompositionMode_SourceOver, false);
+
+        QTemporaryDir dataDir("PENCIL_TEST_XXXXXXXX");
+        QThreadPool pool;
+        pool.setMaxThreadCount(1);
+        QSemaphore started;
+        QSemaphore release;
+        // Holds the only thread, so that the keyframe changes before its file is written
+        pool.start([&started, &release] { started.release(); release.acquire(); });
+        started.acquire();
+
+        std::atomic<int> writtenCount(0);
+        REQUIRE(layer->queueKeyFrameWrites(dataDir.path(), pool, writtenCount) == 1);
+        bitmap->drawRect(QRectF(0, 0, 10, 10), QPen(Qt::blue), QBrush(Qt::blue), QPainter::CompositionMode_SourceOver, false);
+        release.release();
+        pool.waitForDone();
+
+        QStringList files;
+        REQUIRE(layer->finishSave(dataDir.path(), files, [] {}).ok());
+        REQUIRE(files.size() == 1);
+        REQUIRE(QImage(files[0]).pixel(5, 5) == qRgb(255, 0, 0));
+        REQUIRE(bitmap->isModified());
+        delete o1;
+    }
+
+    SECTION("Keyframes saved in the other format don't leave their previous file behind")
+    {
+        Object* o1 = new Object;
+        o1->init();
+        LayerBitmap* layer = o1->addNewBitmapLayer();
+        BitmapImage* bitmap = layer->getBitmapImageAtFrame(1);
+        bitmap->drawRect(QRectF(0, 0, 10, 10), QPen(Qt::red), QBrush(Qt::red), QPainter::CompositionMode_SourceOver, false);
+
+        QTemporaryDir dataDir("PENCIL_TEST_XXXXXXXX");
+        QStringList files;
+        REQUIRE(layer->save(dataDir.path(), files, [] {}).ok());
+        const QString pngFile = bitmap->fileName();
+        REQUIRE(QFileInfo(pngFile).suffix() == "png");
+
+        layer->setFastKeyFrames(true);
+        bitmap->drawRect(QRectF(0, 0, 10, 10), QPen(Qt::blue), QBrush(Qt::blue), QPainter::CompositionMode_SourceOver, false);
+        files.clear();
+        REQUIRE(layer->save(dataDir.path(), files, [] {}).ok());
+        REQUIRE(QFileInfo(bitmap->fileName()).suffix() == "pbi");
+        REQUIRE(QFile::exists(bitmap->fileName()));
+        REQUIRE_FALSE(QFile::exists(pngFile));
+        delete o1;
+    }
 }
 
 TEST_CASE("Empty Sound Frames")
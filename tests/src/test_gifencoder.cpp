@@ -0,0 +1,112 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "gifencoder.h"
+
+#include <QFile>
+#include <QImageReader>
+#include <QTemporaryDir>
+
+TEST_CASE("GifEncoder::buildPalette")
+{
+    QImage image(4, 4, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    image.setPixel(0, 0, qRgb(255, 0, 0));
+    image.setPixel(1, 0, qRgb(0, 0, 255));
+
+    SECTION("Each distinct color gets an entry")
+    {
+        QVector<QRgb> palette = GifEncoder::buildPalette({ image });
+        REQUIRE(palette.size() == 3);
+        REQUIRE(palette.contains(qRgb(255, 255, 255)));
+        REQUIRE(palette.contains(qRgb(255, 0, 0)));
+        REQUIRE(palette.contains(qRgb(0, 0, 255)));
+    }
+
+    SECTION("Palette size is limited")
+    {
+        QVector<QRgb> palette = GifEncoder::buildPalette({ image }, 2);
+        REQUIRE(palette.size() == 2);
+    }
+}
+
+TEST_CASE("GifEncoder writes readable animations")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("test.gif");
+
+    QImage first(32, 32, QImage::Format_RGB32);
+    first.fill(Qt::white);
+    QImage second = first.copy();
+    second.setPixel(10, 12, qRgb(255, 0, 0));
+
+    GifEncoder encoder;
+    REQUIRE(encoder.open(filePath, first.size(), GifEncoder::buildPalette({ first, second }), true).ok());
+    REQUIRE(encoder.addFrame(first, 8).ok());
+    REQUIRE(encoder.addFrame(first, 8).ok()); // held, merged into the previous frame
+    REQUIRE(encoder.addFrame(second, 9).ok());
+    REQUIRE(encoder.close().ok());
+
+    if (!QImageReader::supportedImageFormats().contains("gif"))
+    {
+        WARN("No gif image reader, skipping decode checks");
+        return;
+    }
+
+    QImageReader reader(filePath);
+    REQUIRE(reader.supportsAnimation());
+    REQUIRE(reader.imageCount() == 2);
+
+    QImage decoded = reader.read();
+    REQUIRE(decoded.pixel(10, 12) == qRgb(255, 255, 255));
+    REQUIRE(reader.nextImageDelay() == 160);
+
+    decoded = reader.read();
+    REQUIRE(decoded.size() == first.size());
+    REQUIRE(decoded.pixel(10, 12) == qRgb(255, 0, 0));
+    REQUIRE(decoded.pixel(0, 0) == qRgb(255, 255, 255));
+}
+
+TEST_CASE("GifEncoder leaves no file behind when cancelled")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("test.gif");
+
+    QImage frame(32, 32, QImage::Format_RGB32);
+    frame.fill(Qt::white);
+
+    SECTION("Cancelled before closing")
+    {
+        GifEncoder encoder;
+        REQUIRE(encoder.open(filePath, frame.size(), GifEncoder::buildPalette({ frame }), true).ok());
+        REQUIRE(encoder.addFrame(frame, 8).ok());
+        encoder.cancel();
+        REQUIRE_FALSE(QFile::exists(filePath));
+    }
+
+    SECTION("Destroyed before closing")
+    {
+        {
+            GifEncoder encoder;
+            REQUIRE(encoder.open(filePath, frame.size(), GifEncoder::buildPalette({ frame }), true).ok());
+            REQUIRE(encoder.addFrame(frame, 8).ok());
+        }
+        REQUIRE_FALSE(QFile::exists(filePath));
+    }
+}
@@ -322,6 +322,46 @@ TEST_CASE("Layer::getNextKeyFramePosition()")
     delete obj;
 }
 
+TEST_CASE("Layer::foreachKeyFrameInRange()")
+{
+    Object* obj = new Object;
+    SECTION("KeyFrame 1, 5, 10, 20")
+    {
+        Layer* layer = obj->addNewBitmapLayer();
+        CHECK(layer->addNewKeyFrameAt(5));
+        CHECK(layer->addNewKeyFrameAt(10));
+        CHECK(layer->addNewKeyFrameAt(20));
+
+        auto keysInRange = [layer](int first, int last)
+        {
+            std::vector<int> positions;
+            layer->foreachKeyFrameInRange(first, last, [&](KeyFrame* key) { positions.push_back(key->pos()); });
+            return positions;
+        };
+
+        REQUIRE(keysInRange(6, 12) == std::vector<int>{ 10 });
+        REQUIRE(keysInRange(1, 100) == std::vector<int>{ 20, 10, 5, 1 });
+        REQUIRE(keysInRange(20, 20) == std::vector<int>{ 20 });
+        REQUIRE(keysInRange(21, 30).empty());
+
+        layer->getKeyFrameAt(5)->setLength(3);
+        REQUIRE(keysInRange(6, 12) == std::vector<int>{ 10, 5 });
+    }
+    SECTION("A long sound clip before a short one")
+    {
+        Layer* layer = obj->addNewSoundLayer();
+        CHECK(layer->addNewKeyFrameAt(1));
+        CHECK(layer->addNewKeyFrameAt(10));
+        layer->getKeyFrameAt(1)->setLength(50);
+        layer->getKeyFrameAt(10)->setLength(5);
+
+        std::vector<int> positions;
+        layer->foreachKeyFrameInRange(20, 30, [&](KeyFrame* key) { positions.push_back(key->pos()); });
+        REQUIRE(positions == std::vector<int>{ 1 });
+    }
+    delete obj;
+}
+
 TEST_CASE("Layer::getPreviousFrameNumber()")
 {
     Object* obj = new Object;
@@ -443,6 +483,44 @@ TEST_CASE("Layer::moveKeyFrame(int position, int offset)")
     delete obj;
 }
 
+TEST_CASE("Layer::moveSelectedFrames(int offset)")
+{
+    Object* obj = new Object;
+    SECTION("move every other frame of a long layer")
+    {
+        Layer* layer = obj->addNewBitmapLayer();
+        for (int i = 2; i <= 2000; i++)
+        {
+            layer->addNewKeyFrameAt(i * 2);
+        }
+        std::vector<KeyFrame*> keys;
+        for (int i = 1000; i <= 2000; i++)
+        {
+            keys.push_back(layer->getKeyFrameAt(i * 2));
+            layer->setFrameSelected(i * 2, true);
+        }
+
+        REQUIRE(layer->moveSelectedFrames(1));
+
+        REQUIRE(layer->keyFrameCount() == 2000);
+        REQUIRE(layer->selectedKeyFrameCount() == 1001);
+        REQUIRE(layer->getSelectedFramesByPos().first() == 2001);
+        REQUIRE(layer->getSelectedFramesByPos().last() == 4001);
+        REQUIRE(layer->getMaxKeyFramePosition() == 4001);
+        REQUIRE(layer->getNextKeyFramePosition(1998) == 2001);
+        for (int i = 1000; i <= 2000; i++)
+        {
+            KeyFrame* key = keys[static_cast<size_t>(i - 1000)];
+            REQUIRE(layer->getKeyFrameAt(i * 2 + 1) == key);
+            REQUIRE(key->pos() == i * 2 + 1);
+            REQUIRE(layer->isFrameSelected(i * 2 + 1));
+            REQUIRE_FALSE(layer->keyExists(i * 2));
+        }
+        REQUIRE_FALSE(layer->isFrameSelected(1998));
+    }
+    delete obj;
+}
+
 TEST_CASE("Layer::setExposureForSelectedFrames")
 {
     Object* obj = new Object;
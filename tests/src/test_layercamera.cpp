@@ -213,6 +213,73 @@ SCENARIO("When adding a keyframe in-between two othes where the control points h
     }
 }
 
+SCENARIO("Interpolated camera views follow edits to the keyframes")
+{
+    GIVEN("A Camera layer with two keyframes")
+    {
+        Layer* layer = new LayerCamera(1);
+        LayerCamera* camLayer = static_cast<LayerCamera*>(layer);
+
+        layer->addNewKeyFrameAt(1);
+        layer->addNewKeyFrameAt(5);
+        Camera* cameraLast = camLayer->getCameraAtFrame(5);
+        cameraLast->translate(400, 0);
+
+        REQUIRE(camLayer->getViewAtFrame(3).dx() == Approx(200));
+        REQUIRE(camLayer->getInterpolatedPath(1).size() == 5);
+
+        WHEN("Moving the last camera after the view has been interpolated")
+        {
+            cameraLast->translate(800, 0);
+            THEN("The interpolated view is updated")
+            {
+                REQUIRE(camLayer->getViewAtFrame(3).dx() == Approx(400));
+                REQUIRE(camLayer->getInterpolatedPath(1).at(2).x() == Approx(-400));
+            }
+        }
+
+        WHEN("Changing the easing of the first camera")
+        {
+            camLayer->setCameraEasingAtFrame(CameraEasingType::INQUAD, 1);
+            THEN("The interpolated view is updated")
+            {
+                REQUIRE(camLayer->getViewAtFrame(3).dx() == Approx(100));
+            }
+        }
+
+        WHEN("Moving the control point of the first camera")
+        {
+            camLayer->updatePathControlPointAtFrame(QPointF(-200, -200), 1);
+            THEN("The interpolated view follows the curve")
+            {
+                REQUIRE(camLayer->getViewAtFrame(3).dy() == Approx(100));
+            }
+        }
+
+        WHEN("Replacing the last keyframe with one further along the timeline")
+        {
+            layer->addNewKeyFrameAt(9);
+            layer->removeKeyFrame(5);
+            THEN("The interpolation spans the new range")
+            {
+                REQUIRE(camLayer->getViewAtFrame(5).dx() == Approx(200));
+                REQUIRE(camLayer->getInterpolatedPath(1).size() == 9);
+            }
+        }
+
+        WHEN("Moving the last keyframe further along the timeline")
+        {
+            REQUIRE(layer->moveKeyFrame(5, 4));
+            THEN("The interpolation spans the new range")
+            {
+                REQUIRE(camLayer->getViewAtFrame(5).dx() == Approx(200));
+                REQUIRE(camLayer->getInterpolatedPath(1).size() == 9);
+            }
+        }
+        delete layer;
+    }
+}
+
 SCENARIO("Loading a project and see that all camera properties are set, if applicable")
 {
     FileManager fileMan;
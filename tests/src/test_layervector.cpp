@@ -25,6 +25,7 @@ GNU General Public License for more details.
 #include <QDomElement>
 #include <QTemporaryDir>
 #include <QTextStream>
+#include <QXmlStreamReader>
 
 TEST_CASE("Load vector layer from XML")
 {
@@ -123,3 +124,82 @@ TEST_CASE("Load vector layer from XML")
         REQUIRE(closestCanonicalPath(frame->fileName()) == closestCanonicalPath(dataDir.filePath("subdir/001.001.vec")));
     }
 }
+
+TEST_CASE("Load vector layer from XML stream")
+{
+    std::unique_ptr<Layer> vectorLayer(new LayerVector(1));
+    QTemporaryDir dataDir;
+    REQUIRE(dataDir.isValid());
+    ProgressCallback nullCallback = []() {};
+
+    auto writeVecFile = [&dataDir](QString name)
+    {
+        QFile vecFile(dataDir.filePath(name));
+        vecFile.open(QIODevice::WriteOnly);
+        QTextStream fout(&vecFile);
+        fout << "<!DOCTYPE PencilVectorImage>";
+        fout << "<image type='vector'/>";
+    };
+
+    auto loadLayer = [&](QString xml)
+    {
+        QXmlStreamReader xmlStream(xml);
+        REQUIRE(xmlStream.readNextStartElement());
+        vectorLayer->loadXmlStream(xmlStream, dataDir.path(), nullCallback);
+        REQUIRE_FALSE(xmlStream.hasError());
+    };
+
+    SECTION("Layer attributes")
+    {
+        loadLayer("<layer id='7' name='Lines' visibility='0'></layer>");
+
+        REQUIRE(vectorLayer->id() == 7);
+        REQUIRE(vectorLayer->name() == "Lines");
+        REQUIRE(vectorLayer->visible() == false);
+        REQUIRE(vectorLayer->keyFrameCount() == 0);
+    }
+
+    SECTION("Many frames are parsed concurrently")
+    {
+        QString xml = "<layer id='1' name='Vector Layer' visibility='1'>";
+        for (int i = 1; i <= 32; i++)
+        {
+            QString name = QString::asprintf("001.%03d.vec", i);
+            writeVecFile(name);
+            xml += QString("<image frame='%1' src='%2' opacity='0.5'/>").arg(i).arg(name);
+        }
+        xml += "</layer>";
+
+        loadLayer(xml);
+
+        REQUIRE(vectorLayer->keyFrameCount() == 32);
+        for (int i = 1; i <= 32; i++)
+        {
+            VectorImage* frame = static_cast<VectorImage*>(vectorLayer->getKeyFrameAt(i));
+            REQUIRE(frame != nullptr);
+            REQUIRE(frame->getOpacity() == 0.5);
+            REQUIRE(closestCanonicalPath(frame->fileName()) == closestCanonicalPath(dataDir.filePath(QString::asprintf("001.%03d.vec", i))));
+        }
+    }
+
+    SECTION("Inline vector data")
+    {
+        loadLayer("<layer id='1' name='Vector Layer' visibility='1'>"
+                  "<image frame='3'><curve width='2' colourNumber='1' originX='0' originY='0' originPressure='1'>"
+                  "<segment c1x='1' c1y='1' c2x='2' c2y='2' vx='3' vy='3' pressure='1'/>"
+                  "</curve></image></layer>");
+
+        REQUIRE(vectorLayer->keyFrameCount() == 1);
+        VectorImage* frame = static_cast<VectorImage*>(vectorLayer->getKeyFrameAt(3));
+        REQUIRE(frame != nullptr);
+        REQUIRE(frame->getCurveSize(0) == 1);
+        REQUIRE(frame->getVertex(0, 0) == QPointF(3, 3));
+    }
+
+    SECTION("Frame src outside of data dir")
+    {
+        loadLayer("<layer id='1' name='Vector Layer' visibility='1'><image frame='1' src='../001.001.vec'/></layer>");
+
+        REQUIRE(vectorLayer->keyFrameCount() == 0);
+    }
+}
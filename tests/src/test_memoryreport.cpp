@@ -0,0 +1,77 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "memoryreport.h"
+#include "bitmapimage.h"
+#include "vectorimage.h"
+
+#include <QJsonArray>
+
+TEST_CASE("MemoryReport::add")
+{
+    MemoryReport report;
+    REQUIRE(report.totalBytes() == 0);
+
+    report.add(MemoryReport::BITMAP_KEYFRAMES, 100);
+    report.add(MemoryReport::BITMAP_KEYFRAMES, 50);
+    report.add(MemoryReport::AUDIO, 10, 0);
+
+    REQUIRE(report.bytes(MemoryReport::BITMAP_KEYFRAMES) == 150);
+    REQUIRE(report.items(MemoryReport::BITMAP_KEYFRAMES) == 2);
+    REQUIRE(report.items(MemoryReport::AUDIO) == 0);
+    REQUIRE(report.totalBytes() == 160);
+}
+
+TEST_CASE("MemoryReport::toJson")
+{
+    MemoryReport report;
+    report.add(MemoryReport::UNDO_STACK, 1024, 3);
+    report.setFramePool(2048, 4096);
+
+    QJsonObject json = report.toJson();
+    REQUIRE(json["total_bytes"].toInt() == 1024);
+    REQUIRE(json["frame_pool"].toObject()["used_bytes"].toInt() == 2048);
+    REQUIRE(json["frame_pool"].toObject()["budget_bytes"].toInt() == 4096);
+
+    QJsonArray categories = json["categories"].toArray();
+    REQUIRE(categories.size() == MemoryReport::CATEGORY_COUNT);
+
+    QJsonObject undo = categories[MemoryReport::UNDO_STACK].toObject();
+    REQUIRE(undo["id"].toString() == "undo_stack");
+    REQUIRE(undo["bytes"].toInt() == 1024);
+    REQUIRE(undo["items"].toInt() == 3);
+}
+
+TEST_CASE("KeyFrame::memoryUsage")
+{
+    SECTION("Bitmap images count their pixels")
+    {
+        BitmapImage image(QRect(0, 0, 10, 20), Qt::red);
+        REQUIRE(image.memoryUsage() == 10 * 20 * 4);
+    }
+
+    SECTION("Vector images report their curves but can't be unloaded")
+    {
+        VectorImage image;
+        quint64 emptyUsage = image.totalMemoryUsage();
+
+        BezierCurve curve({ QPointF(0, 0), QPointF(10, 10), QPointF(20, 0) }, false);
+        image.addCurve(curve, 1.0, false);
+        REQUIRE(image.totalMemoryUsage() > emptyUsage);
+        REQUIRE(image.memoryUsage() == 0);
+    }
+}
@@ -21,11 +21,14 @@ GNU General Public License for more details.
 #include <QFile>
 #include <QFileInfo>
 #include <QTemporaryDir>
+#include <QTextStream>
+#include <QXmlStreamReader>
 #include "filemanager.h"
 #include "object.h"
 #include "layerbitmap.h"
 #include "layervector.h"
 #include "layersound.h"
+#include "vectorimage.h"
 
 
 TEST_CASE("Object::addXXXLayer()")
@@ -259,3 +262,90 @@ void TestObject::testExportColorPalette()
 
 }
 */
+
+TEST_CASE("Object::frameSignature()")
+{
+    Object obj;
+    LayerBitmap* bitmapLayer = obj.addNewBitmapLayer();
+    LayerVector* vectorLayer = obj.addNewVectorLayer();
+    bitmapLayer->addNewKeyFrameAt(1);
+    bitmapLayer->addNewKeyFrameAt(3);
+    vectorLayer->addNewKeyFrameAt(1);
+
+    SECTION("Held drawings have the same signature")
+    {
+        REQUIRE(obj.frameSignature(1, QTransform()) == obj.frameSignature(2, QTransform()));
+        REQUIRE(obj.frameSignature(2, QTransform()) != obj.frameSignature(3, QTransform()));
+    }
+
+    SECTION("Camera movement changes the signature")
+    {
+        REQUIRE(obj.frameSignature(1, QTransform()) != obj.frameSignature(2, QTransform::fromTranslate(10, 0)));
+    }
+
+    SECTION("Opacity changes the signature")
+    {
+        FrameSignature before = obj.frameSignature(1, QTransform());
+        vectorLayer->getVectorImageAtFrame(1)->setOpacity(0.5);
+        REQUIRE(before != obj.frameSignature(1, QTransform()));
+    }
+
+    SECTION("Hidden layers are ignored")
+    {
+        bitmapLayer->setVisible(false);
+        REQUIRE(obj.frameSignature(2, QTransform()) == obj.frameSignature(3, QTransform()));
+    }
+}
+
+TEST_CASE("Object::loadXmlStream() parses the vector layers together")
+{
+    QTemporaryDir dataDir;
+    REQUIRE(dataDir.isValid());
+
+    Object obj;
+    obj.setDataDir(dataDir.path());
+
+    QString xml = "<object>";
+    for (int layerId = 1; layerId <= 3; layerId++)
+    {
+        // A bitmap layer in between must not disturb the vector layers around it
+        if (layerId == 2)
+        {
+            xml += "<layer id='2' name='Bitmap Layer' visibility='1' type='1'></layer>";
+            continue;
+        }
+
+        xml += QString("<layer id='%1' name='Vector Layer %1' visibility='1' type='2'>").arg(layerId);
+        for (int frame = 1; frame <= 8; frame++)
+        {
+            const QString name = QString::asprintf("%03d.%03d.vec", layerId, frame);
+            QFile vecFile(dataDir.filePath(name));
+            REQUIRE(vecFile.open(QIODevice::WriteOnly));
+            QTextStream(&vecFile) << "<!DOCTYPE PencilVectorImage><image type='vector'/>";
+            xml += QString("<image frame='%1' src='%2'/>").arg(frame).arg(name);
+        }
+        xml += "</layer>";
+    }
+    xml += "</object>";
+
+    int progress = 0;
+    QXmlStreamReader xmlStream(xml);
+    REQUIRE(xmlStream.readNextStartElement());
+    REQUIRE(obj.loadXmlStream(xmlStream, [&progress]() { progress++; }));
+
+    REQUIRE(obj.getLayerCount() == 3);
+    REQUIRE(progress == 16);
+    REQUIRE(obj.getLayer(1)->type() == Layer::BITMAP);
+    for (int i : { 0, 2 })
+    {
+        LayerVector* layer = static_cast<LayerVector*>(obj.getLayer(i));
+        REQUIRE(layer->type() == Layer::VECTOR);
+        REQUIRE(layer->keyFrameCount() == 8);
+        for (int frame = 1; frame <= 8; frame++)
+        {
+            VectorImage* image = layer->getVectorImageAtFrame(frame);
+            REQUIRE(image != nullptr);
+            REQUIRE(QFileInfo(image->fileName()).fileName() == QString::asprintf("%03d.%03d.vec", i + 1, frame));
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "renderchunks.h"
+#include "layerbitmap.h"
+#include "layercamera.h"
+#include "object.h"
+
+TEST_CASE("RenderChunks::splitByCount")
+{
+    SECTION("Even split")
+    {
+        QList<RenderChunk> chunks = RenderChunks::splitByCount(1, 12, 3);
+        REQUIRE(chunks.size() == 3);
+        REQUIRE(chunks[0] == RenderChunk{1, 4});
+        REQUIRE(chunks[1] == RenderChunk{5, 8});
+        REQUIRE(chunks[2] == RenderChunk{9, 12});
+    }
+
+    SECTION("Uneven split puts the extra frames in the first chunks")
+    {
+        QList<RenderChunk> chunks = RenderChunks::splitByCount(3, 12, 4);
+        REQUIRE(chunks.size() == 4);
+        REQUIRE(chunks[0] == RenderChunk{3, 5});
+        REQUIRE(chunks[1] == RenderChunk{6, 8});
+        REQUIRE(chunks[2] == RenderChunk{9, 10});
+        REQUIRE(chunks[3] == RenderChunk{11, 12});
+    }
+
+    SECTION("More chunks than frames")
+    {
+        QList<RenderChunk> chunks = RenderChunks::splitByCount(1, 2, 5);
+        REQUIRE(chunks.size() == 2);
+        REQUIRE(chunks[0] == RenderChunk{1, 1});
+        REQUIRE(chunks[1] == RenderChunk{2, 2});
+    }
+
+    SECTION("Empty range")
+    {
+        REQUIRE(RenderChunks::splitByCount(5, 4, 2).isEmpty());
+    }
+}
+
+TEST_CASE("RenderChunks::splitByCost")
+{
+    SECTION("Expensive frames get chunks of their own")
+    {
+        QVector<double> costs{ 10, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+        QList<RenderChunk> chunks = RenderChunks::splitByCost(1, costs, 2);
+        REQUIRE(chunks.size() == 2);
+        REQUIRE(chunks[0] == RenderChunk{1, 1});
+        REQUIRE(chunks[1] == RenderChunk{2, 11});
+    }
+
+    SECTION("Chunks cover the range without gaps")
+    {
+        QVector<double> costs{ 1, 5, 1, 1, 5, 1, 1, 1, 5 };
+        QList<RenderChunk> chunks = RenderChunks::splitByCost(10, costs, 3);
+        REQUIRE(chunks.size() == 3);
+        REQUIRE(chunks.first().startFrame == 10);
+        REQUIRE(chunks.last().endFrame == 18);
+        for (int i = 1; i < chunks.size(); i++)
+        {
+            REQUIRE(chunks[i].startFrame == chunks[i - 1].endFrame + 1);
+            REQUIRE(chunks[i].frameCount() >= 1);
+        }
+    }
+
+    SECTION("Every chunk keeps at least one frame")
+    {
+        QVector<double> costs{ 0, 0, 0, 100 };
+        QList<RenderChunk> chunks = RenderChunks::splitByCost(1, costs, 4);
+        REQUIRE(chunks.size() == 4);
+        for (int i = 0; i < chunks.size(); i++)
+        {
+            REQUIRE(chunks[i] == RenderChunk{i + 1, i + 1});
+        }
+    }
+}
+
+TEST_CASE("RenderChunks::estimateCosts")
+{
+    Object* obj = new Object;
+    obj->init();
+    LayerBitmap* layer = obj->addNewBitmapLayer();
+    layer->addNewKeyFrameAt(4);
+    LayerCamera* camera = obj->addNewCameraLayer();
+
+    QVector<double> costs = RenderChunks::estimateCosts(obj, camera, 1, 6);
+    REQUIRE(costs.size() == 6);
+
+    // Held drawings are cheaper than new ones
+    REQUIRE(costs[1] < costs[0]);
+    REQUIRE(costs[2] == costs[1]);
+    REQUIRE(costs[3] == costs[0]);
+    REQUIRE(costs[4] < costs[3]);
+
+    delete obj;
+}
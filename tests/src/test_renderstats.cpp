@@ -0,0 +1,122 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "renderstats.h"
+
+#include <QJsonArray>
+
+namespace
+{
+    void addPaint(RenderStats& stats, int frame, qint64 layerMsec)
+    {
+        stats.beginPaint(frame);
+        stats.addStageTime(RenderStats::LAYERS, layerMsec * 1000000);
+        stats.endPaint();
+    }
+}
+
+TEST_CASE("RenderStats::percentile")
+{
+    RenderStats stats;
+    REQUIRE(stats.percentile(RenderStats::LAYERS, 50) == 0);
+
+    for (int i = 1; i <= 100; i++)
+    {
+        addPaint(stats, i, i);
+    }
+
+    REQUIRE(stats.sampleCount() == 100);
+    REQUIRE(stats.percentile(RenderStats::LAYERS, 50) == Approx(50));
+    REQUIRE(stats.percentile(RenderStats::LAYERS, 95) == Approx(95));
+    REQUIRE(stats.maximum(RenderStats::LAYERS) == Approx(100));
+    REQUIRE(stats.maximum(RenderStats::ONION_SKIN) == 0);
+}
+
+TEST_CASE("RenderStats keeps the most recent paints")
+{
+    RenderStats stats(4);
+    for (int i = 1; i <= 6; i++)
+    {
+        addPaint(stats, i, i);
+    }
+
+    REQUIRE(stats.sampleCount() == 4);
+    REQUIRE(stats.percentile(RenderStats::LAYERS, 0) == Approx(3));
+
+    QStringList lines = stats.toCsv().trimmed().split('\n');
+    REQUIRE(lines.size() == 5);
+    REQUIRE(lines[0].startsWith("frame,total_ms,prep_ms"));
+    REQUIRE(lines[1].startsWith("3,"));
+    REQUIRE(lines[4].startsWith("6,"));
+}
+
+TEST_CASE("RenderStats::StageTimer")
+{
+    RenderStats stats;
+
+    SECTION("Stages are only recorded during a paint")
+    {
+        {
+            RenderStats::StageTimer timer(&stats, RenderStats::PREP);
+        }
+        REQUIRE(stats.sampleCount() == 0);
+    }
+
+    SECTION("Nested stages are not counted twice")
+    {
+        stats.beginPaint(1);
+        {
+            RenderStats::StageTimer layers(&stats, RenderStats::LAYERS);
+            RenderStats::StageTimer onionSkin(&stats, RenderStats::ONION_SKIN);
+            stats.addStageTime(RenderStats::ONION_SKIN, 10 * 1000000);
+        }
+        stats.endPaint();
+
+        REQUIRE(stats.maximum(RenderStats::ONION_SKIN) >= 10);
+        REQUIRE(stats.maximum(RenderStats::LAYERS) < 10);
+        REQUIRE(stats.totalMaximum() >= stats.maximum(RenderStats::ONION_SKIN));
+    }
+
+    SECTION("A null RenderStats is ignored")
+    {
+        RenderStats::StageTimer timer(nullptr, RenderStats::PREP);
+    }
+}
+
+TEST_CASE("RenderStats cache counters")
+{
+    RenderStats stats;
+    stats.countCache(RenderStats::FRAME_CACHE, true);
+    stats.countCache(RenderStats::FRAME_CACHE, true);
+    stats.countCache(RenderStats::FRAME_CACHE, false);
+    stats.countCache(RenderStats::ONION_SKIN_CACHE, false);
+    addPaint(stats, 1, 2);
+
+    REQUIRE(stats.hits(RenderStats::FRAME_CACHE) == 2);
+    REQUIRE(stats.misses(RenderStats::FRAME_CACHE) == 1);
+
+    QJsonObject json = stats.toJson();
+    REQUIRE(json["sample_count"].toInt() == 1);
+    REQUIRE(json["caches"].toObject()["frame"].toObject()["hits"].toInt() == 2);
+    REQUIRE(json["caches"].toObject()["onion_skin"].toObject()["misses"].toInt() == 1);
+    REQUIRE(json["stages"].toObject()["layers"].toObject()["max_ms"].toDouble() == Approx(2));
+    REQUIRE(json["samples"].toArray().size() == 1);
+
+    stats.reset();
+    REQUIRE(stats.sampleCount() == 0);
+    REQUIRE(stats.hits(RenderStats::FRAME_CACHE) == 0);
+}
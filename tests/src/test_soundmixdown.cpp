@@ -0,0 +1,80 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "soundmixdown.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+
+TEST_CASE("SoundMixdown::frameToSample")
+{
+    REQUIRE(SoundMixdown::frameToSample(1, 12) == 0);
+    REQUIRE(SoundMixdown::frameToSample(13, 12) == 44100);
+    REQUIRE(SoundMixdown::frameToSample(2, 24) == 1838);
+}
+
+TEST_CASE("SoundMixdown::mix")
+{
+    SoundMixdown mixdown(4);
+
+    SECTION("Overlapping clips are summed")
+    {
+        mixdown.mix({ 0.25f, 0.25f }, 1);
+        mixdown.mix({ 0.5f, 0.5f }, 2);
+        REQUIRE(mixdown.samples() == QVector<float>({ 0.f, 0.25f, 0.75f, 0.5f }));
+    }
+
+    SECTION("Clips are clipped to the mix range")
+    {
+        mixdown.mix({ 1.f, 2.f, 3.f }, -2);
+        mixdown.mix({ 4.f, 5.f }, 3);
+        REQUIRE(mixdown.samples() == QVector<float>({ 3.f, 0.f, 0.f, 4.f }));
+    }
+}
+
+TEST_CASE("SoundMixdown wav round trip")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("mix.wav");
+
+    SoundMixdown mixdown(3);
+    mixdown.mix({ 0.5f, -0.5f, 2.f }, 0);
+    REQUIRE(mixdown.writeWav(filePath).ok());
+
+    QFile file(filePath);
+    REQUIRE(file.open(QFile::ReadOnly));
+    REQUIRE(file.size() == 44 + 3 * 2 * 2);
+
+    QVector<float> samples;
+    REQUIRE(SoundMixdown::decodeWav(file, samples));
+    REQUIRE(samples.size() == 3);
+    REQUIRE(samples[0] == Approx(0.5f).margin(1e-4));
+    REQUIRE(samples[1] == Approx(-0.5f).margin(1e-4));
+    REQUIRE(samples[2] == Approx(1.f).margin(1e-4)); // clamped
+}
+
+TEST_CASE("SoundMixdown::decodeWav rejects other files")
+{
+    QByteArray bytes("ID3 not a wave file");
+    QBuffer buffer(&bytes);
+    REQUIRE(buffer.open(QBuffer::ReadOnly));
+
+    QVector<float> samples;
+    REQUIRE_FALSE(SoundMixdown::decodeWav(buffer, samples));
+}
@@ -0,0 +1,157 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "soundmixdown.h"
+#include "soundmixer.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+namespace
+{
+    QVector<qint16> readLeftChannel(SoundMixer& mixer, int sampleCount)
+    {
+        const QByteArray pcm = mixer.read(sampleCount * 4);
+        QVector<qint16> left;
+        for (int i = 0; i + 4 <= pcm.size(); i += 4)
+        {
+            left.append(qFromLittleEndian<qint16>(pcm.constData() + i));
+        }
+        return left;
+    }
+}
+
+TEST_CASE("SoundMixer mixes clips at their start samples")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("clip.wav");
+
+    SoundMixdown clip(2);
+    clip.mix({ 0.25f, 0.25f }, 0);
+    REQUIRE(clip.writeWav(filePath).ok());
+
+    SoundMixer mixer;
+    REQUIRE(mixer.addClip(filePath, 1));
+    REQUIRE(mixer.addClip(filePath, 2));
+    mixer.waitForDecoding();
+    REQUIRE(mixer.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+
+    SECTION("Overlapping clips are summed")
+    {
+        mixer.setPosition(0);
+        const QVector<qint16> left = readLeftChannel(mixer, 5);
+        REQUIRE(left.size() == 5);
+        REQUIRE(left[0] == 0);
+        REQUIRE(left[1] == Approx(8192).margin(2));
+        REQUIRE(left[2] == Approx(16384).margin(2));
+        REQUIRE(left[3] == Approx(8192).margin(2));
+        REQUIRE(left[4] == 0);
+    }
+
+    SECTION("Reading continues from the set position")
+    {
+        mixer.setPosition(2);
+        REQUIRE(readLeftChannel(mixer, 1)[0] == Approx(16384).margin(2));
+        REQUIRE(readLeftChannel(mixer, 1)[0] == Approx(8192).margin(2));
+    }
+
+    SECTION("Cleared clips are silent")
+    {
+        mixer.clearClips();
+        mixer.setPosition(0);
+        REQUIRE(readLeftChannel(mixer, 4) == QVector<qint16>(4, 0));
+    }
+}
+
+TEST_CASE("SoundMixer::addClip rejects missing files")
+{
+    SoundMixer mixer;
+    REQUIRE_FALSE(mixer.addClip(QString(), 0));
+}
+
+TEST_CASE("SoundMixer::decode hands out the samples of a file")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("clip.wav");
+
+    SoundMixdown clip(2);
+    clip.mix({ 0.25f, 0.5f }, 0);
+    REQUIRE(clip.writeWav(filePath).ok());
+
+    SoundMixer mixer;
+    QStringList decodedFiles;
+    QVector<float> samples;
+    QObject::connect(&mixer, &SoundMixer::decoded, [&](const QString& fileName, const QVector<float>& decoded)
+    {
+        decodedFiles.append(fileName);
+        samples = decoded;
+    });
+    mixer.decode(filePath);
+    mixer.waitForDecoding();
+    REQUIRE(decodedFiles == QStringList(filePath));
+    REQUIRE(samples.size() == 2);
+    REQUIRE(samples[1] == Approx(0.5f).margin(0.001));
+
+    SECTION("Cached samples are handed out right away")
+    {
+        mixer.decode(filePath);
+        REQUIRE(decodedFiles.size() == 2);
+    }
+
+    SECTION("Missing files are handed out as silence")
+    {
+        mixer.decode(dir.filePath("missing.wav"));
+        REQUIRE(decodedFiles.size() == 2);
+        REQUIRE(samples.isEmpty());
+    }
+}
+
+TEST_CASE("SoundMixer decodes a file again once it has changed")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("clip.wav");
+
+    SoundMixdown quiet(1);
+    quiet.mix({ 0.25f }, 0);
+    REQUIRE(quiet.writeWav(filePath).ok());
+
+    SoundMixer mixer;
+    REQUIRE(mixer.addClip(filePath, 0));
+    mixer.waitForDecoding();
+    REQUIRE(mixer.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+    mixer.setPosition(0);
+    REQUIRE(readLeftChannel(mixer, 1)[0] == Approx(8192).margin(2));
+
+    SoundMixdown loud(1);
+    loud.mix({ 0.5f }, 0);
+    REQUIRE(loud.writeWav(filePath).ok());
+    QFile file(filePath);
+    REQUIRE(file.open(QFile::ReadWrite));
+    REQUIRE(file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    file.close();
+
+    mixer.clearClips();
+    REQUIRE(mixer.addClip(filePath, 0));
+    mixer.waitForDecoding();
+    mixer.setPosition(0);
+    REQUIRE(readLeftChannel(mixer, 1)[0] == Approx(16384).margin(2));
+}
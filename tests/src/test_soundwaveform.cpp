@@ -0,0 +1,143 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "soundwaveform.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+namespace
+{
+    QVector<float> testSamples()
+    {
+        // Silence with a single positive spike and a single negative spike
+        QVector<float> samples(10000, 0.f);
+        samples[100] = 1.f;
+        samples[9000] = -0.5f;
+        return samples;
+    }
+}
+
+TEST_CASE("SoundWaveform::build")
+{
+    SoundWaveform waveform;
+    REQUIRE(waveform.isEmpty());
+
+    waveform.build(testSamples());
+    REQUIRE(waveform.sampleCount() == 10000);
+    // 157 peaks, then 40, 10, 3 and 1
+    REQUIRE(waveform.levelCount() == 5);
+}
+
+TEST_CASE("SoundWaveform::peak")
+{
+    SoundWaveform waveform;
+    waveform.build(testSamples());
+
+    SECTION("Ranges with a spike")
+    {
+        REQUIRE(waveform.peak(64, 128).max == 127);
+        REQUIRE(waveform.peak(0, 10000).max == 127);
+        REQUIRE(waveform.peak(0, 10000).min == -64);
+    }
+
+    SECTION("Silent ranges")
+    {
+        REQUIRE(waveform.peak(128, 8960).max == 0);
+        REQUIRE(waveform.peak(128, 8960).min == 0);
+    }
+
+    SECTION("Ranges outside the clip")
+    {
+        REQUIRE(waveform.peak(20000, 30000).max == 0);
+        REQUIRE(waveform.peak(-100, 0).max == 0);
+    }
+}
+
+TEST_CASE("SoundWaveform save and load")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString soundFile = dir.filePath("sound.wav");
+    const QString filePath = SoundWaveform::peakFileName(soundFile);
+
+    QFile sound(soundFile);
+    REQUIRE(sound.open(QFile::WriteOnly));
+    REQUIRE(sound.write(QByteArray(1234, 0)) == 1234);
+    sound.close();
+
+    SoundWaveform waveform;
+    waveform.build(testSamples());
+    REQUIRE(waveform.save(filePath, QFileInfo(soundFile)).ok());
+
+    SECTION("Peaks of the same sound file are read back")
+    {
+        SoundWaveform loaded;
+        REQUIRE(loaded.load(filePath, QFileInfo(soundFile)).ok());
+        REQUIRE(loaded.sampleCount() == waveform.sampleCount());
+        REQUIRE(loaded.levelCount() == waveform.levelCount());
+        REQUIRE(loaded.peak(0, 10000).max == 127);
+        REQUIRE(loaded.peak(0, 10000).min == -64);
+    }
+
+    SECTION("Peaks of a sound file of another size are rejected")
+    {
+        REQUIRE(sound.open(QFile::Append));
+        REQUIRE(sound.write(QByteArray(10, 0)) == 10);
+        sound.close();
+
+        SoundWaveform loaded;
+        REQUIRE_FALSE(loaded.load(filePath, QFileInfo(soundFile)).ok());
+        REQUIRE(loaded.isEmpty());
+    }
+
+    SECTION("Peaks of a sound file modified since are rejected")
+    {
+        REQUIRE(sound.open(QFile::ReadWrite));
+        REQUIRE(sound.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+        sound.close();
+
+        SoundWaveform loaded;
+        REQUIRE_FALSE(loaded.load(filePath, QFileInfo(soundFile)).ok());
+        REQUIRE(loaded.isEmpty());
+    }
+}
+
+TEST_CASE("SoundWaveform::peakFileName")
+{
+    QTemporaryDir dataDir;
+    QTemporaryDir userDir;
+    REQUIRE(dataDir.isValid());
+    REQUIRE(userDir.isValid());
+
+    SECTION("Peaks of project sounds are kept next to them")
+    {
+        const QString soundFile = dataDir.filePath("sound.wav");
+        REQUIRE(SoundWaveform::peakFileName(soundFile, dataDir.path()) == SoundWaveform::peakFileName(soundFile));
+    }
+
+    SECTION("Peaks of other sounds are kept out of their folder")
+    {
+        const QString soundFile = userDir.filePath("sound.wav");
+        const QString peakFile = SoundWaveform::peakFileName(soundFile, dataDir.path());
+        REQUIRE(peakFile.endsWith(".peaks"));
+        REQUIRE_FALSE(peakFile.startsWith(userDir.path()));
+        REQUIRE(peakFile != SoundWaveform::peakFileName(dataDir.filePath("sound.wav"), dataDir.path()));
+    }
+}
@@ -0,0 +1,126 @@
+/*
+
+Pencil2D - Traditional Animation Software
+Copyright (C) 2012-2020 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+#include "catch.hpp"
+
+#include "tracer.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <thread>
+
+namespace
+{
+    QJsonArray durationEvents(const Tracer& tracer)
+    {
+        QJsonArray events;
+        const QJsonArray all = QJsonDocument::fromJson(tracer.toChromeTraceJson()).object()["traceEvents"].toArray();
+        for (const QJsonValue& event : all)
+        {
+            if (event.toObject()["ph"].toString() != "M") { events.append(event); }
+        }
+        return events;
+    }
+}
+
+TEST_CASE("Tracer records begin and end events")
+{
+    Tracer tracer;
+    tracer.begin("io", "save");
+    tracer.begin("frames", "write");
+    tracer.end("frames", "write");
+    tracer.end("io", "save");
+
+    QJsonArray events = durationEvents(tracer);
+    REQUIRE(events.size() == 4);
+    REQUIRE(events[0].toObject()["ph"].toString() == "B");
+    REQUIRE(events[0].toObject()["cat"].toString() == "io");
+    REQUIRE(events[0].toObject()["name"].toString() == "save");
+    REQUIRE(events[1].toObject()["name"].toString() == "write");
+    REQUIRE(events[3].toObject()["ph"].toString() == "E");
+    REQUIRE(events[3].toObject()["ts"].toDouble() >= events[0].toObject()["ts"].toDouble());
+}
+
+TEST_CASE("Tracer keeps the most recent events")
+{
+    Tracer tracer(4);
+    for (int i = 0; i < 3; i++)
+    {
+        tracer.begin("paint", "paint");
+        tracer.end("paint", "paint");
+    }
+    REQUIRE(tracer.eventCount() == 4);
+
+    // Once the begin of "outer" is overwritten, its end alone is not written out
+    tracer.begin("paint", "outer");
+    tracer.begin("paint", "inner");
+    tracer.end("paint", "inner");
+    tracer.end("paint", "outer");
+    tracer.end("paint", "orphan");
+    QJsonArray events = durationEvents(tracer);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].toObject()["name"].toString() == "inner");
+    REQUIRE(events[1].toObject()["ph"].toString() == "E");
+
+    tracer.clear();
+    REQUIRE(tracer.eventCount() == 0);
+}
+
+TEST_CASE("Tracer can be disabled")
+{
+    Tracer tracer;
+    tracer.setEnabled(false);
+    tracer.begin("io", "load");
+    tracer.end("io", "load");
+    REQUIRE(tracer.eventCount() == 0);
+}
+
+TEST_CASE("TRACE_SCOPE records nothing until the tracer is enabled")
+{
+    Tracer& tracer = Tracer::instance();
+    REQUIRE_FALSE(tracer.isEnabled());
+    {
+        TraceScope scope("io", "load");
+        tracer.setEnabled(true); // the end of a scope that began disabled isn't recorded either
+    }
+    REQUIRE(tracer.eventCount() == 0);
+
+    {
+        TraceScope scope("io", "save");
+    }
+    REQUIRE(tracer.eventCount() == 2);
+
+    tracer.setEnabled(false);
+    tracer.clear();
+}
+
+TEST_CASE("Tracer tells threads apart")
+{
+    Tracer tracer;
+    tracer.begin("io", "main");
+    std::thread worker([&tracer]()
+    {
+        tracer.begin("frames", "worker");
+        tracer.end("frames", "worker");
+    });
+    worker.join();
+    tracer.end("io", "main");
+
+    QJsonArray events = durationEvents(tracer);
+    REQUIRE(events.size() == 4);
+    REQUIRE(events[0].toObject()["tid"].toInt() != events[1].toObject()["tid"].toInt());
+    REQUIRE(events[0].toObject()["tid"].toInt() == events[3].toObject()["tid"].toInt());
+}
@@ -1,6 +1,10 @@
 #include "vectorimage.h"
 #include "catch.hpp"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
 TEST_CASE("VectorImage removeColor")
 {
     auto vImage = VectorImage();
@@ -25,3 +29,123 @@ TEST_CASE("VectorImage removeColor")
         REQUIRE(vImage.curve(0).getColorNumber() == 0);
     }
 }
+
+TEST_CASE("VectorImage write and read")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("001.001.vec");
+
+    VectorImage vImage;
+    auto bezier = BezierCurve({ QPoint(50,50), QPoint(100,100), QPoint(150,50) });
+    bezier.setColorNumber(2);
+    bezier.setWidth(3.0);
+    vImage.addCurve(bezier, 1.0);
+    REQUIRE(vImage.write(filePath, "VEC").ok());
+
+    SECTION("Curves are read back")
+    {
+        VectorImage loaded;
+        REQUIRE(loaded.read(filePath));
+        REQUIRE(loaded.getCurveSize(0) == vImage.getCurveSize(0));
+        REQUIRE(loaded.curve(0).getColorNumber() == 2);
+        REQUIRE(loaded.curve(0).getWidth() == 3.0);
+        REQUIRE(loaded.curve(0).getVertex(-1) == vImage.curve(0).getVertex(-1));
+        REQUIRE(loaded.curve(0).getVertex(1) == vImage.curve(0).getVertex(1));
+        REQUIRE_FALSE(loaded.isModified());
+    }
+
+    SECTION("Not a vector image")
+    {
+        QFile file(filePath);
+        REQUIRE(file.open(QFile::WriteOnly));
+        file.write("<!DOCTYPE PencilDocument><document/>");
+        file.close();
+
+        VectorImage loaded;
+        REQUIRE_FALSE(loaded.read(filePath));
+    }
+}
+
+TEST_CASE("VectorImage binary write and read")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString filePath = dir.filePath("001.001.vec");
+
+    VectorImage vImage;
+    auto bezier = BezierCurve({ QPoint(50,50), QPoint(100,100), QPoint(150,50) });
+    bezier.setColorNumber(2);
+    bezier.setWidth(3.0);
+    vImage.addCurve(bezier, 1.0);
+    REQUIRE(vImage.write(filePath, "VECB").ok());
+
+    SECTION("Binary file is smaller than xml")
+    {
+        const QString xmlPath = dir.filePath("001.002.vec");
+        REQUIRE(vImage.write(xmlPath, "VEC").ok());
+        REQUIRE(QFileInfo(filePath).size() < QFileInfo(xmlPath).size());
+    }
+
+    SECTION("Curves are read back")
+    {
+        VectorImage loaded;
+        REQUIRE(loaded.read(filePath));
+        REQUIRE(loaded.getCurveSize(0) == vImage.getCurveSize(0));
+        REQUIRE(loaded.curve(0).getColorNumber() == 2);
+        REQUIRE(loaded.curve(0).getWidth() == 3.0);
+        for (int i = -1; i < vImage.getCurveSize(0); i++)
+        {
+            const QPointF delta = loaded.curve(0).getVertex(i) - vImage.curve(0).getVertex(i);
+            REQUIRE(qAbs(delta.x()) <= 1.0 / 64);
+            REQUIRE(qAbs(delta.y()) <= 1.0 / 64);
+        }
+        REQUIRE_FALSE(loaded.isModified());
+    }
+
+    SECTION("Truncated file")
+    {
+        QFile file(filePath);
+        REQUIRE(file.open(QFile::ReadWrite));
+        REQUIRE(file.resize(file.size() - 4));
+        file.close();
+
+        VectorImage loaded;
+        REQUIRE_FALSE(loaded.read(filePath));
+    }
+}
+
+TEST_CASE("BezierCurve cached paths")
+{
+    BezierCurve curve({ QPointF(0, 0), QPointF(10, 0), QPointF(20, 10) }, false);
+    curve.setWidth(2);
+
+    const QRectF bounds = curve.getBoundingRect();
+    const QPainterPath stroked = curve.getStrokedPath();
+    REQUIRE(curve.getSimplePath() == curve.getSimplePath());
+    REQUIRE(curve.getStrokedPath() == stroked);
+
+    SECTION("Moving a vertex rebuilds them")
+    {
+        curve.setVertex(1, QPointF(20, 40));
+        REQUIRE(curve.getBoundingRect() != bounds);
+        REQUIRE(curve.getBoundingRect().contains(QPointF(20, 40)));
+        REQUIRE(curve.getStrokedPath() != stroked);
+    }
+
+    SECTION("Changing the width rebuilds them")
+    {
+        curve.setWidth(8);
+        REQUIRE(curve.getBoundingRect().width() == Approx(bounds.width() + 6));
+        REQUIRE(curve.getStrokedPath() != stroked);
+    }
+
+    SECTION("Copies keep their own paths")
+    {
+        BezierCurve copy = curve;
+        copy.setSelected(true);
+        copy.transform(QTransform::fromTranslate(5, 5));
+        REQUIRE(copy.getBoundingRect() == bounds.translated(5, 5));
+        REQUIRE(curve.getBoundingRect() == bounds);
+    }
+}
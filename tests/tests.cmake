@@ -19,7 +19,16 @@ set(TEST_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_filemanager.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_bitmapimage.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_bitmapbucket.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_editor.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_gifencoder.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_memoryreport.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_qminiz.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_renderchunks.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_renderstats.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_soundmixdown.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_soundmixer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_soundwaveform.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_tracer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_vectorimage.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_viewmanager.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/tests/src/test_util.cpp
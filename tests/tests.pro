@@ -42,9 +42,18 @@ SOURCES += \
     src/test_filemanager.cpp \
     src/test_bitmapimage.cpp \
     src/test_bitmapbucket.cpp \
+    src/test_editor.cpp \
+    src/test_gifencoder.cpp \
+    src/test_memoryreport.cpp \
     src/test_propertyinfo.cpp \
     src/test_qminiz.cpp \
+    src/test_renderchunks.cpp \
+    src/test_renderstats.cpp \
+    src/test_soundmixdown.cpp \
+    src/test_soundmixer.cpp \
+    src/test_soundwaveform.cpp \
     src/test_toolsettings.cpp \
+    src/test_tracer.cpp \
     src/test_vectorimage.cpp \
     src/test_viewmanager.cpp \
     src/test_util.cpp
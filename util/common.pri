@@ -42,6 +42,9 @@ WIN_LEGACY {
 
 macx: LIBS += -lobjc -framework AppKit
 
+# Build with CONFIG+=NO_TRACE to compile out the trace events
+NO_TRACE: DEFINES += PENCIL2D_NO_TRACE
+
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which as been marked deprecated (the exact warnings
 # depend on your compiler). Please consult the documentation of the